@@ -0,0 +1,360 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wlm/context.h>
+#include <wlm/damage.h>
+#include <wlm/egl/formats.h>
+#include <wlm/egl/shm.h>
+#include <wlm/util.h>
+
+// size of the offscreen window frames are drawn into
+#define WINDOW_WIDTH 1920
+#define WINDOW_HEIGHT 1080
+
+// default time spent on each benchmark case
+#define DEFAULT_DURATION_NS 1000000000ull
+#define WARMUP_FRAMES 3
+
+// damage rectangle used for the partial uploads of the allocation check
+#define ALLOC_CHECK_DAMAGE_X 64
+#define ALLOC_CHECK_DAMAGE_Y 64
+#define ALLOC_CHECK_DAMAGE_SIZE 256
+
+typedef struct {
+    const char * name;
+    uint32_t width;
+    uint32_t height;
+} frame_size_t;
+
+static const frame_size_t frame_sizes[] = {
+    { "1080p", 1920, 1080 },
+    { "1440p", 2560, 1440 },
+    { "4K", 3840, 2160 },
+    { "8K", 7680, 4320 },
+};
+
+typedef struct {
+    const char * name;
+    scale_t scaling;
+} scaling_mode_t;
+
+static const scaling_mode_t scaling_modes[] = {
+    { "fit", SCALE_FIT },
+    { "cover", SCALE_COVER },
+    { "exact", SCALE_EXACT },
+};
+
+typedef struct {
+    GLuint framebuffer;
+    GLuint target_texture;
+    uint64_t duration_ns;
+    uint64_t alloc_check_frames;
+} bench_t;
+
+// --- cleanup ---
+
+void wlm_cleanup(ctx_t * ctx) {
+    wlm_log_debug(ctx, "bench::cleanup(): deallocating resources\n");
+
+    if (ctx->egl.initialized) wlm_egl_cleanup(ctx);
+    wlm_cleanup_opt(ctx);
+}
+
+noreturn void wlm_exit_fail(ctx_t * ctx) {
+    wlm_cleanup(ctx);
+    exit(1);
+}
+
+// --- allocation counting ---
+
+// wlm-bench is linked with --wrap for the allocation functions, so this only
+// counts allocations made by wl-mirror code, not the ones inside GL drivers
+void * __real_malloc(size_t size);
+void * __real_calloc(size_t num, size_t size);
+void * __real_realloc(void * ptr, size_t size);
+
+static bool count_allocations = false;
+static uint64_t num_allocations = 0;
+
+void * __wrap_malloc(size_t size) {
+    if (count_allocations) num_allocations++;
+    return __real_malloc(size);
+}
+
+void * __wrap_calloc(size_t num, size_t size) {
+    if (count_allocations) num_allocations++;
+    return __real_calloc(num, size);
+}
+
+void * __wrap_realloc(void * ptr, size_t size) {
+    if (count_allocations) num_allocations++;
+    return __real_realloc(ptr, size);
+}
+
+// --- helper functions ---
+
+static void format_name(const wlm_egl_format_t * format, char name[5]) {
+    // drm formats are little-endian fourcc codes
+    for (size_t i = 0; i < 4; i++) {
+        char c = (char)((format->drm_format >> (8 * i)) & 0xff);
+        name[i] = c == '\0' ? ' ' : c;
+    }
+    name[4] = '\0';
+}
+
+static bool format_supported(const wlm_egl_format_t * format) {
+    // probe with a small upload, unsupported format and type combinations fail
+    GLuint texture;
+    uint8_t pixels[4 * 4 * 8] = { 0 };
+    while (glGetError() != GL_NO_ERROR) {}
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, format->gl_format, 4, 4, 0, format->gl_format, format->gl_type, pixels);
+    bool supported = glGetError() == GL_NO_ERROR;
+    glDeleteTextures(1, &texture);
+
+    return supported;
+}
+
+static void fill_frame(uint8_t * data, size_t size, uint32_t seed) {
+    // cheap non-constant content, so uploads can't be short-circuited
+    uint32_t state = seed * 2654435761u + 1;
+    for (size_t i = 0; i < size; i++) {
+        state = state * 1664525u + 1013904223u;
+        data[i] = state >> 24;
+    }
+}
+
+// --- benchmark ---
+
+static void draw_frame(ctx_t * ctx, const wlm_egl_format_t * format, const frame_size_t * size, uint32_t stride, uint8_t * data, const wlm_damage_t * damage) {
+    if (!wlm_egl_shm_import(ctx, data, format, size->width, size->height, stride, false, false, damage)) {
+        wlm_log_error("bench::draw_frame(): failed to import frame\n");
+        wlm_exit_fail(ctx);
+    }
+
+    // wait for the GPU, otherwise only command submission is measured
+    wlm_egl_draw_texture(ctx);
+    glFinish();
+}
+
+static void run_case(ctx_t * ctx, bench_t * bench, const wlm_egl_format_t * format, const frame_size_t * size, const scaling_mode_t * mode, uint8_t * data) {
+    uint32_t stride = size->width * (format->bpp / 8);
+    size_t frame_bytes = (size_t)stride * size->height;
+
+    ctx->opt.scaling = mode->scaling;
+    ctx->mirror.current_target->width = size->width;
+    ctx->mirror.current_target->height = size->height;
+    wlm_egl_update_uniforms(ctx);
+
+    // exclude texture allocation and shader warmup
+    for (size_t i = 0; i < WARMUP_FRAMES; i++) {
+        draw_frame(ctx, format, size, stride, data, NULL);
+    }
+
+    uint64_t frames = 0;
+    uint64_t start_ns = wlm_event_now_ns();
+    uint64_t elapsed_ns = 0;
+    while (elapsed_ns < bench->duration_ns) {
+        draw_frame(ctx, format, size, stride, data, NULL);
+        frames++;
+        elapsed_ns = wlm_event_now_ns() - start_ns;
+    }
+
+    double seconds = elapsed_ns / 1e9;
+    double fps = frames / seconds;
+    double mb_per_sec = frames * (double)frame_bytes / seconds / 1e6;
+
+    char name[5];
+    format_name(format, name);
+    printf("%-6s %-6s %-6s %10.1f fps %10.1f MB/s\n", name, size->name, mode->name, fps, mb_per_sec);
+    fflush(stdout);
+}
+
+static bool check_allocations(ctx_t * ctx, bench_t * bench, const wlm_egl_format_t * format, uint8_t * data) {
+    const frame_size_t * size = &frame_sizes[0];
+    uint32_t stride = size->width * (format->bpp / 8);
+
+    // alternate full and partial uploads, like a mirrored desktop does
+    wlm_damage_t damage;
+    wlm_damage_clear(&damage);
+    wlm_damage_add(&damage, ALLOC_CHECK_DAMAGE_X, ALLOC_CHECK_DAMAGE_Y, ALLOC_CHECK_DAMAGE_SIZE, ALLOC_CHECK_DAMAGE_SIZE);
+
+    ctx->opt.scaling = SCALE_FIT;
+    ctx->mirror.current_target->width = size->width;
+    ctx->mirror.current_target->height = size->height;
+    wlm_egl_update_uniforms(ctx);
+
+    // texture and upload buffer allocation is allowed during warmup
+    for (size_t i = 0; i < WARMUP_FRAMES; i++) {
+        draw_frame(ctx, format, size, stride, data, NULL);
+        draw_frame(ctx, format, size, stride, data, &damage);
+    }
+
+    num_allocations = 0;
+    count_allocations = true;
+    for (uint64_t i = 0; i < bench->alloc_check_frames; i++) {
+        draw_frame(ctx, format, size, stride, data, i % 2 == 0 ? NULL : &damage);
+    }
+    count_allocations = false;
+
+    char name[5];
+    format_name(format, name);
+    printf("%-6s %-6s %10" PRIu64 " allocations in %" PRIu64 " frames\n", name, size->name, num_allocations, bench->alloc_check_frames);
+    fflush(stdout);
+
+    return num_allocations == 0;
+}
+
+static void init_framebuffer(ctx_t * ctx, bench_t * bench) {
+    // surfaceless contexts have no default framebuffer, draw into a texture instead
+    glGenTextures(1, &bench->target_texture);
+    glBindTexture(GL_TEXTURE_2D, bench->target_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, WINDOW_WIDTH, WINDOW_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    glGenFramebuffers(1, &bench->framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, bench->framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, bench->target_texture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        wlm_log_error("bench::init_framebuffer(): offscreen framebuffer is incomplete\n");
+        wlm_exit_fail(ctx);
+    }
+}
+
+static void usage(void) {
+    printf("usage: wlm-bench [-v] [-d seconds] [-a frames] [format...]\n");
+    printf("\n");
+    printf("benchmark the shm texture upload and draw path on a surfaceless EGL context\n");
+    printf("\n");
+    printf("options:\n");
+    printf("  -h,   --help             show this help\n");
+    printf("  -v,   --verbose          enable debug logging\n");
+    printf("  -d S, --duration S       time spent on each case in seconds (default 1)\n");
+    printf("  -a N, --alloc-check N    fail if N steady-state frames allocate memory\n");
+    printf("\n");
+    printf("formats are DRM fourcc codes like XR24, all known formats are run by default\n");
+}
+
+int main(int argc, char ** argv) {
+    ctx_t ctx = { 0 };
+    bench_t bench = { .framebuffer = 0, .target_texture = 0, .duration_ns = DEFAULT_DURATION_NS, .alloc_check_frames = 0 };
+    output_list_node_t target = { 0 };
+
+    wlm_opt_init(&ctx);
+
+    // skip program name
+    argv++;
+    argc--;
+
+    while (argc > 0 && argv[0][0] == '-') {
+        if (strcmp(argv[0], "-h") == 0 || strcmp(argv[0], "--help") == 0) {
+            usage();
+            return 0;
+        } else if (strcmp(argv[0], "-v") == 0 || strcmp(argv[0], "--verbose") == 0) {
+            ctx.opt.verbose = true;
+        } else if (strcmp(argv[0], "-d") == 0 || strcmp(argv[0], "--duration") == 0) {
+            char * end = NULL;
+            double seconds = argc < 2 ? 0 : strtod(argv[1], &end);
+            if (argc < 2 || *end != '\0' || seconds <= 0) {
+                wlm_log_error("bench::main(): option %s requires a positive number of seconds\n", argv[0]);
+                return 1;
+            }
+
+            bench.duration_ns = seconds * 1e9;
+            argv++;
+            argc--;
+        } else if (strcmp(argv[0], "-a") == 0 || strcmp(argv[0], "--alloc-check") == 0) {
+            char * end = NULL;
+            unsigned long long frames = argc < 2 ? 0 : strtoull(argv[1], &end, 10);
+            if (argc < 2 || *end != '\0' || frames == 0) {
+                wlm_log_error("bench::main(): option %s requires a positive number of frames\n", argv[0]);
+                return 1;
+            }
+
+            bench.alloc_check_frames = frames;
+            argv++;
+            argc--;
+        } else {
+            wlm_log_error("bench::main(): invalid option %s\n", argv[0]);
+            return 1;
+        }
+
+        argv++;
+        argc--;
+    }
+
+    // no wayland connection, so egl falls back to a surfaceless display
+    ctx.wl.width = WINDOW_WIDTH;
+    ctx.wl.height = WINDOW_HEIGHT;
+    ctx.wl.scale = 1.0;
+    target.transform = WL_OUTPUT_TRANSFORM_NORMAL;
+    ctx.mirror.current_target = &target;
+
+    wlm_log_debug(&ctx, "bench::main(): initializing EGL\n");
+    wlm_egl_init(&ctx);
+    init_framebuffer(&ctx, &bench);
+
+    // allocate the largest frame once, all cases upload from it
+    size_t max_bytes = 0;
+    for (size_t i = 0; wlm_egl_formats_get(i) != NULL; i++) {
+        const wlm_egl_format_t * format = wlm_egl_formats_get(i);
+        const frame_size_t * size = &frame_sizes[ARRAY_LENGTH(frame_sizes) - 1];
+        size_t bytes = (size_t)size->width * size->height * (format->bpp / 8);
+        if (bytes > max_bytes) max_bytes = bytes;
+    }
+
+    uint8_t * data = malloc(max_bytes);
+    if (data == NULL) {
+        wlm_log_error("bench::main(): failed to allocate frame data\n");
+        wlm_exit_fail(&ctx);
+    }
+    fill_frame(data, max_bytes, 1);
+
+    bool allocated = false;
+    if (bench.alloc_check_frames == 0) {
+        printf("%-6s %-6s %-6s %14s %15s\n", "format", "size", "scale", "frame rate", "upload rate");
+    }
+    for (size_t i = 0; wlm_egl_formats_get(i) != NULL; i++) {
+        const wlm_egl_format_t * format = wlm_egl_formats_get(i);
+
+        char name[5];
+        format_name(format, name);
+
+        // only run the selected formats
+        bool selected = argc == 0;
+        for (int j = 0; j < argc; j++) {
+            if (strncmp(argv[j], name, 4) == 0) selected = true;
+        }
+        if (!selected) continue;
+
+        if (!format_supported(format)) {
+            printf("%-6s unsupported by this GL implementation\n", name);
+            continue;
+        }
+
+        if (bench.alloc_check_frames > 0) {
+            if (!check_allocations(&ctx, &bench, format, data)) allocated = true;
+            continue;
+        }
+
+        for (size_t s = 0; s < ARRAY_LENGTH(frame_sizes); s++) {
+            for (size_t m = 0; m < ARRAY_LENGTH(scaling_modes); m++) {
+                run_case(&ctx, &bench, format, &frame_sizes[s], &scaling_modes[m], data);
+            }
+        }
+    }
+
+    free(data);
+    glDeleteFramebuffers(1, &bench.framebuffer);
+    glDeleteTextures(1, &bench.target_texture);
+    wlm_cleanup(&ctx);
+
+    if (allocated) {
+        wlm_log_error("bench::main(): steady-state frames allocated memory\n");
+        return 1;
+    }
+
+    return 0;
+}
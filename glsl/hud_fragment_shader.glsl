@@ -0,0 +1,11 @@
+#version 100
+precision mediump float;
+
+uniform sampler2D uFont;
+varying vec2 vTexCoord;
+varying vec4 vColor;
+
+void main() {
+    float coverage = texture2D(uFont, vTexCoord).r;
+    gl_FragColor = vec4(vColor.rgb, vColor.a * coverage);
+}
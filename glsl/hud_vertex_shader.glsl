@@ -0,0 +1,17 @@
+#version 100
+precision mediump float;
+
+uniform vec2 uScreenSize;
+attribute vec2 aPosition;
+attribute vec2 aTexCoord;
+attribute vec4 aColor;
+varying vec2 vTexCoord;
+varying vec4 vColor;
+
+void main() {
+    // positions are in window pixels with the origin in the top left corner
+    vec2 position = aPosition / uScreenSize * 2.0 - 1.0;
+    gl_Position = vec4(position.x, -position.y, 0.0, 1.0);
+    vTexCoord = aTexCoord;
+    vColor = aColor;
+}
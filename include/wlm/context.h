@@ -8,6 +8,7 @@
 #include <wlm/log.h>
 #include <wlm/options.h>
 #include <wlm/event.h>
+#include <wlm/trace.h>
 #include <wlm/stream.h>
 #include <wlm/wayland.h>
 #include <wlm/egl.h>
@@ -16,6 +17,7 @@
 typedef struct ctx {
     ctx_opt_t opt;
     ctx_event_t event;
+    ctx_trace_t trace;
     ctx_stream_t stream;
     ctx_wl_t wl;
     ctx_egl_t egl;
@@ -0,0 +1,33 @@
+#ifndef WL_MIRROR_DAMAGE_H_
+#define WL_MIRROR_DAMAGE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <wlm/transform.h>
+
+// maximum number of separate damage rectangles per frame
+#define WLM_DAMAGE_MAX_RECTS 8
+
+typedef struct wlm_damage {
+    region_t rects[WLM_DAMAGE_MAX_RECTS];
+    size_t num_rects;
+    bool full;
+} wlm_damage_t;
+
+/// Reset to no damage
+void wlm_damage_clear(wlm_damage_t * damage);
+
+/// Mark the whole frame as damaged
+void wlm_damage_add_full(wlm_damage_t * damage);
+
+/// Add a damage rectangle
+///
+/// Overlapping and adjacent rectangles are merged. If the list is full, the
+/// rectangle is merged with the one whose bounding box grows the least.
+void wlm_damage_add(wlm_damage_t * damage, int32_t x, int32_t y, int32_t width, int32_t height);
+
+/// Check if there is no damage
+bool wlm_damage_is_empty(const wlm_damage_t * damage);
+
+#endif
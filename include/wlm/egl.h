@@ -3,11 +3,14 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <sys/types.h>
 #include <wayland-egl.h>
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#include <wlm/egl/hud.h>
+#include <wlm/egl/pbo.h>
 
 struct ctx;
 
@@ -18,9 +21,9 @@ typedef struct dmabuf {
     uint32_t drm_format;
     size_t planes;
 
-    int * fds;
-    uint32_t * offsets;
-    uint32_t * strides;
+    int fds[MAX_PLANES];
+    uint32_t offsets[MAX_PLANES];
+    uint32_t strides[MAX_PLANES];
     uint64_t modifier;
 } dmabuf_t;
 
@@ -35,6 +38,23 @@ typedef struct {
     dmabuf_format_t * formats;
 } dmabuf_formats_t;
 
+#define WLM_EGL_DMABUF_CACHE_SIZE 8
+typedef struct {
+    EGLImage image;
+    uint64_t last_used;
+
+    // buffer identity
+    uint32_t width;
+    uint32_t height;
+    uint32_t drm_format;
+    size_t planes;
+    dev_t devices[MAX_PLANES];
+    ino_t inodes[MAX_PLANES];
+    uint32_t offsets[MAX_PLANES];
+    uint32_t strides[MAX_PLANES];
+    uint64_t modifier;
+} wlm_egl_dmabuf_cache_entry_t;
+
 typedef struct ctx_egl {
     EGLDisplay display;
     EGLContext context;
@@ -46,14 +66,21 @@ typedef struct ctx_egl {
     PFNGLEGLIMAGETARGETTEXTURE2DOESPROC glEGLImageTargetTexture2DOES;
     PFNEGLQUERYDMABUFFORMATSEXTPROC eglQueryDmaBufFormatsEXT;
     PFNEGLQUERYDMABUFMODIFIERSEXTPROC eglQueryDmaBufModifiersEXT;
+    PFNGLTEXSTORAGE2DPROC glTexStorage2D;
+    int gles_version_major;
 
     // supported dmabuf formats
     dmabuf_formats_t dmabuf_formats;
 
+    // imported dmabuf images
+    wlm_egl_dmabuf_cache_entry_t dmabuf_cache[WLM_EGL_DMABUF_CACHE_SIZE];
+    uint64_t dmabuf_cache_counter;
+
     // texture size
     uint32_t width;
     uint32_t height;
     uint32_t format;
+    uint32_t type;
 
     // gl objects
     GLuint vbo;
@@ -64,21 +91,33 @@ typedef struct ctx_egl {
     GLint texture_transform_uniform;
     GLint invert_colors_uniform;
 
+    // performance overlay
+    ctx_egl_hud_t hud;
+
+    // streaming shm uploads
+    ctx_egl_pbo_t pbo;
+
     // state flags
     bool texture_region_aware;
     bool texture_initialized;
+    bool texture_shm_storage;
+    bool texture_immutable;
+    bool texture_storage_bgra;
+    bool unpack_subimage;
     bool initialized;
 } ctx_egl_t;
 
 void wlm_egl_init(struct ctx * ctx);
 bool wlm_egl_query_dmabuf_formats(struct ctx * ctx);
 bool wlm_egl_check_errors(struct ctx * ctx, const char * msg);
+bool wlm_egl_has_extension(const char * extension);
 
 void wlm_egl_draw_frame(struct ctx * ctx);
 void wlm_egl_draw_texture(struct ctx * ctx);
 void wlm_egl_resize_viewport(struct ctx * ctx);
 void wlm_egl_resize_window(struct ctx * ctx);
 void wlm_egl_update_uniforms(struct ctx * ctx);
+void wlm_egl_reset_texture(struct ctx * ctx);
 void wlm_egl_freeze_framebuffer(struct ctx * ctx);
 
 void wlm_egl_cleanup(struct ctx * ctx);
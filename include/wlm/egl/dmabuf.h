@@ -9,6 +9,16 @@
 typedef struct ctx ctx_t;
 typedef struct wlm_egl_format wlm_egl_format_t;
 
-bool wlm_egl_dmabuf_import(ctx_t * ctx, dmabuf_t * dmabuf, const wlm_egl_format_t * format, bool invert_y, bool region_aware);
+/// Import a dmabuf into the mirror texture
+///
+/// With cache_image, the EGLImage is kept for later imports of the same buffer
+/// until wlm_egl_dmabuf_invalidate() is called. Only cache buffers owned by
+/// wl-mirror, a cached image keeps the buffer alive.
+bool wlm_egl_dmabuf_import(ctx_t * ctx, dmabuf_t * dmabuf, const wlm_egl_format_t * format, bool invert_y, bool region_aware, bool cache_image);
+
+/// Drop the cached EGLImage for a buffer, must be called before its fds are closed
+void wlm_egl_dmabuf_invalidate(ctx_t * ctx, dmabuf_t * dmabuf);
+/// Drop all cached EGLImages
+void wlm_egl_dmabuf_clear_cache(ctx_t * ctx);
 
 #endif
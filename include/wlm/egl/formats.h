@@ -2,6 +2,7 @@
 #define WLM_EGL_FORMATS_H_
 
 #include <stdint.h>
+#include <stddef.h>
 #include <wayland-client-protocol.h>
 #include <GLES2/gl2.h>
 
@@ -38,6 +39,8 @@ typedef struct wlm_egl_format  {
     GLint gl_type;
 } wlm_egl_format_t;
 
+/// Format at index in the format table, NULL past the end
+const wlm_egl_format_t * wlm_egl_formats_get(size_t index);
 const wlm_egl_format_t * wlm_egl_formats_find_shm(enum wl_shm_format shm_format);
 const wlm_egl_format_t * wlm_egl_formats_find_drm(uint32_t drm_format);
 const wlm_egl_format_t * wlm_egl_formats_find_spa(enum spa_video_format spa_format);
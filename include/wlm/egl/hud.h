@@ -0,0 +1,59 @@
+#ifndef WLM_EGL_HUD_H_
+#define WLM_EGL_HUD_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <GLES2/gl2.h>
+
+typedef struct ctx ctx_t;
+
+// number of frame times shown in the graph
+#define WLM_EGL_HUD_GRAPH_SAMPLES 120
+// text lines, graph bars, and background
+#define WLM_EGL_HUD_MAX_QUADS (4 * 48 + WLM_EGL_HUD_GRAPH_SAMPLES + 2)
+
+typedef struct {
+    float x, y;
+    float u, v;
+    float r, g, b, a;
+} wlm_egl_hud_vertex_t;
+
+typedef struct ctx_egl_hud {
+    // gl objects
+    GLuint vbo;
+    GLuint font_texture;
+    GLuint shader_program;
+    GLint screen_size_uniform;
+    GLint font_uniform;
+    uint32_t font_width;
+    uint32_t font_height;
+
+    // vertex data, rebuilt on every draw
+    wlm_egl_hud_vertex_t * vertices;
+    size_t num_vertices;
+
+    // frame rates over the last second
+    uint64_t window_start_ns;
+    uint32_t window_captures;
+    uint32_t window_draws;
+    float capture_fps;
+    float display_fps;
+
+    // time between captured frames
+    uint64_t last_capture_ns;
+    uint64_t frame_times[WLM_EGL_HUD_GRAPH_SAMPLES];
+    size_t next_frame_time;
+
+    bool initialized;
+} ctx_egl_hud_t;
+
+void wlm_egl_hud_init(ctx_t * ctx);
+void wlm_egl_hud_cleanup(ctx_t * ctx);
+
+/// Record a newly captured frame
+void wlm_egl_hud_frame_captured(ctx_t * ctx);
+/// Draw the HUD on top of the mirrored texture, restores the main shader state
+void wlm_egl_hud_draw(ctx_t * ctx);
+
+#endif
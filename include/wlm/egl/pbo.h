@@ -0,0 +1,55 @@
+#ifndef WLM_EGL_PBO_H_
+#define WLM_EGL_PBO_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <GLES3/gl3.h>
+
+typedef struct ctx ctx_t;
+typedef struct wlm_damage wlm_damage_t;
+
+// buffers in flight, the CPU fills one while the GPU reads the other
+#define WLM_EGL_PBO_RING_SIZE 2
+
+typedef struct {
+    GLuint buffer;
+    GLsync fence;
+    // persistent mapping, NULL if the buffer is mapped for each upload
+    void * mapping;
+} wlm_egl_pbo_slot_t;
+
+typedef struct ctx_egl_pbo {
+    // GLES3 functions, loaded at runtime so GLES2-only drivers still work
+    PFNGLMAPBUFFERRANGEPROC glMapBufferRange;
+    PFNGLUNMAPBUFFERPROC glUnmapBuffer;
+    PFNGLFENCESYNCPROC glFenceSync;
+    PFNGLCLIENTWAITSYNCPROC glClientWaitSync;
+    PFNGLDELETESYNCPROC glDeleteSync;
+    // GL_EXT_buffer_storage, NULL if unsupported
+    PFNGLBUFFERSTORAGEEXTPROC glBufferStorageEXT;
+
+    wlm_egl_pbo_slot_t slots[WLM_EGL_PBO_RING_SIZE];
+    size_t next_slot;
+    wlm_egl_pbo_slot_t * current;
+    size_t size;
+
+    bool persistent;
+    bool initialized;
+} ctx_egl_pbo_t;
+
+void wlm_egl_pbo_init(ctx_t * ctx);
+void wlm_egl_pbo_cleanup(ctx_t * ctx);
+
+/// Copy a shm frame into the next pixel unpack buffer and leave it bound
+///
+/// Only the rows covered by damage are copied, damage may be NULL to copy the
+/// whole frame. Uploads then read from offset 0 of the bound buffer. Returns
+/// false if pixel buffers are unavailable and uploads must read from shm_addr.
+bool wlm_egl_pbo_begin(ctx_t * ctx, const void * shm_addr, uint32_t stride, uint32_t height, const wlm_damage_t * damage);
+/// Fence and unbind the pixel unpack buffer after the texture upload
+void wlm_egl_pbo_end(ctx_t * ctx);
+
+#endif
@@ -4,10 +4,24 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <GLES2/gl2.h>
+#include <wlm/wayland/shm.h>
 
 typedef struct ctx ctx_t;
 typedef struct wlm_egl_format wlm_egl_format_t;
+typedef struct wlm_damage wlm_damage_t;
 
-bool wlm_egl_shm_import(ctx_t * ctx, void * addr, const wlm_egl_format_t * format, uint32_t width, uint32_t height, uint32_t stride, bool invert_y, bool region_aware);
+/// Upload a shm buffer into the texture
+///
+/// Only the damaged rectangles are uploaded if the texture already holds the
+/// previous frame with the same size and format. damage may be NULL, in which
+/// case the whole frame is uploaded.
+bool wlm_egl_shm_import(ctx_t * ctx, void * addr, const wlm_egl_format_t * format, uint32_t width, uint32_t height, uint32_t stride, bool invert_y, bool region_aware, const wlm_damage_t * damage);
+
+/// Import a shm buffer without copying, through the udmabuf aliasing it
+///
+/// Returns false if the buffer has no udmabuf or the driver rejects it, the
+/// frame must then be uploaded with wlm_egl_shm_import(). A rejected import
+/// disables udmabufs for all following frames.
+bool wlm_egl_shm_import_udmabuf(ctx_t * ctx, wlm_wayland_shm_handle_t handle, const wlm_egl_format_t * format, bool invert_y, bool region_aware);
 
 #endif
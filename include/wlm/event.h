@@ -2,6 +2,7 @@
 #define WL_MIRROR_EVENT_H_
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include <sys/epoll.h>
 
@@ -12,6 +13,7 @@ typedef struct event_handler {
     int fd;
     int events;
     int timeout_ms;
+    bool is_timer;
     void (*on_event)(struct ctx * ctx, uint32_t events);
     void (*on_each)(struct ctx * ctx);
 } event_handler_t;
@@ -29,6 +31,15 @@ void wlm_event_cleanup(struct ctx * ctx);
 void wlm_event_add_fd(struct ctx * ctx, event_handler_t * handler);
 void wlm_event_change_fd(struct ctx * ctx, event_handler_t * handler);
 void wlm_event_remove_fd(struct ctx * ctx, event_handler_t * handler);
+
+/// Register a timerfd backed handler, on_event is called when the timer expires
+void wlm_event_add_timer(struct ctx * ctx, event_handler_t * handler);
+/// Arm the timer to expire at an absolute CLOCK_MONOTONIC time
+void wlm_event_arm_timer(struct ctx * ctx, event_handler_t * handler, uint64_t deadline_ns);
+void wlm_event_disarm_timer(struct ctx * ctx, event_handler_t * handler);
+void wlm_event_remove_timer(struct ctx * ctx, event_handler_t * handler);
+/// Current CLOCK_MONOTONIC time in nanoseconds
+uint64_t wlm_event_now_ns(void);
 void wlm_event_loop(struct ctx * ctx);
 
 #endif
@@ -6,8 +6,12 @@
 #include <wayland-client-protocol.h>
 #include <wayland-egl.h>
 #include <EGL/egl.h>
+#include <wlm/event.h>
 #include <wlm/transform.h>
 #include <wlm/mirror/backends.h>
+#include <wlm/mirror/timing.h>
+#include <wlm/mirror/stats.h>
+#include <wlm/mirror/cache.h>
 
 struct ctx;
 struct output_list_node;
@@ -18,6 +22,25 @@ struct fallback_backend {
     void (*init)(struct ctx * ctx);
 };
 
+typedef struct mirror_backend_trial {
+    bool active;
+    // index into fallback_backends of the backend on trial
+    size_t index;
+    uint64_t start_ns;
+    // expires when the backend on trial took too long, even if it never produces a frame
+    event_handler_t timer;
+
+    // measurements of the backend on trial
+    size_t frames_seen;
+    size_t frames;
+    size_t failures;
+    uint64_t total_ns;
+
+    // fastest backend so far, score is 0 if none worked
+    size_t best_index;
+    uint64_t best_score_ns;
+} mirror_backend_trial_t;
+
 typedef struct ctx_mirror {
     struct output_list_node * current_target;
     struct wl_callback * frame_callback;
@@ -28,8 +51,29 @@ typedef struct ctx_mirror {
     mirror_backend_t * backend;
     fallback_backend_t * fallback_backends;
     size_t auto_backend_index;
+    // backend loaded from the cache, skipped when falling back after it failed
+    fallback_backend_t * cached_backend;
+    mirror_backend_trial_t backend_trial;
+
+    // capture pacing
+    event_handler_t capture_timer;
+    uint64_t next_capture_ns;
+    uint64_t source_presented_ns;
+
+    // frame timeline and latency tracking
+    ctx_mirror_timing_t timing;
+
+    // counters reported by the stats query
+    ctx_mirror_stats_t stats;
+
+    // last working backend for auto backend modes
+    ctx_mirror_cache_t cache;
 
     // state flags
+    bool capture_pending;
+    bool capture_next;
+    bool capture_scheduled;
+    bool window_frame_done;
     bool initialized;
 } ctx_mirror_t;
 
@@ -40,6 +84,17 @@ void wlm_mirror_output_removed(struct ctx * ctx, struct output_list_node * node)
 void wlm_mirror_update_title(struct ctx * ctx);
 void wlm_mirror_options_updated(struct ctx * ctx);
 
+/// Check if the next capture should start as soon as a frame is ready, before it is imported
+bool wlm_mirror_capture_early(struct ctx * ctx);
+/// Record a capture started by the backend while the previous frame is still being imported
+void wlm_mirror_capture_started(struct ctx * ctx);
+void wlm_mirror_frame_ready(struct ctx * ctx);
+void wlm_mirror_frame_dropped(struct ctx * ctx);
+/// Record a capture that completed without changes, nothing is drawn and the next capture is requested
+void wlm_mirror_frame_unchanged(struct ctx * ctx);
+/// Record the compositor timestamp of a captured frame, used to align captures to the source refresh
+void wlm_mirror_source_presented(struct ctx * ctx, uint32_t sec_hi, uint32_t sec_lo, uint32_t nsec);
+
 void wlm_mirror_backend_fail(struct ctx * ctx);
 void wlm_mirror_cleanup(struct ctx * ctx);
 
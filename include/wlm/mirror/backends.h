@@ -2,13 +2,19 @@
 #define WL_MIRROR_MIRROR_BACKENDS_H_
 
 #include <stddef.h>
+#include <stdbool.h>
 
 struct ctx;
 
 #define MIRROR_BACKEND_FATAL_FAILCOUNT 10
 
 typedef struct mirror_backend {
-    void (*do_capture)(struct ctx * ctx);
+    const char * name;
+
+    // returns true if a capture is in flight after the call
+    // the backend then reports its completion with
+    // wlm_mirror_frame_ready() or wlm_mirror_frame_dropped()
+    bool (*do_capture)(struct ctx * ctx);
     void (*do_cleanup)(struct ctx * ctx);
     void (*on_options_updated)(struct ctx * ctx);
     size_t fail_count;
@@ -0,0 +1,32 @@
+#ifndef WL_MIRROR_MIRROR_CACHE_H_
+#define WL_MIRROR_MIRROR_CACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct ctx;
+
+#define WLM_MIRROR_CACHE_MAX_NAME 32
+
+typedef struct ctx_mirror_cache {
+    // cache file for the current compositor, driver, and backend mode, NULL if unavailable
+    char * path;
+    // backend read from the cache file, empty if there was none
+    char backend[WLM_MIRROR_CACHE_MAX_NAME];
+    bool stored;
+} ctx_mirror_cache_t;
+
+/// Hash a string into an FNV-1a hash, start with WLM_MIRROR_CACHE_HASH_INIT
+#define WLM_MIRROR_CACHE_HASH_INIT 0xcbf29ce484222325ull
+uint64_t wlm_mirror_cache_hash(uint64_t hash, const char * data);
+
+/// Read the cached backend for the given backend mode, e.g. "auto"
+void wlm_mirror_cache_init(struct ctx * ctx, const char * mode);
+void wlm_mirror_cache_cleanup(struct ctx * ctx);
+
+/// Cached backend name, NULL if none was cached
+const char * wlm_mirror_cache_backend(struct ctx * ctx);
+/// Remember a backend that produced a frame, writes at most once per run
+void wlm_mirror_cache_store(struct ctx * ctx, const char * backend);
+
+#endif
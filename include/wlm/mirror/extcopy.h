@@ -2,7 +2,10 @@
 #define WL_MIRROR_MIRROR_EXTCOPY_H_
 
 #include <wlm/mirror.h>
+#include <wlm/damage.h>
 #include <wlm/wayland.h>
+#include <wlm/wayland/shm.h>
+#include <wlm/wayland/dmabuf.h>
 #include <wlm/proto/ext-image-copy-capture-v1.h>
 #include <wlm/proto/ext-image-capture-source-v1.h>
 
@@ -10,6 +13,7 @@ typedef enum {
     STATE_INIT,
     STATE_WAIT_BUFFER_INFO,
     STATE_READY,
+    STATE_WAIT_BUFFER_ALLOCATED,
     STATE_WAIT_READY,
     STATE_CANCELED
     // TODO
@@ -23,6 +27,10 @@ typedef struct {
     struct ext_image_copy_capture_session_v1 * capture_session;
     struct ext_image_copy_capture_frame_v1 * capture_frame;
 
+    // options the capture session was created with
+    struct wl_output * session_output;
+    bool session_show_cursor;
+
     bool has_shm_format;
     bool has_drm_format;
     uint32_t frame_width;
@@ -32,8 +40,22 @@ typedef struct {
     uint32_t frame_drm_format;
     uint64_t * frame_drm_modifiers;
     size_t frame_num_drm_modifiers;
+    size_t frame_drm_modifiers_capacity;
+    wlm_damage_t frame_damage;
+
+    // shm ring buffer the frame is copied into
+    wlm_wayland_shm_handle_t shm_handle;
+    wlm_wayland_shm_handle_t shown_shm_handle;
+
+    // pool DMA-BUF the frame is copied into
+    wlm_wayland_dmabuf_handle_t dmabuf_handle;
+    // pool DMA-BUF currently imported into the texture
+    wlm_wayland_dmabuf_handle_t shown_dmabuf_handle;
 
     extcopy_state_t state;
+    bool capture_queued;
+    // texture holds the previous frame, damage can be applied to it
+    bool damage_tracked;
 } extcopy_mirror_backend_t;
 
 #endif
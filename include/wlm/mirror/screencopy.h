@@ -3,6 +3,9 @@
 
 #include <stdint.h>
 #include <wlm/mirror.h>
+#include <wlm/damage.h>
+#include <wlm/wayland/shm.h>
+#include <wlm/wayland/dmabuf.h>
 #include <wlm/proto/wlr-screencopy-unstable-v1.h>
 #include <wayland-client.h>
 
@@ -30,9 +33,23 @@ typedef struct {
     uint32_t frame_stride;
     uint32_t frame_format;
     uint32_t frame_flags;
+    wlm_damage_t frame_damage;
+    bool frame_with_damage;
+
+    // shm ring buffer the frame is copied into
+    wlm_wayland_shm_handle_t shm_handle;
+    wlm_wayland_shm_handle_t shown_shm_handle;
+
+    // pool DMA-BUF the frame is copied into
+    wlm_wayland_dmabuf_handle_t dmabuf_handle;
+    // pool DMA-BUF currently imported into the texture
+    wlm_wayland_dmabuf_handle_t shown_dmabuf_handle;
 
     // screencopy state flags
     screencopy_state_t state;
+    bool capture_queued;
+    // texture holds the previous frame, damage can be applied to it
+    bool damage_tracked;
 } screencopy_mirror_backend_t;
 
 #endif
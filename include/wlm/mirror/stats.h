@@ -0,0 +1,44 @@
+#ifndef WL_MIRROR_MIRROR_STATS_H_
+#define WL_MIRROR_MIRROR_STATS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct ctx;
+
+typedef struct ctx_mirror_stats {
+    // frame counters
+    uint64_t frames_captured;
+    uint64_t frames_drawn;
+    uint64_t frames_dropped;
+
+    // backend failures
+    size_t fail_count_max;
+    uint64_t backend_fallbacks;
+
+    // texture imports
+    uint64_t imports;
+    uint64_t import_total_ns;
+    uint64_t import_max_ns;
+    uint64_t last_import_ns;
+    uint32_t drm_format;
+
+    // bytes uploaded to the texture from shm buffers
+    uint64_t bytes_uploaded;
+
+    // state at the previous stats query, used for rates
+    uint64_t last_query_ns;
+    uint64_t last_query_bytes;
+} ctx_mirror_stats_t;
+
+void wlm_mirror_stats_init(struct ctx * ctx);
+
+/// Record a successful texture import that started at start_ns
+void wlm_mirror_stats_import(struct ctx * ctx, uint32_t drm_format, uint64_t start_ns, uint64_t bytes_uploaded);
+/// Record the fail count of the current backend
+void wlm_mirror_stats_fail_count(struct ctx * ctx, size_t fail_count);
+
+/// Print a single line of counters to stdout
+void wlm_mirror_stats_print(struct ctx * ctx);
+
+#endif
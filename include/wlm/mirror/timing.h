@@ -0,0 +1,83 @@
+#ifndef WL_MIRROR_MIRROR_TIMING_H_
+#define WL_MIRROR_MIRROR_TIMING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <wlm/proto/presentation-time.h>
+
+struct ctx;
+
+typedef enum {
+    WLM_TIMING_CAPTURE_REQUESTED,
+    WLM_TIMING_BUFFER_READY,
+    WLM_TIMING_IMPORT_DONE,
+    WLM_TIMING_SWAP,
+    WLM_TIMING_PRESENTED,
+    WLM_TIMING_NUM_STAGES
+} wlm_timing_stage_t;
+
+typedef enum {
+    // source output presented the frame -> mirror window presented it
+    WLM_TIMING_LATENCY_SOURCE,
+    // capture requested -> mirror window presented the frame
+    WLM_TIMING_LATENCY_CAPTURE,
+    // mirror window swapped buffers -> compositor presented the frame
+    WLM_TIMING_LATENCY_PRESENT,
+    WLM_TIMING_NUM_LATENCIES
+} wlm_timing_latency_t;
+
+#define WLM_MIRROR_TIMING_MAX_FRAMES 8
+// captures in flight, at most one per shm ring buffer
+#define WLM_MIRROR_TIMING_MAX_CAPTURES 3
+#define WLM_MIRROR_TIMING_SAMPLES 256
+
+typedef struct wlm_mirror_timing_frame {
+    struct ctx * ctx;
+    struct wp_presentation_feedback * feedback;
+    uint64_t source_ns;
+    uint64_t stages[WLM_TIMING_NUM_STAGES];
+} wlm_mirror_timing_frame_t;
+
+typedef struct {
+    uint64_t samples[WLM_MIRROR_TIMING_SAMPLES];
+    size_t num_samples;
+    size_t next_sample;
+} wlm_mirror_timing_samples_t;
+
+typedef struct ctx_mirror_timing {
+    // timelines of the captures in flight, oldest first
+    // - captures complete in the order they were started, like the ring buffers they copy into
+    wlm_mirror_timing_frame_t captures[WLM_MIRROR_TIMING_MAX_CAPTURES];
+    size_t first_capture;
+    size_t num_captures;
+    // frames waiting for presentation feedback
+    wlm_mirror_timing_frame_t frames[WLM_MIRROR_TIMING_MAX_FRAMES];
+    wlm_mirror_timing_frame_t * submitted;
+
+    // rolling latency samples
+    wlm_mirror_timing_samples_t latencies[WLM_TIMING_NUM_LATENCIES];
+    uint64_t last_report_ns;
+} ctx_mirror_timing_t;
+
+void wlm_mirror_timing_init(struct ctx * ctx);
+void wlm_mirror_timing_cleanup(struct ctx * ctx);
+
+/// Record a stage of the oldest capture in flight, WLM_TIMING_CAPTURE_REQUESTED starts a new capture
+void wlm_mirror_timing_mark(struct ctx * ctx, wlm_timing_stage_t stage);
+/// Record the compositor timestamp of the content of the oldest capture in flight
+void wlm_mirror_timing_source(struct ctx * ctx, uint64_t source_ns);
+/// Get the request time of the oldest capture in flight, 0 if unknown
+uint64_t wlm_mirror_timing_requested(struct ctx * ctx);
+/// Forget all captures in flight
+void wlm_mirror_timing_reset(struct ctx * ctx);
+
+/// Request presentation feedback for the next commit, call before drawing the oldest captured frame
+void wlm_mirror_timing_present_begin(struct ctx * ctx);
+/// Record the buffer swap, call after drawing the captured frame
+void wlm_mirror_timing_present_end(struct ctx * ctx);
+
+/// Rolling latency percentile in nanoseconds, returns false if there are no samples
+bool wlm_mirror_timing_percentile(struct ctx * ctx, wlm_timing_latency_t latency, unsigned int percent, uint64_t * value_ns);
+
+#endif
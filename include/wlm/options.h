@@ -21,6 +21,7 @@ typedef enum {
 
 typedef enum {
     BACKEND_AUTO,
+    BACKEND_AUTO_FASTEST,
     BACKEND_EXPORT_DMABUF,
     BACKEND_SCREENCOPY_AUTO,
     BACKEND_SCREENCOPY_SHM,
@@ -30,22 +31,41 @@ typedef enum {
     BACKEND_EXTCOPY_DMABUF,
 } backend_t;
 
+typedef enum {
+    DMABUF_ALLOCATOR_AUTO,
+    DMABUF_ALLOCATOR_GBM,
+    DMABUF_ALLOCATOR_DMA_HEAP,
+} dmabuf_allocator_t;
+
+typedef enum {
+    CAPTURE_RATE_WINDOW,
+    CAPTURE_RATE_SOURCE,
+    CAPTURE_RATE_FIXED,
+} capture_rate_t;
+
 typedef struct ctx_opt {
     bool verbose;
     bool stream;
     bool show_cursor;
     bool invert_colors;
     bool freeze;
+    bool hud;
+    bool idle_capture;
     bool has_region;
     bool fullscreen;
     scale_t scaling;
     scale_filter_t scaling_filter;
     backend_t backend;
+    dmabuf_allocator_t dmabuf_allocator;
+    capture_rate_t capture_rate;
+    uint32_t capture_fps;
+    uint32_t max_fps;
     transform_t transform;
     region_t region;
     char * output;
     char * fullscreen_output;
     char * window_title;
+    char * trace_file;
 } ctx_opt_t;
 
 void wlm_opt_init(struct ctx * ctx);
@@ -53,6 +73,9 @@ void wlm_cleanup_opt(struct ctx * ctx);
 
 bool wlm_opt_parse_scaling(scale_t * scaling, scale_filter_t * scaling_filter, const char * scaling_arg);
 bool wlm_opt_parse_backend(backend_t * backend, const char * backend_arg);
+bool wlm_opt_parse_dmabuf_allocator(dmabuf_allocator_t * dmabuf_allocator, const char * dmabuf_allocator_arg);
+bool wlm_opt_parse_fps(uint32_t * fps, const char * fps_arg);
+bool wlm_opt_parse_capture_rate(capture_rate_t * capture_rate, uint32_t * capture_fps, const char * capture_rate_arg);
 bool wlm_opt_parse_transform(transform_t * transform, const char * transform_arg);
 bool wlm_opt_parse_region(region_t * region, char ** output, const char * region_arg);
 bool wlm_opt_find_output(struct ctx * ctx, struct output_list_node ** output_handle, region_t * region_handle);
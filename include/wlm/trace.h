@@ -0,0 +1,70 @@
+#ifndef WL_MIRROR_TRACE_H_
+#define WL_MIRROR_TRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <wlm/event.h>
+
+struct ctx;
+
+// number of spans buffered between flushes
+#define WLM_TRACE_MAX_SPANS 16384
+// formatted size reserved per span, spans with longer names are truncated
+#define WLM_TRACE_SPAN_SIZE 256
+
+typedef struct {
+    const char * name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+} wlm_trace_span_t;
+
+typedef struct ctx_trace {
+    int fd;
+    int pid;
+    event_handler_t flush_timer;
+
+    // spans recorded since the last flush
+    wlm_trace_span_t * spans;
+    size_t num_spans;
+    size_t dropped_spans;
+    bool first_span;
+
+    // spans are formatted here and written with a single write per flush
+    char * buffer;
+
+    bool enabled;
+    bool initialized;
+} ctx_trace_t;
+
+typedef struct {
+    ctx_trace_t * trace;
+    const char * name;
+    uint64_t start_ns;
+} wlm_trace_scope_t;
+
+void wlm_trace_init(struct ctx * ctx);
+void wlm_trace_cleanup(struct ctx * ctx);
+
+/// Buffer a span, the name must be a string literal
+void wlm_trace_record(ctx_trace_t * trace, const char * name, uint64_t start_ns, uint64_t end_ns);
+
+static inline wlm_trace_scope_t wlm_trace_scope_begin(ctx_trace_t * trace, const char * name) {
+    wlm_trace_scope_t scope = { .trace = trace, .name = name, .start_ns = trace->enabled ? wlm_event_now_ns() : 0 };
+    return scope;
+}
+
+static inline void wlm_trace_scope_end(wlm_trace_scope_t * scope) {
+    if (scope->start_ns == 0) return;
+    wlm_trace_record(scope->trace, scope->name, scope->start_ns, wlm_event_now_ns());
+}
+
+#define WLM_TRACE_CONCAT_(a, b) a##b
+#define WLM_TRACE_CONCAT(a, b) WLM_TRACE_CONCAT_(a, b)
+
+/// Trace the rest of the enclosing block as a span called name
+#define WLM_TRACE_SCOPE(ctx, name) \
+    wlm_trace_scope_t WLM_TRACE_CONCAT(trace_scope_, __LINE__) \
+    __attribute__((cleanup(wlm_trace_scope_end))) = wlm_trace_scope_begin(&(ctx)->trace, name)
+
+#endif
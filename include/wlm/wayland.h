@@ -6,6 +6,7 @@
 #include <wlm/event.h>
 #include <wlm/proto/viewporter.h>
 #include <wlm/proto/fractional-scale-v1.h>
+#include <wlm/proto/presentation-time.h>
 #include <wlm/proto/xdg-shell.h>
 #include <wlm/proto/xdg-output-unstable-v1.h>
 #include <wlm/proto/wlr-export-dmabuf-unstable-v1.h>
@@ -34,6 +35,7 @@ typedef struct output_list_node {
     int32_t width;
     int32_t height;
     int32_t scale;
+    int32_t refresh;
     enum wl_output_transform transform;
 } output_list_node_t;
 
@@ -50,6 +52,8 @@ typedef struct ctx_wl {
 
     struct wl_display * display;
     struct wl_registry * registry;
+    // hash of the advertised globals, identifies the compositor
+    uint64_t globals_hash;
 
     // registry objects
     struct wl_compositor * compositor;
@@ -57,12 +61,17 @@ typedef struct ctx_wl {
     struct wp_fractional_scale_manager_v1 * fractional_scale_manager;
     struct xdg_wm_base * wm_base;
     struct zxdg_output_manager_v1 * output_manager;
+    struct wp_presentation * presentation;
     // registry ids
     uint32_t compositor_id;
     uint32_t viewporter_id;
     uint32_t fractional_scale_manager_id;
     uint32_t wm_base_id;
     uint32_t output_manager_id;
+    uint32_t presentation_id;
+
+    // clock domain of presentation timestamps
+    uint32_t presentation_clock;
 
     // shm and dmabuf objects
     struct wl_shm * shm;
@@ -15,21 +15,101 @@ typedef struct ctx ctx_t;
 
 typedef void wlm_wayland_dmabuf_callback_t(ctx_t * ctx, bool success);
 
+// allocates the memory behind a pool buffer and fills in its planes
+typedef struct wlm_wayland_dmabuf_allocator {
+    const char * name;
+    bool (*alloc)(ctx_t * ctx, dmabuf_t * raw_buffer, uint32_t drm_format, uint32_t width, uint32_t height, uint64_t * modifiers, size_t num_modifiers);
+} wlm_wayland_dmabuf_allocator_t;
+
+#ifdef WITH_GBM
+// number of GBM devices kept open
+#define WLM_WAYLAND_DMABUF_DEVICE_CACHE_SIZE 4
+
+// GBM device opened for a DRM device, kept until exit
+typedef struct {
+    dev_t device;
+    int fd;
+    struct gbm_device * gbm_device;
+} wlm_wayland_dmabuf_device_t;
+#endif
+
+// number of DMA-BUFs kept in the buffer pool
+#define WLM_WAYLAND_DMABUF_POOL_SIZE 4
+
+// identifies one DMA-BUF in the buffer pool
+typedef size_t wlm_wayland_dmabuf_handle_t;
+#define WLM_WAYLAND_DMABUF_INVALID_HANDLE ((wlm_wayland_dmabuf_handle_t)-1)
+
+// one format and modifier pair accepted by the compositor
+typedef struct {
+    uint32_t drm_format;
+    uint64_t modifier;
+    bool scanout;
+} wlm_wayland_dmabuf_feedback_format_t;
+
+// format and modifier pairs of all tranches, in compositor preference order
+typedef struct {
+    wlm_wayland_dmabuf_feedback_format_t * formats;
+    size_t num_formats;
+    size_t capacity;
+} wlm_wayland_dmabuf_feedback_formats_t;
+
+typedef struct ctx_wl_dmabuf_buffer {
+    // wp linux dmabuf objects
+    struct zwp_linux_buffer_params_v1 * buffer_params;
+    struct wl_buffer * buffer;
+    dmabuf_t raw_buffer;
+
+    // callback for pending allocation
+    wlm_wayland_dmabuf_callback_t * alloc_callback;
+    // callback of the current user for failures of immediately created buffers
+    wlm_wayland_dmabuf_callback_t * failed_callback;
+
+    // pool state
+    // - buffers are only reused with the allocator and device they came from
+    const wlm_wayland_dmabuf_allocator_t * allocator;
+    dev_t device;
+    bool explicit_modifier;
+    uint32_t feedback_serial;
+    bool in_use;
+    uint64_t last_used;
+} ctx_wl_dmabuf_buffer_t;
+
 typedef struct ctx_wl_dmabuf {
+    // allocator for new pool buffers, NULL until a device is opened
+    const wlm_wayland_dmabuf_allocator_t * allocator;
+    dev_t device;
+
 #ifdef WITH_GBM
     // libgbm objects
+    // - gbm_device points into the device cache, which is shared by all backends
     struct gbm_device * gbm_device;
+    wlm_wayland_dmabuf_device_t devices[WLM_WAYLAND_DMABUF_DEVICE_CACHE_SIZE];
+    size_t num_devices;
 #endif
 
+    // linux dma-heap for linear buffers, kept open until exit
+    int dma_heap_fd;
+
     // callbacks
     wlm_wayland_dmabuf_callback_t * open_device_callback;
-    wlm_wayland_dmabuf_callback_t * alloc_callback;
 
     // wp linux dmabuf objects
     struct zwp_linux_dmabuf_feedback_v1 * feedback;
-    struct zwp_linux_buffer_params_v1 * buffer_params;
-    struct wl_buffer * buffer;
-    dmabuf_t raw_buffer;
+
+    // default feedback, pending until the next done event
+    // - serial counts done events, 0 until the first feedback arrived
+    void * format_table;
+    size_t format_table_size;
+    dev_t main_device;
+    bool pending_scanout;
+    wlm_wayland_dmabuf_feedback_formats_t pending_formats;
+    wlm_wayland_dmabuf_feedback_formats_t formats;
+    uint32_t feedback_serial;
+
+    // buffer pool
+    ctx_wl_dmabuf_buffer_t buffers[WLM_WAYLAND_DMABUF_POOL_SIZE];
+    uint64_t use_counter;
 
     bool initialized;
 } ctx_wl_dmabuf_t;
@@ -37,35 +117,58 @@ typedef struct ctx_wl_dmabuf {
 void wlm_wayland_dmabuf_init(ctx_t * ctx);
 void wlm_wayland_dmabuf_cleanup(ctx_t * ctx);
 
-/// Open the main GBM Device advertised by linux-dmabuf-v1
+/// Open the main device advertised by linux-dmabuf-v1
 ///
-/// Closes any previously open device or buffers
+/// Waits for the default feedback if it hasn't arrived yet.
 void wlm_wayland_dmabuf_open_main_device(ctx_t * ctx, wlm_wayland_dmabuf_callback_t * cb);
 
-/// Open the passed GBM Device
+/// Open an allocator for the passed device
 ///
-/// Closes any previously open device or buffers
+/// Uses a GBM device for it if available, and falls back to the system
+/// dma-heap, which only allocates linear buffers. --dmabuf-allocator selects
+/// one of them explicitly.
+///
+/// Opened devices are cached until wlm_wayland_dmabuf_cleanup(), so
+/// switching backends reuses them.
 bool wlm_wayland_dmabuf_open_device(ctx_t * ctx, dev_t device);
 
-/// Allocate a DMA-BUF
+/// Acquire a DMA-BUF from the buffer pool
+///
+/// Reuses an idle pool buffer with matching format, size and modifier, or
+/// allocates a new one, evicting the least recently used idle buffer if the
+/// pool is full. modifiers may be NULL, in which case implicit modifiers are used.
 ///
-/// modifiers may be NULL, in which case implicit modifiers are used.
+/// New buffers use the modifiers accepted by the compositor, EGL and the
+/// capture source (modifiers), preferring scanout tranches of the default
+/// feedback. If none of them can be allocated, modifiers is used as is.
 ///
-/// This interface manages only one single DMA-BUF at a time.
-/// Calling this function a second time without deallocating results in an error.
+/// The handle is stored before cb is called. cb is called immediately for
+/// reused buffers and for new buffers created with create_immed, and after
+/// the compositor created the wl_buffer otherwise. Releasing the buffer
+/// before that cancels the callback.
 ///
-/// TODO: Allow managing multiple DMA-BUFs
-void wlm_wayland_dmabuf_alloc(ctx_t * ctx, uint32_t drm_format, uint32_t width, uint32_t height, uint64_t * modifiers, size_t num_modifiers, wlm_wayland_dmabuf_callback_t * cb);
+/// If the compositor rejects a buffer created with create_immed while it is
+/// acquired, the buffer is freed and cb is called with success = false. The
+/// handle is invalid after that, see wlm_wayland_dmabuf_get_raw_buffer().
+///
+/// Returns false without calling cb if no buffer could be acquired.
+bool wlm_wayland_dmabuf_acquire(ctx_t * ctx, uint32_t drm_format, uint32_t width, uint32_t height, uint64_t * modifiers, size_t num_modifiers, wlm_wayland_dmabuf_callback_t * cb, wlm_wayland_dmabuf_handle_t * handle);
 
-/// Deallocate the allocated DMA-BUF
+/// Release a DMA-BUF back to the buffer pool
 ///
-/// TODO: Allow identifying the buffer to be deallocated
-void wlm_wayland_dmabuf_dealloc(ctx_t * ctx);
+/// The buffer stays allocated and can be handed out again by
+/// wlm_wayland_dmabuf_acquire().
+void wlm_wayland_dmabuf_release(ctx_t * ctx, wlm_wayland_dmabuf_handle_t handle);
+
+/// Deallocate all DMA-BUFs in the buffer pool
+void wlm_wayland_dmabuf_clear_pool(ctx_t * ctx);
 
-/// Get the wl_buffer object for the DMA-BUF
-struct wl_buffer * wlm_wayland_dmabuf_get_buffer(ctx_t * ctx);
+/// Get the wl_buffer object for a DMA-BUF
+///
+/// Returns NULL while the wl_buffer is still being created.
+struct wl_buffer * wlm_wayland_dmabuf_get_buffer(ctx_t * ctx, wlm_wayland_dmabuf_handle_t handle);
 
-/// Get the dmabuf_t object for the DMA-BUF
-dmabuf_t * wlm_wayland_dmabuf_get_raw_buffer(ctx_t * ctx);
+/// Get the dmabuf_t object for a DMA-BUF
+dmabuf_t * wlm_wayland_dmabuf_get_raw_buffer(ctx_t * ctx, wlm_wayland_dmabuf_handle_t handle);
 
 #endif
@@ -4,9 +4,26 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <wlm/egl.h>
 
 typedef struct ctx ctx_t;
 
+// number of buffers in the shm buffer ring
+// - one buffer may be shown while one is copied into and one is queued
+#define WLM_WAYLAND_SHM_NUM_BUFFERS 3
+
+// identifies one buffer in the shm buffer ring
+typedef size_t wlm_wayland_shm_handle_t;
+#define WLM_WAYLAND_SHM_INVALID_HANDLE ((wlm_wayland_shm_handle_t)-1)
+
+typedef struct ctx_wl_shm_buffer {
+    // offset of this buffer in the shm pool
+    size_t offset;
+    struct wl_buffer * buffer;
+    // udmabuf aliasing this buffer, no planes if unavailable
+    dmabuf_t dmabuf;
+} ctx_wl_shm_buffer_t;
+
 typedef struct ctx_wl_shm {
     // shm buffer state
     int fd;
@@ -15,7 +32,15 @@ typedef struct ctx_wl_shm {
 
     // wl shm objects
     struct wl_shm_pool * pool;
-    struct wl_buffer * buffer;
+
+    // /dev/udmabuf, for importing shm buffers as dmabufs without copies
+    int udmabuf_fd;
+    bool udmabuf_disabled;
+
+    // buffer ring
+    ctx_wl_shm_buffer_t buffers[WLM_WAYLAND_SHM_NUM_BUFFERS];
+    size_t num_buffers;
+    size_t next_buffer;
 
     bool initialized;
 } ctx_wl_shm_t;
@@ -28,22 +53,43 @@ void wlm_wayland_shm_cleanup(ctx_t * ctx);
 /// Can be called before shm_alloc to initialize a pool and check if shm works.
 bool wlm_wayland_shm_create_pool(ctx_t * ctx);
 
-/// Allocate a shared memory buffer
+/// Allocate a ring of shared memory buffers
 ///
-/// This interface manages only one single shared memory buffer at a time.
+/// All buffers in the ring share the same format and size and are carved
+/// from the single shm pool.
 /// Calling this function a second time without deallocating results in an error.
-///
-/// TODO: Allow managing multiple shared memory buffers
 bool wlm_wayland_shm_alloc(ctx_t * ctx, uint32_t shm_format, uint32_t width, uint32_t height, uint32_t stride);
 
-/// Deallocate the allocated shared memory buffer
-///
-/// TODO: Allow identifying the buffer to be deallocated
+/// Deallocate all buffers in the shared memory buffer ring
 void wlm_wayland_shm_dealloc(ctx_t * ctx);
 
-/// Get the wl_buffer object for the shm buffer
-struct wl_buffer * wlm_wayland_shm_get_buffer(ctx_t * ctx);
+/// Check if the shared memory buffer ring is allocated
+bool wlm_wayland_shm_is_allocated(ctx_t * ctx);
 
-/// Get the mmap addr for the shm buffer
-void * wlm_wayland_shm_get_addr(ctx_t * ctx);
+/// Get the handle of the next buffer in the ring
+///
+/// Buffers are handed out round-robin, so a buffer is reused only after all
+/// other buffers in the ring have been handed out. The shown buffer is skipped,
+/// pass WLM_WAYLAND_SHM_INVALID_HANDLE if no buffer is shown.
+wlm_wayland_shm_handle_t wlm_wayland_shm_next_buffer(ctx_t * ctx, wlm_wayland_shm_handle_t shown);
+
+/// Get the wl_buffer object for a shm buffer
+struct wl_buffer * wlm_wayland_shm_get_buffer(ctx_t * ctx, wlm_wayland_shm_handle_t handle);
+
+/// Get the mmap addr for a shm buffer
+///
+/// The addr is only valid until the next call to wlm_wayland_shm_alloc().
+void * wlm_wayland_shm_get_addr(ctx_t * ctx, wlm_wayland_shm_handle_t handle);
+
+/// Get a linear dmabuf aliasing the memory of a shm buffer, NULL if unavailable
+///
+/// The dmabuf is owned by the buffer ring and only valid until the next call to
+/// wlm_wayland_shm_dealloc().
+dmabuf_t * wlm_wayland_shm_get_dmabuf(ctx_t * ctx, wlm_wayland_shm_handle_t handle);
+
+/// Stop creating dmabufs for shm buffers, e.g. after the driver rejected them
+///
+/// Dmabufs of the current ring are no longer handed out, but stay open until
+/// the ring is deallocated.
+void wlm_wayland_shm_disable_dmabuf(ctx_t * ctx);
 #endif
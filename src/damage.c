@@ -0,0 +1,89 @@
+#include <wlm/damage.h>
+
+// --- helper functions ---
+
+static int64_t region_area(const region_t * region) {
+    return (int64_t)region->width * region->height;
+}
+
+static region_t region_union(const region_t * a, const region_t * b) {
+    int32_t x1 = a->x < b->x ? a->x : b->x;
+    int32_t y1 = a->y < b->y ? a->y : b->y;
+    int32_t x2 = a->x + a->width > b->x + b->width ? a->x + a->width : b->x + b->width;
+    int32_t y2 = a->y + a->height > b->y + b->height ? a->y + a->height : b->y + b->height;
+
+    region_t result = { .x = x1, .y = y1, .width = x2 - x1, .height = y2 - y1 };
+    return result;
+}
+
+static bool regions_touch(const region_t * a, const region_t * b) {
+    return
+        a->x <= b->x + b->width && b->x <= a->x + a->width &&
+        a->y <= b->y + b->height && b->y <= a->y + a->height;
+}
+
+static void remove_rect(wlm_damage_t * damage, size_t index) {
+    damage->rects[index] = damage->rects[damage->num_rects - 1];
+    damage->num_rects--;
+}
+
+// --- wlm_damage_clear ---
+
+void wlm_damage_clear(wlm_damage_t * damage) {
+    damage->num_rects = 0;
+    damage->full = false;
+}
+
+// --- wlm_damage_add_full ---
+
+void wlm_damage_add_full(wlm_damage_t * damage) {
+    damage->num_rects = 0;
+    damage->full = true;
+}
+
+// --- wlm_damage_add ---
+
+void wlm_damage_add(wlm_damage_t * damage, int32_t x, int32_t y, int32_t width, int32_t height) {
+    if (damage->full) return;
+    if (width <= 0 || height <= 0) return;
+
+    region_t rect = { .x = x, .y = y, .width = width, .height = height };
+    while (true) {
+        // merge with touching rect
+        bool merged = false;
+        for (size_t i = 0; i < damage->num_rects; i++) {
+            if (!regions_touch(&damage->rects[i], &rect)) continue;
+
+            rect = region_union(&damage->rects[i], &rect);
+            remove_rect(damage, i);
+            merged = true;
+            break;
+        }
+
+        if (merged) continue;
+        if (damage->num_rects < WLM_DAMAGE_MAX_RECTS) break;
+
+        // list full, merge with rect whose bounding box grows the least
+        size_t best = 0;
+        int64_t best_growth = INT64_MAX;
+        for (size_t i = 0; i < damage->num_rects; i++) {
+            region_t merged_rect = region_union(&damage->rects[i], &rect);
+            int64_t growth = region_area(&merged_rect) - region_area(&damage->rects[i]);
+            if (growth < best_growth) {
+                best = i;
+                best_growth = growth;
+            }
+        }
+
+        rect = region_union(&damage->rects[best], &rect);
+        remove_rect(damage, best);
+    }
+
+    damage->rects[damage->num_rects++] = rect;
+}
+
+// --- wlm_damage_is_empty ---
+
+bool wlm_damage_is_empty(const wlm_damage_t * damage) {
+    return !damage->full && damage->num_rects == 0;
+}
@@ -7,11 +7,18 @@
 #include <string.h>
 #include <wlm/context.h>
 #include <wlm/egl.h>
+#include <wlm/egl/dmabuf.h>
+#include <wlm/egl/hud.h>
+#include <wlm/egl/pbo.h>
 #include <wlm/transform.h>
 #include <wlm/util.h>
 #include <wlm/glsl/vertex_shader.h>
 #include <wlm/glsl/fragment_shader.h>
 
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
 // --- buffers ---
 
 static const float vertex_array[] = {
@@ -25,7 +32,7 @@ static const float vertex_array[] = {
 
 // --- has_extension ---
 
-static bool has_extension(const char * extension) {
+bool wlm_egl_has_extension(const char * extension) {
     size_t ext_len = strlen(extension);
 
     // try to find extension in extension list
@@ -42,6 +49,19 @@ static bool has_extension(const char * extension) {
     return found;
 }
 
+// --- set_scaling_filter ---
+
+static void set_scaling_filter(ctx_t * ctx, GLuint texture) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    if (ctx->opt.scaling_filter == SCALE_FILTER_LINEAR) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    } else {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+}
+
 // --- init_egl ---
 
 void wlm_egl_init(ctx_t * ctx) {
@@ -55,13 +75,23 @@ void wlm_egl_init(ctx_t * ctx) {
     ctx->egl.glEGLImageTargetTexture2DOES = NULL;
     ctx->egl.eglQueryDmaBufFormatsEXT = NULL;
     ctx->egl.eglQueryDmaBufModifiersEXT = NULL;
+    ctx->egl.glTexStorage2D = NULL;
+    ctx->egl.gles_version_major = 2;
 
     ctx->egl.dmabuf_formats.num_formats = 0;
     ctx->egl.dmabuf_formats.formats = NULL;
 
+    for (size_t i = 0; i < WLM_EGL_DMABUF_CACHE_SIZE; i++) {
+        ctx->egl.dmabuf_cache[i].image = EGL_NO_IMAGE;
+        ctx->egl.dmabuf_cache[i].last_used = 0;
+        ctx->egl.dmabuf_cache[i].planes = 0;
+    }
+    ctx->egl.dmabuf_cache_counter = 0;
+
     ctx->egl.width = 1;
     ctx->egl.height = 1;
     ctx->egl.format = 0;
+    ctx->egl.type = 0;
 
     ctx->egl.vbo = 0;
     ctx->egl.texture = 0;
@@ -73,10 +103,20 @@ void wlm_egl_init(ctx_t * ctx) {
 
     ctx->egl.texture_region_aware = false;
     ctx->egl.texture_initialized = false;
+    ctx->egl.texture_shm_storage = false;
+    ctx->egl.texture_immutable = false;
+    ctx->egl.texture_storage_bgra = false;
+    ctx->egl.unpack_subimage = false;
     ctx->egl.initialized = true;
 
     // create egl display
-    ctx->egl.display = eglGetDisplay((EGLNativeDisplayType)ctx->wl.display);
+    // - without a wayland connection, render offscreen on a surfaceless display (used by wlm-bench)
+    bool headless = ctx->wl.display == NULL;
+    if (!headless) {
+        ctx->egl.display = eglGetDisplay((EGLNativeDisplayType)ctx->wl.display);
+    } else {
+        ctx->egl.display = eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
     if (ctx->egl.display == EGL_NO_DISPLAY) {
         wlm_log_error("egl::init(): failed to create EGL display\n");
         wlm_exit_fail(ctx);
@@ -91,12 +131,12 @@ void wlm_egl_init(ctx_t * ctx) {
     wlm_log_debug(ctx, "egl::init(): initialized EGL %d.%d\n", major, minor);
 
     // find an egl config with
-    // - window support
+    // - window support, unless headless
     // - OpenGL ES 2.0 support
     // - RGB888 texture support
     EGLint num_configs;
     EGLint config_attribs[] = {
-        EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+        EGL_SURFACE_TYPE, headless ? 0 : EGL_WINDOW_BIT,
         EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
         EGL_RED_SIZE, 8,
         EGL_GREEN_SIZE, 8,
@@ -112,23 +152,30 @@ void wlm_egl_init(ctx_t * ctx) {
     if (ctx->wl.width == 0) ctx->wl.width = 100;
     if (ctx->wl.height == 0) ctx->wl.height = 100;
 
-    // create egl window
-    ctx->egl.window = wl_egl_window_create(ctx->wl.surface, ctx->wl.width, ctx->wl.height);
-    if (ctx->egl.window == EGL_NO_SURFACE) {
-        wlm_log_error("egl::init(): failed to create EGL window\n");
-        wlm_exit_fail(ctx);
-    }
+    if (!headless) {
+        // create egl window
+        ctx->egl.window = wl_egl_window_create(ctx->wl.surface, ctx->wl.width, ctx->wl.height);
+        if (ctx->egl.window == EGL_NO_SURFACE) {
+            wlm_log_error("egl::init(): failed to create EGL window\n");
+            wlm_exit_fail(ctx);
+        }
 
-    // create egl surface
-    ctx->egl.surface = eglCreateWindowSurface(ctx->egl.display, ctx->egl.config, (EGLNativeWindowType)ctx->egl.window, NULL);
+        // create egl surface
+        ctx->egl.surface = eglCreateWindowSurface(ctx->egl.display, ctx->egl.config, (EGLNativeWindowType)ctx->egl.window, NULL);
+    }
 
-    // create egl context with support for OpenGL ES 2.0
+    // create egl context with support for OpenGL ES 3.0 or OpenGL ES 2.0
+    // - OpenGL ES 3.0 enables streaming shm uploads through pixel buffers
     EGLint context_attribs[] = {
-        EGL_CONTEXT_MAJOR_VERSION, 2,
+        EGL_CONTEXT_MAJOR_VERSION, 3,
         EGL_CONTEXT_MINOR_VERSION, 0,
         EGL_NONE
     };
     ctx->egl.context = eglCreateContext(ctx->egl.display, ctx->egl.config, EGL_NO_CONTEXT, context_attribs);
+    if (ctx->egl.context == EGL_NO_CONTEXT) {
+        context_attribs[1] = 2;
+        ctx->egl.context = eglCreateContext(ctx->egl.display, ctx->egl.config, EGL_NO_CONTEXT, context_attribs);
+    }
     if (ctx->egl.context == EGL_NO_CONTEXT) {
         wlm_log_error("egl::init(): failed to create EGL context\n");
         wlm_exit_fail(ctx);
@@ -142,7 +189,7 @@ void wlm_egl_init(ctx_t * ctx) {
 
     // check for needed extensions
     // - GL_OES_EGL_image: for converting EGLImages to GL textures
-    if (!has_extension("GL_OES_EGL_image")) {
+    if (!wlm_egl_has_extension("GL_OES_EGL_image")) {
         wlm_log_error("egl::init(): missing EGL extension GL_OES_EGL_image\n");
         wlm_exit_fail(ctx);
     }
@@ -155,6 +202,26 @@ void wlm_egl_init(ctx_t * ctx) {
         wlm_exit_fail(ctx);
     }
 
+    // get OpenGL ES version, the context may be newer than requested
+    const char * version = (const char *)glGetString(GL_VERSION);
+    if (version == NULL || sscanf(version, "OpenGL ES %d.", &ctx->egl.gles_version_major) != 1) {
+        ctx->egl.gles_version_major = 2;
+    }
+    wlm_log_debug(ctx, "egl::init(): using %s\n", version == NULL ? "unknown OpenGL ES version" : version);
+
+    // get pointers to optional functions
+    // - glTexStorage2D: for immutable shm texture storage (OpenGL ES 3.0)
+    // - GL_EXT_texture_storage: for immutable BGRA texture storage
+    if (ctx->egl.gles_version_major >= 3) {
+        ctx->egl.glTexStorage2D = (PFNGLTEXSTORAGE2DPROC)eglGetProcAddress("glTexStorage2D");
+        ctx->egl.texture_storage_bgra = wlm_egl_has_extension("GL_EXT_texture_storage") &&
+            wlm_egl_has_extension("GL_EXT_texture_format_BGRA8888");
+    }
+
+    // check for unpack skip parameters
+    // - GL_EXT_unpack_subimage: for uploading damaged regions only (core in OpenGL ES 3.0)
+    ctx->egl.unpack_subimage = ctx->egl.gles_version_major >= 3 || wlm_egl_has_extension("GL_EXT_unpack_subimage");
+
     // query dmabuf formats
     if (!wlm_egl_query_dmabuf_formats(ctx)) {
         wlm_log_warn("egl::init(): can't list dmabuf modifiers, this might affect some dmabuf backends\n");
@@ -167,25 +234,11 @@ void wlm_egl_init(ctx_t * ctx) {
 
     // create texture and set scaling mode
     glGenTextures(1, &ctx->egl.texture);
-    glBindTexture(GL_TEXTURE_2D, ctx->egl.texture);
-    if (ctx->opt.scaling_filter == SCALE_FILTER_LINEAR) {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    } else {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    }
+    set_scaling_filter(ctx, ctx->egl.texture);
 
     // create freeze texture and set scaling mode
     glGenTextures(1, &ctx->egl.freeze_texture);
-    glBindTexture(GL_TEXTURE_2D, ctx->egl.freeze_texture);
-    if (ctx->opt.scaling_filter == SCALE_FILTER_LINEAR) {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    } else {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    }
+    set_scaling_filter(ctx, ctx->egl.freeze_texture);
 
     // create freeze framebuffer
     glGenFramebuffers(1, &ctx->egl.freeze_framebuffer);
@@ -262,12 +315,18 @@ void wlm_egl_init(ctx_t * ctx) {
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof (float), (void *)(2 * sizeof (float)));
     glEnableVertexAttribArray(0);
     glEnableVertexAttribArray(1);
+
+    // create HUD objects
+    wlm_egl_hud_init(ctx);
+
+    // create pixel buffers for shm uploads, if supported
+    wlm_egl_pbo_init(ctx);
 }
 
 // --- query_dmabuf_formats ---
 
 bool wlm_egl_query_dmabuf_formats(ctx_t * ctx) {
-    //if (!has_extension("EGL_EXT_image_dma_buf_import_modifiers")) {
+    //if (!wlm_egl_has_extension("EGL_EXT_image_dma_buf_import_modifiers")) {
     //    wlm_log_error("egl::init(): missing EGL extension EGL_EXT_image_dma_buf_import_modifiers\n");
     //    return false;
     //}
@@ -322,14 +381,18 @@ bool wlm_egl_query_dmabuf_formats(ctx_t * ctx) {
         }
 
         EGLuint64KHR * egl_drm_modifiers = calloc(num_modifiers, sizeof *egl_drm_modifiers);
-        if (egl_drm_modifiers == NULL) {
+        EGLBoolean * egl_external_only = calloc(num_modifiers, sizeof *egl_external_only);
+        if (egl_drm_modifiers == NULL || egl_external_only == NULL) {
+            free(egl_drm_modifiers);
+            free(egl_external_only);
             wlm_log_error("egl::init(): failed to allocate egl dmabuf format modifier array for format %x\n", egl_drm_formats[i]);
             success = false;
             break;
         }
 
-        if (!ctx->egl.eglQueryDmaBufModifiersEXT(ctx->egl.display, egl_drm_formats[i], 0, (EGLuint64KHR*)egl_drm_modifiers, NULL, &num_modifiers)) {
+        if (!ctx->egl.eglQueryDmaBufModifiersEXT(ctx->egl.display, egl_drm_formats[i], num_modifiers, (EGLuint64KHR*)egl_drm_modifiers, egl_external_only, &num_modifiers)) {
             free(egl_drm_modifiers);
+            free(egl_external_only);
             wlm_log_error("egl::init(): failed query egl dmabuf format modifiers for format %x\n", egl_drm_formats[i]);
             success = false;
             break;
@@ -338,20 +401,25 @@ bool wlm_egl_query_dmabuf_formats(ctx_t * ctx) {
         uint64_t * modifiers = calloc(num_modifiers, sizeof *modifiers);
         if (modifiers == NULL) {
             free(egl_drm_modifiers);
+            free(egl_external_only);
             wlm_log_error("egl::init(): failed to allocate modifier array for format %x\n", egl_drm_formats[i]);
             success = false;
             break;
         }
 
+        // external-only modifiers can't be bound to GL_TEXTURE_2D
+        size_t num_texture_modifiers = 0;
         for (size_t j = 0; j < (size_t)num_modifiers; j++) {
-            modifiers[j] = egl_drm_modifiers[j];
+            if (egl_external_only[j]) continue;
+            modifiers[num_texture_modifiers++] = egl_drm_modifiers[j];
         }
 
         dmabuf_formats[i].drm_format = egl_drm_formats[i];
-        dmabuf_formats[i].num_modifiers = num_modifiers;
+        dmabuf_formats[i].num_modifiers = num_texture_modifiers;
         dmabuf_formats[i].modifiers = modifiers;
 
         free(egl_drm_modifiers);
+        free(egl_external_only);
     }
 
     free(egl_drm_formats);
@@ -388,8 +456,10 @@ bool wlm_egl_check_errors(struct ctx * ctx, const char * msg) {
 // --- draw_frame ---
 
 void wlm_egl_draw_frame(struct ctx * ctx) {
+    WLM_TRACE_SCOPE(ctx, "egl::draw_frame");
     // render frame, set swap interval to 0 to ensure nonblocking buffer swap
     wlm_egl_draw_texture(ctx);
+    if (ctx->opt.hud) wlm_egl_hud_draw(ctx);
     eglSwapInterval(ctx->egl.display, 0);
     if (eglSwapBuffers(ctx->egl.display, ctx->egl.surface) != EGL_TRUE) {
         wlm_log_error("egl::draw_frame(): failed to swap buffers\n");
@@ -543,23 +613,27 @@ void wlm_egl_update_uniforms(ctx_t * ctx) {
     glUniform1i(ctx->egl.invert_colors_uniform, invert_colors);
 
     // set texture scaling mode
-    glBindTexture(GL_TEXTURE_2D, ctx->egl.texture);
-    if (ctx->opt.scaling_filter == SCALE_FILTER_LINEAR) {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    } else {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    }
+    set_scaling_filter(ctx, ctx->egl.texture);
+    set_scaling_filter(ctx, ctx->egl.freeze_texture);
+}
 
-    glBindTexture(GL_TEXTURE_2D, ctx->egl.freeze_texture);
-    if (ctx->opt.scaling_filter == SCALE_FILTER_LINEAR) {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    } else {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    }
+// --- reset_texture ---
+
+void wlm_egl_reset_texture(ctx_t * ctx) {
+    // immutable storage can't be respecified, replace the texture object instead
+    glDeleteTextures(1, &ctx->egl.texture);
+    glGenTextures(1, &ctx->egl.texture);
+    set_scaling_filter(ctx, ctx->egl.texture);
+
+    // reattach to the freeze framebuffer, keeping the current draw target bound
+    GLint framebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, ctx->egl.freeze_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ctx->egl.texture, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    ctx->egl.texture_immutable = false;
+    ctx->egl.texture_shm_storage = false;
 }
 
 // --- freeze_framebuffer ---
@@ -581,6 +655,10 @@ void wlm_egl_cleanup(ctx_t *ctx) {
 
     wlm_log_debug(ctx, "egl::cleanup(): destroying EGL objects\n");
 
+    wlm_egl_dmabuf_clear_cache(ctx);
+    wlm_egl_hud_cleanup(ctx);
+    wlm_egl_pbo_cleanup(ctx);
+
     if (ctx->egl.dmabuf_formats.formats != NULL) {
         for (size_t i = 0; i < ctx->egl.dmabuf_formats.num_formats; i++) {
             if (ctx->egl.dmabuf_formats.formats[i].modifiers != NULL) {
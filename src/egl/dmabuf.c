@@ -3,6 +3,7 @@
 #include <wlm/egl/formats.h>
 #include <wlm/util.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 
 static const EGLAttrib fd_attribs[] = {
     EGL_DMA_BUF_PLANE0_FD_EXT,
@@ -44,19 +45,52 @@ static const EGLAttrib modifier_high_attribs[] = {
 };
 _Static_assert(ARRAY_LENGTH(modifier_high_attribs) == MAX_PLANES, "modifier_high_attribs has incorrect length");
 
-bool wlm_egl_dmabuf_import(ctx_t * ctx, dmabuf_t * dmabuf, const wlm_egl_format_t * format, bool invert_y, bool region_aware) {
-    if (dmabuf->planes > MAX_PLANES) {
-        wlm_log_error("egl::dmabuf::import(): too many planes, got %zd, can support at most %d\n", dmabuf->planes, MAX_PLANES);
-        return false;
+// --- image cache ---
+
+static bool get_identity(dmabuf_t * dmabuf, wlm_egl_dmabuf_cache_entry_t * identity) {
+    // identify buffers by the dmabuf inode, fd numbers get reused
+    for (size_t i = 0; i < dmabuf->planes; i++) {
+        struct stat buf_stat;
+        if (fstat(dmabuf->fds[i], &buf_stat) != 0) return false;
+
+        identity->devices[i] = buf_stat.st_dev;
+        identity->inodes[i] = buf_stat.st_ino;
+        identity->offsets[i] = dmabuf->offsets[i];
+        identity->strides[i] = dmabuf->strides[i];
     }
 
-    int i = 0;
-    EGLAttrib * image_attribs = calloc((6 + 10 * dmabuf->planes + 1), sizeof (EGLAttrib));
-    if (image_attribs == NULL) {
-        wlm_log_error("egl::dmabuf::import(): failed to allocate EGL image attribs\n");
-        return false;
+    identity->width = dmabuf->width;
+    identity->height = dmabuf->height;
+    identity->drm_format = dmabuf->drm_format;
+    identity->planes = dmabuf->planes;
+    identity->modifier = dmabuf->modifier;
+    return true;
+}
+
+static bool identity_matches(wlm_egl_dmabuf_cache_entry_t * entry, wlm_egl_dmabuf_cache_entry_t * identity) {
+    if (entry->image == EGL_NO_IMAGE) return false;
+    if (entry->width != identity->width || entry->height != identity->height) return false;
+    if (entry->drm_format != identity->drm_format || entry->modifier != identity->modifier) return false;
+    if (entry->planes != identity->planes) return false;
+
+    for (size_t i = 0; i < identity->planes; i++) {
+        if (entry->devices[i] != identity->devices[i] || entry->inodes[i] != identity->inodes[i]) return false;
+        if (entry->offsets[i] != identity->offsets[i] || entry->strides[i] != identity->strides[i]) return false;
     }
 
+    return true;
+}
+
+static void destroy_entry(ctx_t * ctx, wlm_egl_dmabuf_cache_entry_t * entry) {
+    if (entry->image != EGL_NO_IMAGE) eglDestroyImage(ctx->egl.display, entry->image);
+    entry->image = EGL_NO_IMAGE;
+    entry->last_used = 0;
+    entry->planes = 0;
+}
+
+static EGLImage create_image(ctx_t * ctx, dmabuf_t * dmabuf) {
+    int i = 0;
+    EGLAttrib image_attribs[6 + 10 * MAX_PLANES + 1];
     image_attribs[i++] = EGL_WIDTH;
     image_attribs[i++] = dmabuf->width;
     image_attribs[i++] = EGL_HEIGHT;
@@ -80,24 +114,79 @@ bool wlm_egl_dmabuf_import(ctx_t * ctx, dmabuf_t * dmabuf, const wlm_egl_format_
     image_attribs[i++] = EGL_NONE;
 
     // create EGLImage from dmabuf with attribute array
-    EGLImage frame_image = eglCreateImage(ctx->egl.display, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT, NULL, image_attribs);
-    free(image_attribs);
+    EGLImage image = eglCreateImage(ctx->egl.display, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT, NULL, image_attribs);
+
+    if (image == EGL_NO_IMAGE) {
+        wlm_log_error("egl::dmabuf::create_image(): failed to create EGL image from DMA-BUF: error = %x\n", eglGetError());
+    }
+
+    return image;
+}
 
-    if (frame_image == EGL_NO_IMAGE) {
-        wlm_log_error("egl::dmabuf::import(): failed to create EGL image from DMA-BUF: error = %x\n", eglGetError());
+// --- wlm_egl_dmabuf_import ---
+
+bool wlm_egl_dmabuf_import(ctx_t * ctx, dmabuf_t * dmabuf, const wlm_egl_format_t * format, bool invert_y, bool region_aware, bool cache_image) {
+    WLM_TRACE_SCOPE(ctx, "egl::dmabuf::import");
+    uint64_t start_ns = wlm_event_now_ns();
+
+    if (dmabuf->planes > MAX_PLANES) {
+        wlm_log_error("egl::dmabuf::import(): too many planes, got %zd, can support at most %d\n", dmabuf->planes, MAX_PLANES);
         return false;
     }
 
+    wlm_egl_dmabuf_cache_entry_t identity;
+    bool cacheable = cache_image && get_identity(dmabuf, &identity);
+
+    // look up image in cache, otherwise pick the least recently used slot
+    wlm_egl_dmabuf_cache_entry_t * entry = NULL;
+    if (cacheable) {
+        for (size_t i = 0; i < WLM_EGL_DMABUF_CACHE_SIZE; i++) {
+            wlm_egl_dmabuf_cache_entry_t * cur = &ctx->egl.dmabuf_cache[i];
+            if (identity_matches(cur, &identity)) {
+                entry = cur;
+                break;
+            }
+
+            // empty entries have last_used == 0
+            if (entry == NULL || cur->last_used < entry->last_used) {
+                entry = cur;
+            }
+        }
+    }
+
+    EGLImage frame_image = EGL_NO_IMAGE;
+    if (entry != NULL && identity_matches(entry, &identity)) {
+        frame_image = entry->image;
+    } else {
+        frame_image = create_image(ctx, dmabuf);
+        if (frame_image == EGL_NO_IMAGE) {
+            return false;
+        }
+
+        if (entry != NULL) {
+            wlm_log_debug(ctx, "egl::dmabuf::import(): caching new EGL image\n");
+            destroy_entry(ctx, entry);
+            *entry = identity;
+            entry->image = frame_image;
+        }
+    }
+
+    if (entry != NULL) {
+        entry->last_used = ++ctx->egl.dmabuf_cache_counter;
+    }
+
     // convert EGLImage to GL texture
+    if (ctx->egl.texture_immutable) wlm_egl_reset_texture(ctx);
     glBindTexture(GL_TEXTURE_2D, ctx->egl.texture);
     ctx->egl.glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, frame_image);
 
-    // destroy temporary image
-    eglDestroyImage(ctx->egl.display, frame_image);
+    // destroy temporary image if it could not be cached
+    if (entry == NULL) eglDestroyImage(ctx->egl.display, frame_image);
     wlm_egl_check_errors(ctx, "dmabuf import failed");
 
     ctx->egl.format = format != NULL ? format->gl_format : GL_RGB8_OES; // TODO: remove this fallback
     ctx->egl.texture_initialized = true;
+    ctx->egl.texture_shm_storage = false;
     ctx->egl.texture_region_aware = region_aware;
 
     // set buffer flags
@@ -113,5 +202,29 @@ bool wlm_egl_dmabuf_import(ctx_t * ctx, dmabuf_t * dmabuf, const wlm_egl_format_
         wlm_egl_resize_viewport(ctx);
     }
 
+    wlm_mirror_stats_import(ctx, dmabuf->drm_format, start_ns, 0);
     return true;
 }
+
+// --- wlm_egl_dmabuf_invalidate ---
+
+void wlm_egl_dmabuf_invalidate(ctx_t * ctx, dmabuf_t * dmabuf) {
+    if (!ctx->egl.initialized) return;
+    if (dmabuf->planes == 0 || dmabuf->planes > MAX_PLANES) return;
+
+    wlm_egl_dmabuf_cache_entry_t identity;
+    if (!get_identity(dmabuf, &identity)) return;
+
+    for (size_t i = 0; i < WLM_EGL_DMABUF_CACHE_SIZE; i++) {
+        wlm_egl_dmabuf_cache_entry_t * entry = &ctx->egl.dmabuf_cache[i];
+        if (identity_matches(entry, &identity)) destroy_entry(ctx, entry);
+    }
+}
+
+// --- wlm_egl_dmabuf_clear_cache ---
+
+void wlm_egl_dmabuf_clear_cache(ctx_t * ctx) {
+    for (size_t i = 0; i < WLM_EGL_DMABUF_CACHE_SIZE; i++) {
+        destroy_entry(ctx, &ctx->egl.dmabuf_cache[i]);
+    }
+}
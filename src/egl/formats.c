@@ -133,6 +133,14 @@ static const wlm_egl_format_t formats[] = {
     }
 };
 
+const wlm_egl_format_t * wlm_egl_formats_get(size_t index) {
+    for (size_t i = 0; i <= index; i++) {
+        if (formats[i].bpp == -1U) return NULL;
+    }
+
+    return &formats[index];
+}
+
 const wlm_egl_format_t * wlm_egl_formats_find_shm(enum wl_shm_format shm_format) {
     const wlm_egl_format_t * format = formats;
     while (format->bpp != -1U) {
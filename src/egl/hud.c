@@ -0,0 +1,406 @@
+#include <ctype.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wlm/context.h>
+#include <wlm/egl/hud.h>
+#include <wlm/glsl/hud_vertex_shader.h>
+#include <wlm/glsl/hud_fragment_shader.h>
+#include <wlm/glsl/hud_font.h>
+
+// glyphs in the font atlas, followed by a solid cell
+static const char glyphs[] = " 0123456789abcdefghijklmnopqrstuvwxyz.-:/%()";
+#define GLYPH_SOLID (sizeof glyphs - 1)
+#define GLYPH_WIDTH 6
+#define GLYPH_HEIGHT 8
+
+// layout in font pixels, scaled by the window scale
+#define LINE_HEIGHT 10
+#define PADDING 4
+#define GRAPH_HEIGHT 30
+#define MAX_LINE_LEN 48
+#define NUM_LINES 4
+
+// frame times at the top of the graph
+#define GRAPH_MAX_NS 50000000ull
+#define RATE_INTERVAL_NS 1000000000ull
+
+static const float color_text[4] = { 1.0, 1.0, 1.0, 1.0 };
+static const float color_background[4] = { 0.0, 0.0, 0.0, 0.6 };
+static const float color_good[4] = { 0.3, 0.9, 0.3, 0.9 };
+static const float color_slow[4] = { 0.9, 0.8, 0.2, 0.9 };
+static const float color_bad[4] = { 0.9, 0.3, 0.3, 0.9 };
+
+// --- font ---
+
+static const char * skip_pbm_space(const char * data) {
+    while (*data != '\0') {
+        if (*data == '#') {
+            while (*data != '\0' && *data != '\n') data++;
+        } else if (isspace(*data)) {
+            data++;
+        } else {
+            break;
+        }
+    }
+
+    return data;
+}
+
+static bool load_font(ctx_t * ctx) {
+    const char * data = wlm_glsl_hud_font;
+
+    // plain PBM: magic, width, height, then one digit per pixel
+    if (strncmp(data, "P1", 2) != 0) {
+        wlm_log_error("egl::hud::load_font(): invalid font atlas header\n");
+        return false;
+    }
+    data = skip_pbm_space(data + 2);
+
+    char * end;
+    unsigned long width = strtoul(data, &end, 10);
+    data = skip_pbm_space(end);
+    unsigned long height = strtoul(data, &end, 10);
+    data = end;
+
+    if (width != (GLYPH_SOLID + 1) * GLYPH_WIDTH || height != GLYPH_HEIGHT) {
+        wlm_log_error("egl::hud::load_font(): unexpected font atlas size %lux%lu\n", width, height);
+        return false;
+    }
+
+    uint8_t * pixels = malloc(width * height);
+    if (pixels == NULL) {
+        wlm_log_error("egl::hud::load_font(): failed to allocate font atlas\n");
+        return false;
+    }
+
+    for (size_t i = 0; i < width * height; i++) {
+        data = skip_pbm_space(data);
+        if (*data != '0' && *data != '1') {
+            wlm_log_error("egl::hud::load_font(): truncated font atlas\n");
+            free(pixels);
+            return false;
+        }
+
+        // set pixels are black in PBM, they become opaque glyph pixels
+        pixels[i] = *data == '1' ? 0xff : 0x00;
+        data++;
+    }
+
+    glGenTextures(1, &ctx->egl.hud.font_texture);
+    glBindTexture(GL_TEXTURE_2D, ctx->egl.hud.font_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, width, height, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    free(pixels);
+
+    ctx->egl.hud.font_width = width;
+    ctx->egl.hud.font_height = height;
+    return wlm_egl_check_errors(ctx, "failed to upload HUD font atlas");
+}
+
+// --- shaders ---
+
+static GLuint compile_shader(GLenum type, const char * source, const char * name) {
+    GLint success;
+    char errorLog[1024] = { 0 };
+
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (success != GL_TRUE) {
+        glGetShaderInfoLog(shader, sizeof errorLog, NULL, errorLog);
+        errorLog[strcspn(errorLog, "\n")] = '\0';
+        wlm_log_error("egl::hud::compile_shader(): failed to compile %s: %s\n", name, errorLog);
+        glDeleteShader(shader);
+        return 0;
+    }
+
+    return shader;
+}
+
+static bool create_program(ctx_t * ctx) {
+    GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, wlm_glsl_hud_vertex_shader, "HUD vertex shader");
+    if (vertex_shader == 0) return false;
+
+    GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, wlm_glsl_hud_fragment_shader, "HUD fragment shader");
+    if (fragment_shader == 0) {
+        glDeleteShader(vertex_shader);
+        return false;
+    }
+
+    GLint success;
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glBindAttribLocation(program, 0, "aPosition");
+    glBindAttribLocation(program, 1, "aTexCoord");
+    glBindAttribLocation(program, 2, "aColor");
+    glLinkProgram(program);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (success != GL_TRUE) {
+        wlm_log_error("egl::hud::create_program(): failed to link HUD shader program\n");
+        glDeleteProgram(program);
+        return false;
+    }
+
+    ctx->egl.hud.shader_program = program;
+    ctx->egl.hud.screen_size_uniform = glGetUniformLocation(program, "uScreenSize");
+    ctx->egl.hud.font_uniform = glGetUniformLocation(program, "uFont");
+    return true;
+}
+
+// --- vertices ---
+
+static void push_quad(ctx_egl_hud_t * hud, float x1, float y1, float x2, float y2, float u1, float v1, float u2, float v2, const float color[4]) {
+    if (hud->num_vertices + 6 > WLM_EGL_HUD_MAX_QUADS * 6) return;
+
+    const float corners[6][4] = {
+        { x1, y1, u1, v1 }, { x2, y1, u2, v1 }, { x1, y2, u1, v2 },
+        { x1, y2, u1, v2 }, { x2, y1, u2, v1 }, { x2, y2, u2, v2 },
+    };
+
+    for (size_t i = 0; i < 6; i++) {
+        wlm_egl_hud_vertex_t * vertex = &hud->vertices[hud->num_vertices++];
+        vertex->x = corners[i][0];
+        vertex->y = corners[i][1];
+        vertex->u = corners[i][2];
+        vertex->v = corners[i][3];
+        vertex->r = color[0];
+        vertex->g = color[1];
+        vertex->b = color[2];
+        vertex->a = color[3];
+    }
+}
+
+static void push_glyph(ctx_egl_hud_t * hud, size_t glyph, float x, float y, float scale, const float color[4]) {
+    float u1 = (float)(glyph * GLYPH_WIDTH) / hud->font_width;
+    float u2 = (float)((glyph + 1) * GLYPH_WIDTH) / hud->font_width;
+    float v2 = (float)GLYPH_HEIGHT / hud->font_height;
+    push_quad(hud, x, y, x + GLYPH_WIDTH * scale, y + GLYPH_HEIGHT * scale, u1, 0.0, u2, v2, color);
+}
+
+static void push_solid(ctx_egl_hud_t * hud, float x1, float y1, float x2, float y2, const float color[4]) {
+    // sample the center of the solid cell
+    float u = (GLYPH_SOLID * GLYPH_WIDTH + GLYPH_WIDTH / 2.0) / hud->font_width;
+    float v = (GLYPH_HEIGHT / 2.0) / hud->font_height;
+    push_quad(hud, x1, y1, x2, y2, u, v, u, v, color);
+}
+
+static void push_text(ctx_egl_hud_t * hud, const char * text, float x, float y, float scale) {
+    for (; *text != '\0'; text++) {
+        const char * glyph = strchr(glyphs, tolower(*text));
+        if (glyph != NULL && *glyph != ' ') {
+            push_glyph(hud, glyph - glyphs, x, y, scale, color_text);
+        }
+
+        x += GLYPH_WIDTH * scale;
+    }
+}
+
+// --- frame rates ---
+
+static void update_rates(ctx_t * ctx, uint64_t now) {
+    ctx_egl_hud_t * hud = &ctx->egl.hud;
+    hud->window_draws++;
+
+    uint64_t elapsed = now - hud->window_start_ns;
+    if (elapsed < RATE_INTERVAL_NS) return;
+
+    hud->capture_fps = hud->window_captures * 1e9 / elapsed;
+    hud->display_fps = hud->window_draws * 1e9 / elapsed;
+    hud->window_start_ns = now;
+    hud->window_captures = 0;
+    hud->window_draws = 0;
+}
+
+void wlm_egl_hud_frame_captured(ctx_t * ctx) {
+    ctx_egl_hud_t * hud = &ctx->egl.hud;
+    uint64_t now = wlm_event_now_ns();
+
+    hud->window_captures++;
+    if (hud->last_capture_ns != 0) {
+        hud->frame_times[hud->next_frame_time] = now - hud->last_capture_ns;
+        hud->next_frame_time = (hud->next_frame_time + 1) % WLM_EGL_HUD_GRAPH_SAMPLES;
+    }
+    hud->last_capture_ns = now;
+}
+
+// --- draw ---
+
+static void build_vertices(ctx_t * ctx, float scale) {
+    ctx_egl_hud_t * hud = &ctx->egl.hud;
+    hud->num_vertices = 0;
+
+    uint64_t latency_ns = 0;
+    bool has_latency = wlm_mirror_timing_percentile(ctx, WLM_TIMING_LATENCY_CAPTURE, 50, &latency_ns);
+    const char * backend = ctx->mirror.backend == NULL ? "none" : ctx->mirror.backend->name;
+
+    char lines[NUM_LINES][MAX_LINE_LEN + 1];
+    snprintf(lines[0], sizeof lines[0], "backend %s", backend);
+    snprintf(lines[1], sizeof lines[1], "capture %.1f fps  display %.1f fps", hud->capture_fps, hud->display_fps);
+    snprintf(lines[2], sizeof lines[2], "import %.2f ms", ctx->mirror.stats.last_import_ns / 1e6);
+    if (has_latency) {
+        snprintf(lines[3], sizeof lines[3], "latency %.1f ms", latency_ns / 1e6);
+    } else {
+        snprintf(lines[3], sizeof lines[3], "latency -");
+    }
+
+    // size the background to the widest line or the graph
+    size_t max_len = 0;
+    for (size_t i = 0; i < NUM_LINES; i++) {
+        size_t len = strlen(lines[i]);
+        if (len > max_len) max_len = len;
+    }
+
+    float width = fmaxf(max_len * GLYPH_WIDTH, WLM_EGL_HUD_GRAPH_SAMPLES) + 2 * PADDING;
+    float height = NUM_LINES * LINE_HEIGHT + GRAPH_HEIGHT + 3 * PADDING;
+    push_solid(hud, PADDING * scale, PADDING * scale, (PADDING + width) * scale, (PADDING + height) * scale, color_background);
+
+    float x = 2 * PADDING * scale;
+    float y = 2 * PADDING * scale;
+    for (size_t i = 0; i < NUM_LINES; i++) {
+        push_text(hud, lines[i], x, y, scale);
+        y += LINE_HEIGHT * scale;
+    }
+
+    // frame time graph, oldest frame on the left
+    float graph_bottom = y + (PADDING + GRAPH_HEIGHT) * scale;
+    for (size_t i = 0; i < WLM_EGL_HUD_GRAPH_SAMPLES; i++) {
+        uint64_t frame_time = hud->frame_times[(hud->next_frame_time + i) % WLM_EGL_HUD_GRAPH_SAMPLES];
+        if (frame_time == 0) continue;
+
+        const float * color = color_good;
+        if (frame_time > GRAPH_MAX_NS * 4 / 5) {
+            color = color_bad;
+        } else if (frame_time > GRAPH_MAX_NS * 2 / 5) {
+            color = color_slow;
+        }
+
+        float bar = fminf((float)frame_time / GRAPH_MAX_NS, 1.0) * GRAPH_HEIGHT * scale;
+        push_solid(hud, x + i * scale, graph_bottom - bar, x + (i + 1) * scale, graph_bottom, color);
+    }
+}
+
+void wlm_egl_hud_draw(ctx_t * ctx) {
+    WLM_TRACE_SCOPE(ctx, "egl::hud::draw");
+    ctx_egl_hud_t * hud = &ctx->egl.hud;
+    if (!hud->initialized) return;
+
+    update_rates(ctx, wlm_event_now_ns());
+
+    uint32_t win_width = round(ctx->wl.width * ctx->wl.scale);
+    uint32_t win_height = round(ctx->wl.height * ctx->wl.scale);
+    float scale = 2 * ceil(ctx->wl.scale);
+    build_vertices(ctx, scale);
+
+    // draw over the whole window, not only the mirrored area
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glViewport(0, 0, win_width, win_height);
+
+    glUseProgram(hud->shader_program);
+    glUniform2f(hud->screen_size_uniform, win_width, win_height);
+    glBindTexture(GL_TEXTURE_2D, hud->font_texture);
+
+    glBindBuffer(GL_ARRAY_BUFFER, hud->vbo);
+    glBufferData(GL_ARRAY_BUFFER, hud->num_vertices * sizeof (wlm_egl_hud_vertex_t), hud->vertices, GL_STREAM_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof (wlm_egl_hud_vertex_t), (void *)offsetof(wlm_egl_hud_vertex_t, x));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof (wlm_egl_hud_vertex_t), (void *)offsetof(wlm_egl_hud_vertex_t, u));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof (wlm_egl_hud_vertex_t), (void *)offsetof(wlm_egl_hud_vertex_t, r));
+    glEnableVertexAttribArray(2);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArrays(GL_TRIANGLES, 0, hud->num_vertices);
+    glDisable(GL_BLEND);
+
+    // restore the vertex layout and shader set up in egl::init()
+    glDisableVertexAttribArray(2);
+    glBindBuffer(GL_ARRAY_BUFFER, ctx->egl.vbo);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof (float), (void *)(0 * sizeof (float)));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof (float), (void *)(2 * sizeof (float)));
+    glUseProgram(ctx->egl.shader_program);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+// --- init_hud ---
+
+void wlm_egl_hud_init(ctx_t * ctx) {
+    ctx_egl_hud_t * hud = &ctx->egl.hud;
+
+    hud->vbo = 0;
+    hud->font_texture = 0;
+    hud->shader_program = 0;
+    hud->screen_size_uniform = 0;
+    hud->font_uniform = 0;
+    hud->font_width = 1;
+    hud->font_height = 1;
+
+    hud->vertices = NULL;
+    hud->num_vertices = 0;
+
+    hud->window_start_ns = wlm_event_now_ns();
+    hud->window_captures = 0;
+    hud->window_draws = 0;
+    hud->capture_fps = 0;
+    hud->display_fps = 0;
+
+    hud->last_capture_ns = 0;
+    for (size_t i = 0; i < WLM_EGL_HUD_GRAPH_SAMPLES; i++) {
+        hud->frame_times[i] = 0;
+    }
+    hud->next_frame_time = 0;
+    hud->initialized = false;
+
+    // the HUD is optional, disable it instead of failing
+    hud->vertices = calloc(WLM_EGL_HUD_MAX_QUADS * 6, sizeof (wlm_egl_hud_vertex_t));
+    if (hud->vertices == NULL) {
+        wlm_log_error("egl::hud::init(): failed to allocate vertex buffer\n");
+        return;
+    }
+
+    if (!load_font(ctx) || !create_program(ctx)) {
+        wlm_log_warn("egl::hud::init(): HUD is unavailable\n");
+        wlm_egl_hud_cleanup(ctx);
+        return;
+    }
+
+    glGenBuffers(1, &hud->vbo);
+
+    glUseProgram(hud->shader_program);
+    glUniform1i(hud->font_uniform, 0);
+
+    // restore state of the main shader
+    glUseProgram(ctx->egl.shader_program);
+    glBindBuffer(GL_ARRAY_BUFFER, ctx->egl.vbo);
+
+    hud->initialized = true;
+}
+
+// --- cleanup_hud ---
+
+void wlm_egl_hud_cleanup(ctx_t * ctx) {
+    ctx_egl_hud_t * hud = &ctx->egl.hud;
+
+    if (hud->shader_program != 0) glDeleteProgram(hud->shader_program);
+    if (hud->font_texture != 0) glDeleteTextures(1, &hud->font_texture);
+    if (hud->vbo != 0) glDeleteBuffers(1, &hud->vbo);
+    free(hud->vertices);
+
+    hud->shader_program = 0;
+    hud->font_texture = 0;
+    hud->vbo = 0;
+    hud->vertices = NULL;
+    hud->initialized = false;
+}
@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <string.h>
+#include <wlm/context.h>
+#include <wlm/egl/pbo.h>
+#include <wlm/damage.h>
+
+// upper bound for waiting on the GPU to finish reading a buffer
+#define FENCE_TIMEOUT_NS 100000000ull
+
+// --- helper functions ---
+
+static bool load_function(ctx_t * ctx, void ** function, const char * name) {
+    *function = (void *)eglGetProcAddress(name);
+    if (*function == NULL) {
+        wlm_log_debug(ctx, "egl::pbo::load_function(): failed to get pointer to %s\n", name);
+        return false;
+    }
+
+    return true;
+}
+
+static void wait_slot(ctx_t * ctx, wlm_egl_pbo_slot_t * slot) {
+    ctx_egl_pbo_t * pbo = &ctx->egl.pbo;
+    if (slot->fence == NULL) return;
+
+    // usually signaled already, the GPU had a whole frame to read the buffer
+    GLenum status = pbo->glClientWaitSync(slot->fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+    if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+        wlm_log_warn("egl::pbo::wait_slot(): timed out waiting for pixel buffer upload\n");
+    }
+
+    pbo->glDeleteSync(slot->fence);
+    slot->fence = NULL;
+}
+
+static void destroy_slots(ctx_t * ctx) {
+    ctx_egl_pbo_t * pbo = &ctx->egl.pbo;
+
+    for (size_t i = 0; i < WLM_EGL_PBO_RING_SIZE; i++) {
+        wlm_egl_pbo_slot_t * slot = &pbo->slots[i];
+        wait_slot(ctx, slot);
+
+        if (slot->mapping != NULL) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->buffer);
+            pbo->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            slot->mapping = NULL;
+        }
+
+        if (slot->buffer != 0) glDeleteBuffers(1, &slot->buffer);
+        slot->buffer = 0;
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    pbo->next_slot = 0;
+    pbo->current = NULL;
+    pbo->size = 0;
+}
+
+static bool create_slots(ctx_t * ctx, size_t size) {
+    ctx_egl_pbo_t * pbo = &ctx->egl.pbo;
+    destroy_slots(ctx);
+
+    while (glGetError() != GL_NO_ERROR) {}
+    for (size_t i = 0; i < WLM_EGL_PBO_RING_SIZE; i++) {
+        wlm_egl_pbo_slot_t * slot = &pbo->slots[i];
+        glGenBuffers(1, &slot->buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->buffer);
+
+        if (pbo->persistent) {
+            // immutable storage stays mapped, no map and unmap per frame
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT_EXT | GL_MAP_COHERENT_BIT_EXT;
+            pbo->glBufferStorageEXT(GL_PIXEL_UNPACK_BUFFER, size, NULL, flags);
+            slot->mapping = pbo->glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags);
+            if (slot->mapping == NULL) break;
+        } else {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (glGetError() != GL_NO_ERROR) {
+        wlm_log_warn("egl::pbo::create_slots(): failed to allocate pixel buffers\n");
+        destroy_slots(ctx);
+        return false;
+    }
+
+    pbo->size = size;
+    return true;
+}
+
+static void copy_rows(uint8_t * dst, const uint8_t * src, uint32_t stride, uint32_t height, const wlm_damage_t * damage) {
+    if (damage == NULL || damage->full) {
+        memcpy(dst, src, (size_t)stride * height);
+        return;
+    }
+
+    // keep the shm layout, uploads address the damaged rows by offset
+    for (size_t i = 0; i < damage->num_rects; i++) {
+        const region_t * rect = &damage->rects[i];
+        int32_t y1 = rect->y < 0 ? 0 : rect->y;
+        int32_t y2 = rect->y + rect->height > (int32_t)height ? (int32_t)height : rect->y + rect->height;
+        if (y2 <= y1) continue;
+
+        size_t offset = (size_t)y1 * stride;
+        memcpy(dst + offset, src + offset, (size_t)(y2 - y1) * stride);
+    }
+}
+
+// --- wlm_egl_pbo_begin ---
+
+bool wlm_egl_pbo_begin(ctx_t * ctx, const void * shm_addr, uint32_t stride, uint32_t height, const wlm_damage_t * damage) {
+    ctx_egl_pbo_t * pbo = &ctx->egl.pbo;
+    if (!pbo->initialized) return false;
+
+    size_t size = (size_t)stride * height;
+    if (size != pbo->size && !create_slots(ctx, size)) {
+        // don't retry every frame
+        wlm_egl_pbo_cleanup(ctx);
+        return false;
+    }
+
+    wlm_egl_pbo_slot_t * slot = &pbo->slots[pbo->next_slot];
+    pbo->next_slot = (pbo->next_slot + 1) % WLM_EGL_PBO_RING_SIZE;
+    wait_slot(ctx, slot);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->buffer);
+    uint8_t * dst = slot->mapping;
+    if (dst == NULL) {
+        // invalidating lets the driver hand out fresh memory instead of stalling
+        dst = pbo->glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (dst == NULL) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            wlm_log_warn("egl::pbo::begin(): failed to map pixel buffer\n");
+            return false;
+        }
+    }
+
+    {
+        WLM_TRACE_SCOPE(ctx, "egl::pbo::copy");
+        copy_rows(dst, shm_addr, stride, height, damage);
+    }
+
+    if (slot->mapping == NULL && !pbo->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        wlm_log_warn("egl::pbo::begin(): pixel buffer contents were lost\n");
+        return false;
+    }
+
+    pbo->current = slot;
+    return true;
+}
+
+// --- wlm_egl_pbo_end ---
+
+void wlm_egl_pbo_end(ctx_t * ctx) {
+    ctx_egl_pbo_t * pbo = &ctx->egl.pbo;
+    if (pbo->current == NULL) return;
+
+    // the buffer may only be rewritten once the GPU has read it
+    pbo->current->fence = pbo->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    pbo->current = NULL;
+
+    // other texture uploads read from client memory again
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+// --- wlm_egl_pbo_init ---
+
+void wlm_egl_pbo_init(ctx_t * ctx) {
+    ctx_egl_pbo_t * pbo = &ctx->egl.pbo;
+
+    pbo->glMapBufferRange = NULL;
+    pbo->glUnmapBuffer = NULL;
+    pbo->glFenceSync = NULL;
+    pbo->glClientWaitSync = NULL;
+    pbo->glDeleteSync = NULL;
+    pbo->glBufferStorageEXT = NULL;
+
+    for (size_t i = 0; i < WLM_EGL_PBO_RING_SIZE; i++) {
+        pbo->slots[i].buffer = 0;
+        pbo->slots[i].fence = NULL;
+        pbo->slots[i].mapping = NULL;
+    }
+    pbo->next_slot = 0;
+    pbo->current = NULL;
+    pbo->size = 0;
+
+    pbo->persistent = false;
+    pbo->initialized = false;
+
+    // pixel unpack buffers need OpenGL ES 3.0
+    if (ctx->egl.gles_version_major < 3) {
+        wlm_log_debug(ctx, "egl::pbo::init(): OpenGL ES 3.0 unavailable, uploading from shm directly\n");
+        return;
+    }
+
+    // software renderers upload with a CPU copy anyway, staging would only add another
+    const char * renderer = (const char *)glGetString(GL_RENDERER);
+    if (renderer != NULL && (strstr(renderer, "llvmpipe") != NULL || strstr(renderer, "softpipe") != NULL)) {
+        wlm_log_debug(ctx, "egl::pbo::init(): software renderer, uploading from shm directly\n");
+        return;
+    }
+
+    bool loaded = true;
+    loaded = load_function(ctx, (void **)&pbo->glMapBufferRange, "glMapBufferRange") && loaded;
+    loaded = load_function(ctx, (void **)&pbo->glUnmapBuffer, "glUnmapBuffer") && loaded;
+    loaded = load_function(ctx, (void **)&pbo->glFenceSync, "glFenceSync") && loaded;
+    loaded = load_function(ctx, (void **)&pbo->glClientWaitSync, "glClientWaitSync") && loaded;
+    loaded = load_function(ctx, (void **)&pbo->glDeleteSync, "glDeleteSync") && loaded;
+    if (!loaded) {
+        wlm_log_warn("egl::pbo::init(): missing OpenGL ES 3.0 functions, uploading from shm directly\n");
+        return;
+    }
+
+    // - GL_EXT_buffer_storage: keep buffers mapped across uploads
+    if (wlm_egl_has_extension("GL_EXT_buffer_storage")) {
+        pbo->persistent = load_function(ctx, (void **)&pbo->glBufferStorageEXT, "glBufferStorageEXT");
+    }
+
+    wlm_log_debug(ctx, "egl::pbo::init(): streaming shm uploads through %s pixel buffers\n",
+        pbo->persistent ? "persistently mapped" : "mapped");
+    pbo->initialized = true;
+}
+
+// --- wlm_egl_pbo_cleanup ---
+
+void wlm_egl_pbo_cleanup(ctx_t * ctx) {
+    ctx_egl_pbo_t * pbo = &ctx->egl.pbo;
+    if (!pbo->initialized) return;
+
+    destroy_slots(ctx);
+    pbo->initialized = false;
+}
@@ -1,20 +1,107 @@
 #include <wlm/context.h>
 #include <wlm/egl/shm.h>
 #include <wlm/egl/formats.h>
+#include <wlm/egl/pbo.h>
+#include <wlm/egl/dmabuf.h>
+#include <wlm/damage.h>
+
+static uint64_t upload_damage(const wlm_damage_t * damage, void * pixels, const wlm_egl_format_t * format, uint32_t width, uint32_t height) {
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < damage->num_rects; i++) {
+        // clamp damage to frame bounds
+        const region_t * rect = &damage->rects[i];
+        int32_t x1 = rect->x < 0 ? 0 : rect->x;
+        int32_t y1 = rect->y < 0 ? 0 : rect->y;
+        int32_t x2 = rect->x + rect->width > (int32_t)width ? (int32_t)width : rect->x + rect->width;
+        int32_t y2 = rect->y + rect->height > (int32_t)height ? (int32_t)height : rect->y + rect->height;
+        if (x2 <= x1 || y2 <= y1) continue;
+
+        glPixelStorei(GL_UNPACK_SKIP_PIXELS_EXT, x1);
+        glPixelStorei(GL_UNPACK_SKIP_ROWS_EXT, y1);
+        glTexSubImage2D(GL_TEXTURE_2D,
+            0, x1, y1, x2 - x1, y2 - y1,
+            format->gl_format, format->gl_type, pixels
+        );
+        bytes += (uint64_t)(x2 - x1) * (y2 - y1) * (format->bpp / 8);
+    }
+
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS_EXT, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS_EXT, 0);
+    return bytes;
+}
+
+static GLenum storage_format(ctx_t * ctx, const wlm_egl_format_t * format) {
+    // immutable storage needs a sized format, only known for 8 bit channels
+    if (format->gl_type != GL_UNSIGNED_BYTE) return GL_NONE;
+
+    switch (format->gl_format) {
+        case GL_RGBA: return GL_RGBA8;
+        case GL_RGB: return GL_RGB8;
+        case GL_BGRA_EXT: return ctx->egl.texture_storage_bgra ? GL_BGRA8_EXT : GL_NONE;
+        default: return GL_NONE;
+    }
+}
+
+static void allocate_storage(ctx_t * ctx, const wlm_egl_format_t * format, uint32_t width, uint32_t height) {
+    WLM_TRACE_SCOPE(ctx, "egl::shm::allocate_storage");
+    if (ctx->egl.texture_immutable) wlm_egl_reset_texture(ctx);
+    glBindTexture(GL_TEXTURE_2D, ctx->egl.texture);
+
+    GLenum sized_format = storage_format(ctx, format);
+    if (ctx->egl.glTexStorage2D != NULL && sized_format != GL_NONE) {
+        ctx->egl.glTexStorage2D(GL_TEXTURE_2D, 1, sized_format, width, height);
+        ctx->egl.texture_immutable = true;
+    } else {
+        glTexImage2D(GL_TEXTURE_2D,
+            0, format->gl_format, width, height,
+            0, format->gl_format, format->gl_type, NULL
+        );
+    }
+}
+
+bool wlm_egl_shm_import(ctx_t * ctx, void * shm_addr, const wlm_egl_format_t * format, uint32_t width, uint32_t height, uint32_t stride, bool invert_y, bool region_aware, const wlm_damage_t * damage) {
+    WLM_TRACE_SCOPE(ctx, "egl::shm::import");
+    uint64_t start_ns = wlm_event_now_ns();
+
+    // reuse the texture storage as long as the frame layout stays the same
+    // - reallocating makes the driver free and allocate the whole frame again
+    bool has_storage = ctx->egl.texture_shm_storage &&
+        ctx->egl.format == (uint32_t)format->gl_format && ctx->egl.type == (uint32_t)format->gl_type &&
+        ctx->egl.width == width && ctx->egl.height == height;
+    if (!has_storage) allocate_storage(ctx, format, width, height);
+
+    // partial upload is only possible into a texture that holds the previous frame
+    // - uploading a region out of the full frame needs the unpack skip parameters
+    bool partial = has_storage && damage != NULL && !damage->full && ctx->egl.unpack_subimage;
+
+    // stage frame data in a pixel buffer if possible
+    // - the GPU copies it into the texture asynchronously instead of stalling on shm memory
+    void * pixels = shm_addr;
+    bool staged = wlm_egl_pbo_begin(ctx, shm_addr, stride, height, partial ? damage : NULL);
+    if (staged) pixels = NULL;
 
-bool wlm_egl_shm_import(ctx_t * ctx, void * shm_addr, const wlm_egl_format_t * format, uint32_t width, uint32_t height, uint32_t stride, bool invert_y, bool region_aware) {
     // store frame data into texture
+    glBindTexture(GL_TEXTURE_2D, ctx->egl.texture);
     glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride / (format->bpp / 8));
-    glTexImage2D(GL_TEXTURE_2D,
-        0, format->gl_format, width, height,
-        0, format->gl_format, format->gl_type, shm_addr
-    );
+    uint64_t bytes_uploaded = 0;
+    if (partial) {
+        bytes_uploaded = upload_damage(damage, pixels, format, width, height);
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D,
+            0, 0, 0, width, height,
+            format->gl_format, format->gl_type, pixels
+        );
+        bytes_uploaded = (uint64_t)width * height * (format->bpp / 8);
+    }
     glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
+    if (staged) wlm_egl_pbo_end(ctx);
 
     wlm_egl_check_errors(ctx, "shm buffer import failed");
 
     ctx->egl.format = format->gl_format;
+    ctx->egl.type = format->gl_type;
     ctx->egl.texture_initialized = true;
+    ctx->egl.texture_shm_storage = true;
     ctx->egl.texture_region_aware = region_aware;
 
     // set buffer flags
@@ -30,5 +117,20 @@ bool wlm_egl_shm_import(ctx_t * ctx, void * shm_addr, const wlm_egl_format_t * f
         wlm_egl_resize_viewport(ctx);
     }
 
+    wlm_mirror_stats_import(ctx, format->drm_format, start_ns, bytes_uploaded);
+    return true;
+}
+
+bool wlm_egl_shm_import_udmabuf(ctx_t * ctx, wlm_wayland_shm_handle_t handle, const wlm_egl_format_t * format, bool invert_y, bool region_aware) {
+    dmabuf_t * dmabuf = wlm_wayland_shm_get_dmabuf(ctx, handle);
+    if (dmabuf == NULL) return false;
+
+    // the texture samples the shm memory directly, no upload needed
+    if (!wlm_egl_dmabuf_import(ctx, dmabuf, format, invert_y, region_aware, true)) {
+        wlm_log_warn("egl::shm::import_udmabuf(): driver rejected udmabuf, falling back to copying shm buffers\n");
+        wlm_wayland_shm_disable_dmabuf(ctx);
+        return false;
+    }
+
     return true;
 }
@@ -1,6 +1,8 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <time.h>
+#include <sys/timerfd.h>
 #include <wlm/context.h>
 #include <wlm/event.h>
 
@@ -82,6 +84,57 @@ void wlm_event_remove_fd(ctx_t * ctx, event_handler_t * handler) {
     handler->next = NULL;
 }
 
+// --- timers ---
+
+void wlm_event_add_timer(ctx_t * ctx, event_handler_t * handler) {
+    handler->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (handler->fd == -1) {
+        wlm_log_error("event::add_timer(): failed to create timerfd\n");
+        wlm_exit_fail(ctx);
+    }
+
+    handler->events = EPOLLIN;
+    handler->timeout_ms = -1;
+    handler->is_timer = true;
+    wlm_event_add_fd(ctx, handler);
+}
+
+static void set_timer(ctx_t * ctx, event_handler_t * handler, uint64_t deadline_ns) {
+    struct itimerspec spec = {
+        .it_interval = { .tv_sec = 0, .tv_nsec = 0 },
+        .it_value = { .tv_sec = deadline_ns / 1000000000, .tv_nsec = deadline_ns % 1000000000 }
+    };
+
+    if (timerfd_settime(handler->fd, TFD_TIMER_ABSTIME, &spec, NULL) == -1) {
+        wlm_log_error("event::set_timer(): failed to set timerfd\n");
+        wlm_exit_fail(ctx);
+    }
+}
+
+void wlm_event_arm_timer(ctx_t * ctx, event_handler_t * handler, uint64_t deadline_ns) {
+    // a zero it_value disarms the timer, expire as soon as possible instead
+    if (deadline_ns == 0) deadline_ns = 1;
+    set_timer(ctx, handler, deadline_ns);
+}
+
+void wlm_event_disarm_timer(ctx_t * ctx, event_handler_t * handler) {
+    set_timer(ctx, handler, 0);
+}
+
+void wlm_event_remove_timer(ctx_t * ctx, event_handler_t * handler) {
+    if (handler->fd == -1) return;
+
+    wlm_event_remove_fd(ctx, handler);
+    close(handler->fd);
+    handler->fd = -1;
+}
+
+uint64_t wlm_event_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
 #define MAX_EVENTS 10
 void wlm_event_loop(ctx_t * ctx) {
     struct epoll_event events[MAX_EVENTS];
@@ -96,6 +149,13 @@ void wlm_event_loop(ctx_t * ctx) {
     while ((num_events = epoll_wait(ctx->event.pollfd, events, MAX_EVENTS, timeout_ms)) != -1 && !ctx->wl.closing) {
         for (int i = 0; i < num_events; i++) {
             event_handler_t * handler = (event_handler_t *)events[i].data.ptr;
+            if (handler->is_timer) {
+                // clear expiration count, spurious wakeups read nothing
+                uint64_t expirations;
+                if (read(handler->fd, &expirations, sizeof expirations) != sizeof expirations) continue;
+            }
+
+            WLM_TRACE_SCOPE(ctx, "event::dispatch");
             handler->on_event(ctx, events[i].events);
         }
 
@@ -11,6 +11,7 @@ void wlm_cleanup(ctx_t * ctx) {
     if (ctx->egl.initialized) wlm_egl_cleanup(ctx);
     if (ctx->wl.initialized) wlm_wayland_cleanup(ctx);
     if (ctx->stream.initialized) wlm_stream_cleanup(ctx);
+    if (ctx->trace.initialized) wlm_trace_cleanup(ctx);
     if (ctx->event.initialized) wlm_event_cleanup(ctx);
 
     wlm_cleanup_opt(ctx);
@@ -25,6 +26,7 @@ int main(int argc, char ** argv) {
     ctx_t ctx = { 0 };
 
     ctx.event.initialized = false;
+    ctx.trace.initialized = false;
     ctx.stream.initialized = false;
     ctx.wl.initialized = false;
     ctx.egl.initialized = false;
@@ -41,6 +43,9 @@ int main(int argc, char ** argv) {
 
     wlm_opt_parse(&ctx, argc, argv);
 
+    wlm_log_debug(&ctx, "main::main(): initializing trace\n");
+    wlm_trace_init(&ctx);
+
     wlm_log_debug(&ctx, "main::main(): initializing stream\n");
     wlm_stream_init(&ctx);
 
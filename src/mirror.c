@@ -9,6 +9,129 @@
 #include <wlm/util.h>
 #include <wlm/proto/linux-dmabuf-unstable-v1.h>
 
+// --- capture pacing ---
+
+static uint64_t source_interval_ns(ctx_t * ctx) {
+    if (ctx->mirror.current_target == NULL || ctx->mirror.current_target->refresh <= 0) return 0;
+
+    // refresh is in mHz
+    return 1000000000000 / ctx->mirror.current_target->refresh;
+}
+
+static uint64_t capture_interval_ns(ctx_t * ctx) {
+    uint64_t interval = 0;
+    if (ctx->opt.capture_rate == CAPTURE_RATE_FIXED) {
+        interval = 1000000000 / ctx->opt.capture_fps;
+    } else if (ctx->opt.capture_rate == CAPTURE_RATE_SOURCE) {
+        interval = source_interval_ns(ctx);
+    }
+
+    if (ctx->opt.max_fps != 0) {
+        uint64_t min_interval = 1000000000 / ctx->opt.max_fps;
+        if (interval < min_interval) interval = min_interval;
+    }
+
+    return interval;
+}
+
+static uint64_t align_to_source(ctx_t * ctx, uint64_t time_ns) {
+    uint64_t source_interval = source_interval_ns(ctx);
+    uint64_t presented = ctx->mirror.source_presented_ns;
+    if (source_interval == 0 || presented == 0 || presented > time_ns) return time_ns;
+
+    // round up to the next source refresh, a new frame is available right after it
+    uint64_t cycles = (time_ns - presented + source_interval - 1) / source_interval;
+    return presented + cycles * source_interval;
+}
+
+static void schedule_capture(ctx_t * ctx) {
+    wlm_event_arm_timer(ctx, &ctx->mirror.capture_timer, ctx->mirror.next_capture_ns);
+    ctx->mirror.capture_scheduled = true;
+}
+
+static void backend_trial_check(ctx_t * ctx);
+static void request_capture(ctx_t * ctx) {
+    if (ctx->mirror.capture_scheduled) return;
+
+    // move on to the next backend once the current trial is over
+    if (ctx->mirror.backend_trial.active) backend_trial_check(ctx);
+
+    // check if backend failure count exceeded
+    if (ctx->mirror.backend != NULL) wlm_mirror_stats_fail_count(ctx, ctx->mirror.backend->fail_count);
+    if (ctx->mirror.backend != NULL && ctx->mirror.backend->fail_count >= MIRROR_BACKEND_FATAL_FAILCOUNT) {
+        wlm_mirror_backend_fail(ctx);
+    }
+
+    uint64_t interval = capture_interval_ns(ctx);
+    if (interval != 0) {
+        uint64_t now = wlm_event_now_ns();
+        if (now < ctx->mirror.next_capture_ns) {
+            // too early, capture once the timer expires
+            schedule_capture(ctx);
+            return;
+        }
+
+        // stay on the capture grid unless we fell behind by a whole interval
+        if (now - ctx->mirror.next_capture_ns < interval) {
+            ctx->mirror.next_capture_ns += interval;
+        } else {
+            ctx->mirror.next_capture_ns = now + interval;
+        }
+
+        if (ctx->opt.capture_rate == CAPTURE_RATE_SOURCE) {
+            ctx->mirror.next_capture_ns = align_to_source(ctx, ctx->mirror.next_capture_ns);
+        }
+    }
+
+    if (ctx->mirror.backend == NULL || ctx->opt.freeze) return;
+
+    // request new screen capture from backend
+    // - the frame is drawn once the backend reports it ready
+    // - a request while a capture is in flight is queued by the backend
+    bool was_pending = ctx->mirror.capture_pending;
+    ctx->mirror.capture_pending = ctx->mirror.backend->do_capture(ctx) || was_pending;
+    if (ctx->mirror.capture_pending && !was_pending) {
+        ctx->mirror.stats.frames_captured++;
+        wlm_mirror_timing_mark(ctx, WLM_TIMING_CAPTURE_REQUESTED);
+    }
+}
+
+static void on_capture_timer(ctx_t * ctx, uint32_t events) {
+    ctx->mirror.capture_scheduled = false;
+
+    // don't attempt to capture if window is already closing
+    if (ctx->wl.closing) return;
+
+    request_capture(ctx);
+
+    if (ctx->opt.capture_rate == CAPTURE_RATE_FIXED) {
+        // keep capturing at the fixed rate
+        if (!ctx->mirror.capture_scheduled) schedule_capture(ctx);
+    } else if (!ctx->mirror.capture_pending && !ctx->mirror.capture_scheduled) {
+        // no capture started, redraw to keep frame callbacks coming
+        wlm_egl_draw_frame(ctx);
+    }
+
+    (void)events;
+}
+
+static void pacing_options_updated(ctx_t * ctx) {
+    bool was_scheduled = ctx->mirror.capture_scheduled;
+
+    // restart pacing, the next capture is due immediately
+    wlm_event_disarm_timer(ctx, &ctx->mirror.capture_timer);
+    ctx->mirror.capture_scheduled = false;
+    ctx->mirror.next_capture_ns = 0;
+    ctx->mirror.source_presented_ns = 0;
+
+    if (ctx->opt.capture_rate == CAPTURE_RATE_FIXED) {
+        schedule_capture(ctx);
+    } else if (was_scheduled) {
+        // the frame callback that deferred the capture won't come again
+        on_capture_timer(ctx, 0);
+    }
+}
+
 // --- frame_callback event handlers ---
 
 static const struct wl_callback_listener frame_callback_listener;
@@ -17,10 +140,12 @@ static void on_frame(
     void * data, struct wl_callback * frame_callback, uint32_t msec
 ) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror::on_frame");
 
     // destroy frame callback
     wl_callback_destroy(ctx->mirror.frame_callback);
     ctx->mirror.frame_callback = NULL;
+    ctx->mirror.window_frame_done = true;
 
     // don't attempt to render if window is already closing
     if (ctx->wl.closing) {
@@ -32,23 +157,19 @@ static void on_frame(
     ctx->mirror.frame_callback = wl_surface_frame(ctx->wl.surface);
     wl_callback_add_listener(ctx->mirror.frame_callback, &frame_callback_listener, (void *)ctx);
 
-    if (ctx->mirror.backend != NULL) {
-        // check if backend failure count exceeded
-        if (ctx->mirror.backend->fail_count >= MIRROR_BACKEND_FATAL_FAILCOUNT) {
-            wlm_mirror_backend_fail(ctx);
-        }
-
-        if (!ctx->opt.freeze) {
-            // request new screen capture from backend
-            ctx->mirror.backend->do_capture(ctx);
-        }
+    // capture in step with the window, otherwise the capture timer drives captures
+    if (ctx->opt.capture_rate != CAPTURE_RATE_FIXED) {
+        request_capture(ctx);
     }
 
-    // wait for events
-    // - screencapture events from backend
-    wl_display_roundtrip(ctx->wl.display);
-
-    wlm_egl_draw_frame(ctx);
+    // redraw immediately if no new frame is on its way
+    // - keeps frame callbacks coming while frozen or while the backend is still setting up
+    // - the capture timer is always armed at a fixed rate, don't wait for it to fire
+    bool frame_due = ctx->mirror.capture_pending ||
+        (ctx->mirror.capture_scheduled && ctx->opt.capture_rate != CAPTURE_RATE_FIXED);
+    if (!frame_due) {
+        wlm_egl_draw_frame(ctx);
+    }
 
     (void)frame_callback;
     (void)msec;
@@ -61,6 +182,7 @@ static const struct wl_callback_listener frame_callback_listener = {
 // --- init_mirror ---
 
 static fallback_backend_t auto_fallback_backends[];
+static void on_backend_trial_timer(ctx_t * ctx, uint32_t events);
 void wlm_mirror_init(ctx_t * ctx) {
     // initialize context structure
     ctx->mirror.current_target = NULL;
@@ -71,9 +193,46 @@ void wlm_mirror_init(ctx_t * ctx) {
     ctx->mirror.backend = NULL;
     ctx->mirror.fallback_backends = auto_fallback_backends;
     ctx->mirror.auto_backend_index = 0;
-
+    ctx->mirror.cached_backend = NULL;
+    ctx->mirror.backend_trial.active = false;
+    ctx->mirror.backend_trial.index = 0;
+    ctx->mirror.backend_trial.start_ns = 0;
+    ctx->mirror.backend_trial.frames_seen = 0;
+    ctx->mirror.backend_trial.frames = 0;
+    ctx->mirror.backend_trial.failures = 0;
+    ctx->mirror.backend_trial.total_ns = 0;
+    ctx->mirror.backend_trial.best_index = 0;
+    ctx->mirror.backend_trial.best_score_ns = 0;
+    ctx->mirror.backend_trial.timer.next = NULL;
+    ctx->mirror.backend_trial.timer.fd = -1;
+    ctx->mirror.backend_trial.timer.on_event = on_backend_trial_timer;
+    ctx->mirror.backend_trial.timer.on_each = NULL;
+
+    ctx->mirror.capture_timer.next = NULL;
+    ctx->mirror.capture_timer.fd = -1;
+    ctx->mirror.capture_timer.on_event = on_capture_timer;
+    ctx->mirror.capture_timer.on_each = NULL;
+    ctx->mirror.next_capture_ns = 0;
+    ctx->mirror.source_presented_ns = 0;
+    wlm_mirror_timing_init(ctx);
+    wlm_mirror_stats_init(ctx);
+    ctx->mirror.cache.path = NULL;
+    ctx->mirror.cache.backend[0] = '\0';
+    ctx->mirror.cache.stored = false;
+
+    ctx->mirror.capture_pending = false;
+    ctx->mirror.capture_next = false;
+    ctx->mirror.capture_scheduled = false;
+    ctx->mirror.window_frame_done = true;
     ctx->mirror.initialized = true;
 
+    // add capture timer, fixed rate captures start right away
+    wlm_event_add_timer(ctx, &ctx->mirror.capture_timer);
+    wlm_event_add_timer(ctx, &ctx->mirror.backend_trial.timer);
+    if (ctx->opt.capture_rate == CAPTURE_RATE_FIXED) {
+        schedule_capture(ctx);
+    }
+
     // finding target output
     if (!wlm_opt_find_output(ctx, &ctx->mirror.current_target, &ctx->mirror.current_region)) {
         wlm_log_error("mirror::init(): failed to find output\n");
@@ -91,10 +250,8 @@ void wlm_mirror_init(ctx_t * ctx) {
 // --- auto backend handler
 
 static fallback_backend_t auto_fallback_backends[] = {
-#ifdef WITH_GBM
     { "extcopy-dmabuf", wlm_mirror_extcopy_dmabuf_init },
     { "screencopy-dmabuf", wlm_mirror_screencopy_dmabuf_init },
-#endif
     { "export-dmabuf", wlm_mirror_export_dmabuf_init },
     { "extcopy-shm", wlm_mirror_extcopy_shm_init },
     { "screencopy-shm", wlm_mirror_screencopy_shm_init },
@@ -102,21 +259,26 @@ static fallback_backend_t auto_fallback_backends[] = {
 };
 
 static fallback_backend_t auto_screencopy_backends[] = {
-#ifdef WITH_GBM
     { "screencopy-dmabuf", wlm_mirror_screencopy_dmabuf_init },
-#endif
     { "screencopy-shm", wlm_mirror_screencopy_shm_init },
     { NULL, NULL }
 };
 
 static fallback_backend_t auto_extcopy_backends[] = {
-#ifdef WITH_GBM
     { "extcopy-dmabuf", wlm_mirror_extcopy_dmabuf_init },
-#endif
     { "extcopy-shm", wlm_mirror_extcopy_shm_init },
     { NULL, NULL }
 };
 
+static void backend_cleanup(ctx_t * ctx) {
+    if (ctx->mirror.backend == NULL) return;
+
+    ctx->mirror.backend->do_cleanup(ctx);
+
+    // a capture in flight on the old backend never completes
+    wlm_mirror_frame_dropped(ctx);
+}
+
 static void auto_backend_fallback(ctx_t * ctx) {
     while (true) {
         // get next backend
@@ -127,14 +289,21 @@ static void auto_backend_fallback(ctx_t * ctx) {
             wlm_exit_fail(ctx);
         }
 
+        // the cached backend was tried first and failed
+        if (next_backend == ctx->mirror.cached_backend) {
+            ctx->mirror.auto_backend_index++;
+            continue;
+        }
+
         if (index > 0) {
+            ctx->mirror.stats.backend_fallbacks++;
             wlm_log_warn("mirror::auto_backend_fallback(): falling back to backend %s\n", next_backend->name);
         } else {
             wlm_log_debug(ctx, "mirror::auto_backend_fallback(): selecting backend %s\n", next_backend->name);
         }
 
         // uninitialize previous backend
-        if (ctx->mirror.backend != NULL) ctx->mirror.backend->do_cleanup(ctx);
+        backend_cleanup(ctx);
 
         // initialize next backend
         next_backend->init(ctx);
@@ -147,17 +316,192 @@ static void auto_backend_fallback(ctx_t * ctx) {
     }
 }
 
+static bool cached_backend_init(ctx_t * ctx) {
+    const char * cached = wlm_mirror_cache_backend(ctx);
+    if (cached == NULL) return false;
+
+    // only use cached backends that are still compiled in
+    for (size_t i = 0; ctx->mirror.fallback_backends[i].name != NULL; i++) {
+        fallback_backend_t * backend = &ctx->mirror.fallback_backends[i];
+        if (strcmp(backend->name, cached) != 0) continue;
+
+        wlm_log_debug(ctx, "mirror::cached_backend_init(): trying cached backend %s\n", backend->name);
+        ctx->mirror.cached_backend = backend;
+        backend->init(ctx);
+
+        // later failures walk the whole fallback order except for this backend
+        ctx->mirror.auto_backend_index = 0;
+        return ctx->mirror.backend != NULL;
+    }
+
+    return false;
+}
+
+// --- auto-fastest backend trial ---
+
+// frames excluded from measurement, they include buffer allocation and setup
+#define BACKEND_TRIAL_WARMUP_FRAMES 2
+// measured frames per backend
+#define BACKEND_TRIAL_FRAMES 8
+// backends that drop this many frames during the trial are skipped
+#define BACKEND_TRIAL_MAX_FAILURES 3
+// give up on backends that don't produce enough frames in time
+#define BACKEND_TRIAL_TIMEOUT_NS 1000000000ull
+
+static void backend_trial_start(ctx_t * ctx) {
+    mirror_backend_trial_t * trial = &ctx->mirror.backend_trial;
+    trial->start_ns = wlm_event_now_ns();
+    wlm_event_arm_timer(ctx, &trial->timer, trial->start_ns + BACKEND_TRIAL_TIMEOUT_NS);
+    trial->frames_seen = 0;
+    trial->frames = 0;
+    trial->failures = 0;
+    trial->total_ns = 0;
+
+    // the measured backend is done, none is left running once all were tried
+    backend_cleanup(ctx);
+
+    // initialize the next backend that loads successfully
+    // - backends that fail while initializing end their trial through the timer
+    while (ctx->mirror.fallback_backends[trial->index].name != NULL) {
+        fallback_backend_t * backend = &ctx->mirror.fallback_backends[trial->index];
+
+        // the cached backend was tried first and failed
+        if (backend == ctx->mirror.cached_backend) {
+            trial->index++;
+            continue;
+        }
+
+        wlm_log_debug(ctx, "mirror::backend_trial_start(): trying backend %s\n", backend->name);
+
+        backend->init(ctx);
+        if (ctx->mirror.backend != NULL) break;
+
+        trial->index++;
+    }
+}
+
+static void backend_trial_finish(ctx_t * ctx) {
+    mirror_backend_trial_t * trial = &ctx->mirror.backend_trial;
+    trial->active = false;
+    wlm_event_disarm_timer(ctx, &trial->timer);
+    backend_cleanup(ctx);
+
+    if (trial->best_score_ns == 0) {
+        wlm_log_error("mirror::backend_trial_finish(): no working backend found, exiting\n");
+        wlm_exit_fail(ctx);
+    }
+
+    fallback_backend_t * best = &ctx->mirror.fallback_backends[trial->best_index];
+    wlm_log_debug(ctx, "mirror::backend_trial_finish(): selecting backend %s\n", best->name);
+
+    // later failures fall back to the backends after the winner
+    ctx->mirror.auto_backend_index = trial->best_index + 1;
+    best->init(ctx);
+    if (ctx->mirror.backend == NULL) auto_backend_fallback(ctx);
+}
+
+static void backend_trial_next(ctx_t * ctx) {
+    mirror_backend_trial_t * trial = &ctx->mirror.backend_trial;
+    const char * name = ctx->mirror.fallback_backends[trial->index].name;
+
+    if (trial->frames == 0 || trial->failures >= BACKEND_TRIAL_MAX_FAILURES) {
+        wlm_log_debug(ctx, "mirror::backend_trial_next(): backend %s failed the trial (%zu frames, %zu failures)\n",
+            name, trial->frames, trial->failures);
+    } else {
+        // each dropped frame costs another average frame time
+        uint64_t frame_ns = trial->total_ns / trial->frames;
+        uint64_t score_ns = frame_ns * (trial->frames + trial->failures) / trial->frames;
+        if (score_ns == 0) score_ns = 1;
+
+        wlm_log_debug(ctx, "mirror::backend_trial_next(): backend %s took %.3f ms per frame (%zu frames, %zu failures)\n",
+            name, frame_ns / 1e6, trial->frames, trial->failures);
+
+        if (trial->best_score_ns == 0 || score_ns < trial->best_score_ns) {
+            trial->best_index = trial->index;
+            trial->best_score_ns = score_ns;
+        }
+    }
+
+    trial->index++;
+    backend_trial_start(ctx);
+    if (ctx->mirror.backend == NULL) backend_trial_finish(ctx);
+}
+
+static void backend_trial_begin(ctx_t * ctx) {
+    mirror_backend_trial_t * trial = &ctx->mirror.backend_trial;
+    trial->active = true;
+    trial->index = 0;
+    trial->best_index = 0;
+    trial->best_score_ns = 0;
+
+    backend_trial_start(ctx);
+    if (ctx->mirror.backend == NULL) {
+        trial->active = false;
+        wlm_event_disarm_timer(ctx, &trial->timer);
+        wlm_log_error("mirror::backend_trial_begin(): no working backend found, exiting\n");
+        wlm_exit_fail(ctx);
+    }
+}
+
+static void backend_trial_check(ctx_t * ctx) {
+    mirror_backend_trial_t * trial = &ctx->mirror.backend_trial;
+
+    // timeouts are handled by the trial timer
+    bool done = trial->frames >= BACKEND_TRIAL_FRAMES;
+    bool failed = trial->failures >= BACKEND_TRIAL_MAX_FAILURES;
+    if (done || failed) backend_trial_next(ctx);
+}
+
+static void on_backend_trial_timer(ctx_t * ctx, uint32_t events) {
+    if (!ctx->mirror.backend_trial.active) return;
+
+    // a stalled backend never completes a capture, move on without waiting for one
+    // - dropping its capture in flight redraws and restarts the frame callback loop
+    // - failed backends expire the timer right away to be replaced from here
+    if (ctx->mirror.backend_trial.failures < BACKEND_TRIAL_MAX_FAILURES) {
+        wlm_log_debug(ctx, "mirror::on_backend_trial_timer(): backend %s timed out\n",
+            ctx->mirror.fallback_backends[ctx->mirror.backend_trial.index].name);
+    }
+    backend_trial_next(ctx);
+
+    (void)events;
+}
+
+static void backend_trial_frame(ctx_t * ctx) {
+    mirror_backend_trial_t * trial = &ctx->mirror.backend_trial;
+    uint64_t requested = wlm_mirror_timing_requested(ctx);
+    if (requested == 0) return;
+
+    trial->frames_seen++;
+    if (trial->frames_seen <= BACKEND_TRIAL_WARMUP_FRAMES) return;
+
+    // capture request to imported texture
+    trial->frames++;
+    trial->total_ns += wlm_event_now_ns() - requested;
+}
+
 
 // --- init_mirror_backend ---
 
 void wlm_mirror_backend_init(ctx_t * ctx) {
-    if (ctx->mirror.backend != NULL) ctx->mirror.backend->do_cleanup(ctx);
+    backend_cleanup(ctx);
+    ctx->mirror.backend_trial.active = false;
+    ctx->mirror.cached_backend = NULL;
+    wlm_mirror_cache_cleanup(ctx);
 
     switch (ctx->opt.backend) {
         case BACKEND_AUTO:
             ctx->mirror.fallback_backends = auto_fallback_backends;
             ctx->mirror.auto_backend_index = 0;
-            auto_backend_fallback(ctx);
+            wlm_mirror_cache_init(ctx, "auto");
+            if (!cached_backend_init(ctx)) auto_backend_fallback(ctx);
+            break;
+
+        case BACKEND_AUTO_FASTEST:
+            ctx->mirror.fallback_backends = auto_fallback_backends;
+            ctx->mirror.auto_backend_index = 0;
+            wlm_mirror_cache_init(ctx, "auto-fastest");
+            if (!cached_backend_init(ctx)) backend_trial_begin(ctx);
             break;
 
         case BACKEND_EXPORT_DMABUF:
@@ -312,12 +656,116 @@ void wlm_mirror_options_updated(ctx_t * ctx) {
     if (ctx->mirror.backend != NULL && ctx->mirror.backend->on_options_updated != NULL) {
         ctx->mirror.backend->on_options_updated(ctx);
     }
+
+    pacing_options_updated(ctx);
+}
+
+// --- capture_early ---
+
+bool wlm_mirror_capture_early(ctx_t * ctx) {
+    // only captures paced by the window can run ahead
+    // - the capture timer keeps fixed and limited rates on their grid
+    if (ctx->opt.capture_rate == CAPTURE_RATE_FIXED || capture_interval_ns(ctx) != 0) return false;
+    if (ctx->wl.closing || ctx->opt.freeze || ctx->mirror.capture_scheduled) return false;
+
+    // stop capturing ahead while the window is hidden
+    // - the compositor stops sending frame callbacks, resume with the next one
+    return ctx->mirror.window_frame_done;
+}
+
+// --- capture_started ---
+
+void wlm_mirror_capture_started(ctx_t * ctx) {
+    // the next capture stays in flight after the current frame is drawn
+    ctx->mirror.capture_next = true;
+    ctx->mirror.stats.frames_captured++;
+    wlm_mirror_timing_mark(ctx, WLM_TIMING_CAPTURE_REQUESTED);
+}
+
+// --- frame_ready ---
+
+void wlm_mirror_frame_ready(ctx_t * ctx) {
+    ctx->mirror.capture_pending = ctx->mirror.capture_next;
+    ctx->mirror.capture_next = false;
+    if (ctx->mirror.backend_trial.active) {
+        backend_trial_frame(ctx);
+    } else if (ctx->mirror.backend != NULL) {
+        wlm_mirror_cache_store(ctx, ctx->mirror.backend->name);
+    }
+    wlm_mirror_timing_mark(ctx, WLM_TIMING_IMPORT_DONE);
+    wlm_egl_hud_frame_captured(ctx);
+
+    // don't attempt to render if window is already closing
+    if (ctx->wl.closing) return;
+
+    // draw and commit the new frame right away
+    ctx->mirror.window_frame_done = false;
+    ctx->mirror.stats.frames_drawn++;
+    wlm_mirror_timing_present_begin(ctx);
+    wlm_egl_draw_frame(ctx);
+    wlm_mirror_timing_present_end(ctx);
+}
+
+// --- frame_dropped ---
+
+void wlm_mirror_frame_dropped(ctx_t * ctx) {
+    if (!ctx->mirror.capture_pending) return;
+    ctx->mirror.capture_pending = false;
+    ctx->mirror.capture_next = false;
+    ctx->mirror.stats.frames_dropped++;
+    if (ctx->mirror.backend_trial.active) ctx->mirror.backend_trial.failures++;
+    wlm_mirror_timing_reset(ctx);
+
+    // don't attempt to render if window is already closing
+    if (ctx->wl.closing) return;
+
+    // redraw the previous frame to request the next frame callback
+    wlm_egl_draw_frame(ctx);
+}
+
+// --- frame_unchanged ---
+
+void wlm_mirror_frame_unchanged(ctx_t * ctx) {
+    ctx->mirror.capture_pending = false;
+    ctx->mirror.capture_next = false;
+    wlm_mirror_timing_reset(ctx);
+
+    // don't attempt to capture if window is already closing
+    if (ctx->wl.closing) return;
+
+    // the texture still holds the current screen contents, capture again without redrawing
+    // - goes through capture pacing like any other capture request
+    request_capture(ctx);
+}
+
+// --- source_presented ---
+
+void wlm_mirror_source_presented(ctx_t * ctx, uint32_t sec_hi, uint32_t sec_lo, uint32_t nsec) {
+    uint64_t sec = ((uint64_t)sec_hi << 32) | sec_lo;
+    uint64_t presented = sec * 1000000000 + nsec;
+
+    // timestamps are expected in CLOCK_MONOTONIC, ignore them if they are clearly not
+    uint64_t now = wlm_event_now_ns();
+    if (presented > now || now - presented > 1000000000) {
+        presented = 0;
+    }
+
+    ctx->mirror.source_presented_ns = presented;
+    wlm_mirror_timing_source(ctx, presented);
+    wlm_mirror_timing_mark(ctx, WLM_TIMING_BUFFER_READY);
 }
 
 // --- backend_fail ---
 
 void wlm_mirror_backend_fail(ctx_t * ctx) {
-    if (ctx->opt.backend == BACKEND_AUTO) {
+    if (ctx->mirror.backend_trial.active) {
+        // disqualify the backend on trial and try the next one from the trial timer
+        // - the failing backend may still be running its handler, don't free it from here
+        ctx->mirror.backend_trial.failures = BACKEND_TRIAL_MAX_FAILURES;
+        wlm_event_arm_timer(ctx, &ctx->mirror.backend_trial.timer, 0);
+    } else if (ctx->opt.backend == BACKEND_AUTO || ctx->opt.backend == BACKEND_AUTO_FASTEST) {
+        // the cached backend stopped working, remember the replacement instead
+        ctx->mirror.cache.stored = false;
         auto_backend_fallback(ctx);
     } else {
         wlm_exit_fail(ctx);
@@ -333,6 +781,10 @@ void wlm_mirror_cleanup(ctx_t * ctx) {
 
     if (ctx->mirror.backend != NULL) ctx->mirror.backend->do_cleanup(ctx);
     if (ctx->mirror.frame_callback != NULL) wl_callback_destroy(ctx->mirror.frame_callback);
+    wlm_event_remove_timer(ctx, &ctx->mirror.capture_timer);
+    wlm_event_remove_timer(ctx, &ctx->mirror.backend_trial.timer);
+    wlm_mirror_timing_cleanup(ctx);
+    wlm_mirror_cache_cleanup(ctx);
 
     ctx->mirror.initialized = false;
 }
@@ -0,0 +1,169 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <wlm/context.h>
+#include <wlm/mirror/cache.h>
+
+// --- wlm_mirror_cache_hash ---
+
+uint64_t wlm_mirror_cache_hash(uint64_t hash, const char * data) {
+    if (data == NULL) data = "";
+
+    for (const char * c = data; *c != '\0'; c++) {
+        hash ^= (uint8_t)*c;
+        hash *= 0x100000001b3ull;
+    }
+
+    // separator, so that "ab" + "c" and "a" + "bc" differ
+    hash ^= 0xff;
+    hash *= 0x100000001b3ull;
+    return hash;
+}
+
+// --- helper functions ---
+
+static bool make_dir(const char * path) {
+    if (mkdir(path, 0700) == 0 || errno == EEXIST) return true;
+
+    wlm_log_warn("mirror::cache::make_dir(): failed to create %s: %s\n", path, strerror(errno));
+    return false;
+}
+
+static char * cache_dir(void) {
+    // $XDG_CACHE_HOME must be absolute, otherwise it is ignored
+    const char * cache_home = getenv("XDG_CACHE_HOME");
+    char * dir = NULL;
+    if (cache_home != NULL && cache_home[0] == '/') {
+        if (!make_dir(cache_home)) return NULL;
+        if (asprintf(&dir, "%s/wl-mirror", cache_home) == -1) return NULL;
+    } else {
+        const char * home = getenv("HOME");
+        if (home == NULL || home[0] != '/') return NULL;
+
+        char * fallback_home = NULL;
+        if (asprintf(&fallback_home, "%s/.cache", home) == -1) return NULL;
+        bool created = make_dir(fallback_home);
+        free(fallback_home);
+        if (!created) return NULL;
+
+        if (asprintf(&dir, "%s/.cache/wl-mirror", home) == -1) return NULL;
+    }
+
+    if (!make_dir(dir)) {
+        free(dir);
+        return NULL;
+    }
+
+    return dir;
+}
+
+static uint64_t cache_key(ctx_t * ctx) {
+    // the working backend depends on the compositor and the GPU driver
+    uint64_t hash = WLM_MIRROR_CACHE_HASH_INIT;
+    char globals[17];
+    snprintf(globals, sizeof globals, "%016llx", (unsigned long long)ctx->wl.globals_hash);
+    hash = wlm_mirror_cache_hash(hash, globals);
+    hash = wlm_mirror_cache_hash(hash, (const char *)glGetString(GL_VENDOR));
+    hash = wlm_mirror_cache_hash(hash, (const char *)glGetString(GL_RENDERER));
+    hash = wlm_mirror_cache_hash(hash, (const char *)glGetString(GL_VERSION));
+    return hash;
+}
+
+static void read_backend(ctx_t * ctx) {
+    ctx_mirror_cache_t * cache = &ctx->mirror.cache;
+
+    FILE * file = fopen(cache->path, "r");
+    if (file == NULL) return;
+
+    char line[WLM_MIRROR_CACHE_MAX_NAME];
+    if (fgets(line, sizeof line, file) != NULL) {
+        line[strcspn(line, "\n")] = '\0';
+        memcpy(cache->backend, line, sizeof cache->backend);
+    }
+
+    fclose(file);
+}
+
+// --- wlm_mirror_cache_init ---
+
+void wlm_mirror_cache_init(ctx_t * ctx, const char * mode) {
+    ctx_mirror_cache_t * cache = &ctx->mirror.cache;
+    wlm_mirror_cache_cleanup(ctx);
+
+    char * dir = cache_dir();
+    if (dir == NULL) {
+        wlm_log_debug(ctx, "mirror::cache::init(): no cache directory, backend cache disabled\n");
+        return;
+    }
+
+    int status = asprintf(&cache->path, "%s/%s-%016llx", dir, mode, (unsigned long long)cache_key(ctx));
+    free(dir);
+    if (status == -1) {
+        cache->path = NULL;
+        wlm_log_warn("mirror::cache::init(): failed to allocate cache path\n");
+        return;
+    }
+
+    read_backend(ctx);
+    wlm_log_debug(ctx, "mirror::cache::init(): cache file %s, cached backend %s\n",
+        cache->path, cache->backend[0] == '\0' ? "none" : cache->backend);
+}
+
+// --- wlm_mirror_cache_backend ---
+
+const char * wlm_mirror_cache_backend(ctx_t * ctx) {
+    if (ctx->mirror.cache.backend[0] == '\0') return NULL;
+    return ctx->mirror.cache.backend;
+}
+
+// --- wlm_mirror_cache_store ---
+
+void wlm_mirror_cache_store(ctx_t * ctx, const char * backend) {
+    ctx_mirror_cache_t * cache = &ctx->mirror.cache;
+    if (cache->path == NULL || cache->stored) return;
+    cache->stored = true;
+
+    // avoid rewriting the file on every start
+    if (strcmp(cache->backend, backend) == 0) return;
+
+    // write to a temporary file first, so concurrent instances never read partial files
+    char * tmp_path = NULL;
+    if (asprintf(&tmp_path, "%s.tmp", cache->path) == -1) {
+        wlm_log_warn("mirror::cache::store(): failed to allocate temporary path\n");
+        return;
+    }
+
+    FILE * file = fopen(tmp_path, "w");
+    if (file == NULL) {
+        wlm_log_warn("mirror::cache::store(): failed to open %s: %s\n", tmp_path, strerror(errno));
+        free(tmp_path);
+        return;
+    }
+
+    bool written = fprintf(file, "%s\n", backend) >= 0;
+    written = fclose(file) == 0 && written;
+    if (!written || rename(tmp_path, cache->path) == -1) {
+        wlm_log_warn("mirror::cache::store(): failed to write %s\n", cache->path);
+        remove(tmp_path);
+        free(tmp_path);
+        return;
+    }
+    free(tmp_path);
+
+    wlm_log_debug(ctx, "mirror::cache::store(): cached backend %s\n", backend);
+    snprintf(cache->backend, sizeof cache->backend, "%s", backend);
+}
+
+// --- wlm_mirror_cache_cleanup ---
+
+void wlm_mirror_cache_cleanup(ctx_t * ctx) {
+    ctx_mirror_cache_t * cache = &ctx->mirror.cache;
+
+    free(cache->path);
+    cache->path = NULL;
+    cache->backend[0] = '\0';
+    cache->stored = false;
+}
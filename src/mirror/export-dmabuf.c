@@ -17,28 +17,26 @@ static void dmabuf_frame_cleanup(export_dmabuf_mirror_backend_t * backend) {
     // close dmabuf file descriptors
     for (unsigned int i = 0; i < backend->dmabuf.planes; i++) {
         if (backend->dmabuf.fds[i] != -1) close(backend->dmabuf.fds[i]);
+        backend->dmabuf.fds[i] = -1;
+        backend->dmabuf.offsets[i] = 0;
+        backend->dmabuf.strides[i] = 0;
     }
 
-    free(backend->dmabuf.fds);
-    free(backend->dmabuf.offsets);
-    free(backend->dmabuf.strides);
-
     backend->dmabuf.width = 0;
     backend->dmabuf.height = 0;
     backend->dmabuf.drm_format = 0;
     backend->dmabuf.planes = 0;
-    backend->dmabuf.fds = NULL;
-    backend->dmabuf.offsets = NULL;
-    backend->dmabuf.strides = NULL;
     backend->dmabuf.modifier = 0;
 }
 
-static void backend_cancel(export_dmabuf_mirror_backend_t * backend) {
+static void backend_cancel(ctx_t * ctx, export_dmabuf_mirror_backend_t * backend) {
     wlm_log_error("mirror-export-dmabuf::backend_cancel(): cancelling capture due to error\n");
 
     dmabuf_frame_cleanup(backend);
     backend->state = STATE_CANCELED;
     backend->header.fail_count++;
+
+    wlm_mirror_frame_dropped(ctx);
 }
 
 // --- dmabuf_frame event handlers ---
@@ -50,16 +48,17 @@ static void on_frame(
     uint32_t mod_high, uint32_t mod_low, uint32_t num_objects
 ) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-export-dmabuf::on_frame");
     export_dmabuf_mirror_backend_t * backend = (export_dmabuf_mirror_backend_t *)ctx->mirror.backend;
 
     wlm_log_debug(ctx, "mirror-export-dmabuf::on_frame(): received %dx%d frame with %d objects\n", width, height, num_objects);
     if (backend->state != STATE_WAIT_FRAME) {
         wlm_log_error("mirror-export-dmabuf::on_frame(): got frame while in state %d\n", backend->state);
-        backend_cancel(backend);
+        backend_cancel(ctx, backend);
         return;
     } else if (num_objects > MAX_PLANES) {
         wlm_log_error("mirror-export-dmabuf::on_frame(): got frame with more than %d objects\n", MAX_PLANES);
-        backend_cancel(backend);
+        backend_cancel(ctx, backend);
         return;
     }
 
@@ -83,16 +82,7 @@ static void on_frame(
         fprintf(stderr, "}\n");
     }
 
-    backend->dmabuf.planes = 0;
-    backend->dmabuf.fds = malloc(num_objects * sizeof (int));
-    backend->dmabuf.offsets = malloc(num_objects * sizeof (uint32_t));
-    backend->dmabuf.strides = malloc(num_objects * sizeof (uint32_t));
     backend->dmabuf.modifier = ((uint64_t)mod_high << 32) | mod_low;
-    if (backend->dmabuf.fds == NULL || backend->dmabuf.offsets == NULL) {
-        wlm_log_error("mirror-export-dmabuf::on_frame(): failed to allocate dmabuf storage\n");
-        backend_cancel(backend);
-        return;
-    }
 
     // save dmabuf frame info
     backend->x = x;
@@ -125,6 +115,7 @@ static void on_object(
     uint32_t offset, uint32_t stride, uint32_t plane_index
 ) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-export-dmabuf::on_object");
     export_dmabuf_mirror_backend_t * backend = (export_dmabuf_mirror_backend_t *)ctx->mirror.backend;
 
     wlm_log_debug(ctx, "mirror-export-dmabuf::on_object(): fd=%d offset=% 10d stride=% 10d\n",
@@ -133,12 +124,12 @@ static void on_object(
     if (backend->state != STATE_WAIT_OBJECTS) {
         wlm_log_error("mirror-export-dmabuf::on_object(): got object while in state %d\n", backend->state);
         close(fd);
-        backend_cancel(backend);
+        backend_cancel(ctx, backend);
         return;
     } else if (index >= backend->dmabuf.planes) {
         wlm_log_error("mirror-export-dmabuf::on_object(): got object with out-of-bounds index %d\n", index);
         close(fd);
-        backend_cancel(backend);
+        backend_cancel(ctx, backend);
         return;
     }
 
@@ -162,20 +153,22 @@ static void on_ready(
     uint32_t sec_hi, uint32_t sec_lo, uint32_t nsec
 ) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-export-dmabuf::on_ready");
     export_dmabuf_mirror_backend_t * backend = (export_dmabuf_mirror_backend_t *)ctx->mirror.backend;
 
     wlm_log_debug(ctx, "mirror-export-dmabuf::on_ready(): frame is ready\n");
     if (backend->state != STATE_WAIT_READY) {
         wlm_log_error("dmabuf_frame: got ready while in state %d\n", backend->state);
-        backend_cancel(backend);
+        backend_cancel(ctx, backend);
         return;
     }
 
     bool invert_y = backend->buffer_flags & ZWP_LINUX_BUFFER_PARAMS_V1_FLAGS_Y_INVERT;
     // TODO: pass correct format entry
-    if (!wlm_egl_dmabuf_import(ctx, &backend->dmabuf, NULL, invert_y, false)) {
+    // - don't cache the image, it would keep the compositor's buffer alive after the frame is destroyed
+    if (!wlm_egl_dmabuf_import(ctx, &backend->dmabuf, NULL, invert_y, false, false)) {
         wlm_log_error("mirror-export-dmabuf::on_ready(): failed to import dmabuf\n");
-        backend_cancel(backend);
+        backend_cancel(ctx, backend);
         return;
     }
 
@@ -183,10 +176,13 @@ static void on_ready(
     backend->state = STATE_READY;
     backend->header.fail_count = 0;
 
+    // remember when the source produced this frame for capture pacing
+    wlm_mirror_source_presented(ctx, sec_hi, sec_lo, nsec);
+
+    // draw and commit the new frame
+    wlm_mirror_frame_ready(ctx);
+
     (void)frame;
-    (void)sec_hi;
-    (void)sec_lo;
-    (void)nsec;
 }
 
 static void on_cancel(
@@ -194,6 +190,7 @@ static void on_cancel(
     enum zwlr_export_dmabuf_frame_v1_cancel_reason reason
 ) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-export-dmabuf::on_cancel");
     export_dmabuf_mirror_backend_t * backend = (export_dmabuf_mirror_backend_t *)ctx->mirror.backend;
 
     wlm_log_debug(ctx, "mirror-export-dmabuf::on_cancel(): frame was canceled\n");
@@ -222,6 +219,8 @@ static void on_cancel(
             break;
     }
 
+    wlm_mirror_frame_dropped(ctx);
+
     (void)frame;
 }
 
@@ -234,7 +233,8 @@ static const struct zwlr_export_dmabuf_frame_v1_listener dmabuf_frame_listener =
 
 // --- backend event handlers ---
 
-static void do_capture(ctx_t * ctx) {
+static bool do_capture(ctx_t * ctx) {
+    WLM_TRACE_SCOPE(ctx, "mirror-export-dmabuf::do_capture");
     export_dmabuf_mirror_backend_t * backend = (export_dmabuf_mirror_backend_t *)ctx->mirror.backend;
 
     if (backend->state == STATE_READY || backend->state == STATE_CANCELED) {
@@ -255,7 +255,7 @@ static void do_capture(ctx_t * ctx) {
         if (backend->dmabuf_frame == NULL) {
             wlm_log_error("mirror-export-dmabuf::do_capture(): failed to create wlr_dmabuf_export_frame\n");
             wlm_mirror_backend_fail(ctx);
-            return;
+            return false;
         }
 
         // add wlr_dmabuf_export_frame event listener
@@ -266,6 +266,8 @@ static void do_capture(ctx_t * ctx) {
         zwlr_export_dmabuf_frame_v1_add_listener(backend->dmabuf_frame, &dmabuf_frame_listener, (void *)ctx);
     }
 
+    // capture in flight
+    return true;
 }
 
 static void do_cleanup(ctx_t * ctx) {
@@ -274,6 +276,9 @@ static void do_cleanup(ctx_t * ctx) {
     wlm_log_debug(ctx, "mirror-export-dmabuf::do_cleanup(): destroying mirror-export-dmabuf objects\n");
     dmabuf_frame_cleanup(backend);
 
+    // cached images keep compositor buffers alive
+    wlm_egl_dmabuf_clear_cache(ctx);
+
     free(backend);
     ctx->mirror.backend = NULL;
 }
@@ -295,6 +300,7 @@ void wlm_mirror_export_dmabuf_init(ctx_t * ctx) {
     }
 
     // initialize context structure
+    backend->header.name = "export-dmabuf";
     backend->header.do_capture = do_capture;
     backend->header.do_cleanup = do_cleanup;
     backend->header.on_options_updated = NULL;
@@ -310,9 +316,11 @@ void wlm_mirror_export_dmabuf_init(ctx_t * ctx) {
     backend->dmabuf.height = 0;
     backend->dmabuf.drm_format = 0;
     backend->dmabuf.planes = 0;
-    backend->dmabuf.fds = NULL;
-    backend->dmabuf.offsets = NULL;
-    backend->dmabuf.strides = NULL;
+    for (size_t i = 0; i < MAX_PLANES; i++) {
+        backend->dmabuf.fds[i] = -1;
+        backend->dmabuf.offsets[i] = 0;
+        backend->dmabuf.strides[i] = 0;
+    }
     backend->dmabuf.modifier = 0;
 
     backend->state = STATE_READY;
@@ -10,7 +10,6 @@
 
 static void extcopy_frame_cleanup(extcopy_mirror_backend_t * backend) {
     if (backend->capture_frame != NULL) ext_image_copy_capture_frame_v1_destroy(backend->capture_frame);
-    if (backend->frame_drm_modifiers != NULL) free(backend->frame_drm_modifiers);
 
     backend->capture_frame = NULL;
     backend->has_shm_format = false;
@@ -20,7 +19,7 @@ static void extcopy_frame_cleanup(extcopy_mirror_backend_t * backend) {
     backend->frame_shm_stride = 0;
     backend->frame_shm_format = 0;
     backend->frame_drm_format = 0;
-    backend->frame_drm_modifiers = NULL;
+    // NOTE: modifier array storage is kept for the next session
     backend->frame_num_drm_modifiers = 0;
 }
 
@@ -29,11 +28,18 @@ static void extcopy_session_cleanup(ctx_t * ctx, extcopy_mirror_backend_t * back
 
     if (backend->capture_session != NULL) ext_image_copy_capture_session_v1_destroy(backend->capture_session);
     if (backend->capture_source != NULL) ext_image_capture_source_v1_destroy(backend->capture_source);
-    if (wlm_wayland_dmabuf_get_buffer(ctx) != NULL) wlm_wayland_dmabuf_dealloc(ctx);
-    if (wlm_wayland_shm_get_buffer(ctx) != NULL) wlm_wayland_shm_dealloc(ctx);
+    if (wlm_wayland_shm_is_allocated(ctx)) wlm_wayland_shm_dealloc(ctx);
+    backend->shown_shm_handle = WLM_WAYLAND_SHM_INVALID_HANDLE;
+
+    // return capture buffer to the pool
+    wlm_wayland_dmabuf_release(ctx, backend->dmabuf_handle);
+    backend->dmabuf_handle = WLM_WAYLAND_DMABUF_INVALID_HANDLE;
 
     backend->capture_session = NULL;
     backend->capture_source = NULL;
+    backend->session_output = NULL;
+    backend->session_show_cursor = false;
+    backend->damage_tracked = false;
 }
 
 static void backend_cancel(ctx_t * ctx, extcopy_mirror_backend_t * backend) {
@@ -42,13 +48,17 @@ static void backend_cancel(ctx_t * ctx, extcopy_mirror_backend_t * backend) {
     extcopy_session_cleanup(ctx, backend);
 
     backend->state = STATE_CANCELED;
+    backend->capture_queued = false;
     backend->header.fail_count++;
+
+    wlm_mirror_frame_dropped(ctx);
 }
 
 // --- capture session event handlers ---
 
 static void on_capture_session_buffer_size(void * data, struct ext_image_copy_capture_session_v1 * session, uint32_t width, uint32_t height) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-extcopy::on_capture_session_buffer_size");
     extcopy_mirror_backend_t * backend = (extcopy_mirror_backend_t *)ctx->mirror.backend;
 
     wlm_log_debug(ctx, "mirror-extcopy::on_capture_session_buffer_size(): size = %dx%d\n", width, height);
@@ -60,6 +70,7 @@ static void on_capture_session_buffer_size(void * data, struct ext_image_copy_ca
 
 static void on_capture_session_shm_format(void * data, struct ext_image_copy_capture_session_v1 * session, uint32_t shm_format) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-extcopy::on_capture_session_shm_format");
     extcopy_mirror_backend_t * backend = (extcopy_mirror_backend_t *)ctx->mirror.backend;
 
     if (backend->use_dmabuf) return;
@@ -76,7 +87,7 @@ static void on_capture_session_shm_format(void * data, struct ext_image_copy_cap
             return;
         }
 
-        backend->frame_shm_stride = backend->frame_width * format->bpp;
+        backend->frame_shm_stride = backend->frame_width * (format->bpp / 8);
     } else {
         wlm_log_debug(ctx, "mirror-extcopy::on_capture_session_shm_format(): alternate shm_format = %x (ignoring)\n", shm_format);
         return;
@@ -87,6 +98,7 @@ static void on_capture_session_shm_format(void * data, struct ext_image_copy_cap
 
 static void on_capture_session_dmabuf_format(void * data, struct ext_image_copy_capture_session_v1 * session, uint32_t drm_format, struct wl_array * modifiers_arr) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-extcopy::on_capture_session_dmabuf_format");
     extcopy_mirror_backend_t * backend = (extcopy_mirror_backend_t *)ctx->mirror.backend;
 
     if (!backend->use_dmabuf) return;
@@ -106,26 +118,29 @@ static void on_capture_session_dmabuf_format(void * data, struct ext_image_copy_
         return;
     }
 
-    if (backend->frame_drm_modifiers != NULL) {
-        free(backend->frame_drm_modifiers);
-        backend->frame_drm_modifiers = NULL;
-    }
+    // only grow the modifiers array, sessions usually report the same list again
+    size_t num_modifiers = modifiers_arr->size / sizeof (uint64_t);
+    if (num_modifiers > backend->frame_drm_modifiers_capacity) {
+        uint64_t * modifiers = (uint64_t *)realloc(backend->frame_drm_modifiers, num_modifiers * sizeof (uint64_t));
+        if (modifiers == NULL) {
+            wlm_log_error("mirror-extcopy::on_capture_session_dmabuf_format(): failed to allocate modifiers array\n");
+            backend_cancel(ctx, backend);
+            return;
+        }
 
-    backend->frame_num_drm_modifiers = modifiers_arr->size / sizeof (uint64_t);
-    backend->frame_drm_modifiers = (uint64_t *)calloc(backend->frame_num_drm_modifiers, sizeof (uint64_t));
-    if (backend->frame_drm_modifiers == NULL) {
-        wlm_log_error("mirror-extcopy::on_capture_session_dmabuf_format(): failed to allocate modifiers array\n");
-        backend_cancel(ctx, backend);
-        return;
+        backend->frame_drm_modifiers = modifiers;
+        backend->frame_drm_modifiers_capacity = num_modifiers;
     }
 
-    memcpy(backend->frame_drm_modifiers, modifiers_arr->data, modifiers_arr->size);
+    backend->frame_num_drm_modifiers = num_modifiers;
+    if (num_modifiers > 0) memcpy(backend->frame_drm_modifiers, modifiers_arr->data, modifiers_arr->size);
 
     (void)session;
 }
 
 static void on_capture_session_dmabuf_device(void * data, struct ext_image_copy_capture_session_v1 * session, struct wl_array * device) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-extcopy::on_capture_session_dmabuf_device");
     extcopy_mirror_backend_t * backend = (extcopy_mirror_backend_t *)ctx->mirror.backend;
 
     if (!backend->use_dmabuf) return;
@@ -149,9 +164,9 @@ static void on_capture_session_dmabuf_device(void * data, struct ext_image_copy_
     (void)session;
 }
 
-static void on_dmabuf_allocated(ctx_t * ctx, bool success);
 static void on_capture_session_done(void * data, struct ext_image_copy_capture_session_v1 * session) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-extcopy::on_capture_session_done");
     extcopy_mirror_backend_t * backend = (extcopy_mirror_backend_t *)ctx->mirror.backend;
 
     if (backend->capture_frame != NULL) {
@@ -160,6 +175,11 @@ static void on_capture_session_done(void * data, struct ext_image_copy_capture_s
         backend->capture_frame = NULL;
     }
 
+    // buffer constraints may have changed
+    wlm_wayland_dmabuf_release(ctx, backend->dmabuf_handle);
+    backend->dmabuf_handle = WLM_WAYLAND_DMABUF_INVALID_HANDLE;
+    backend->damage_tracked = false;
+
     if (backend->use_dmabuf) {
         if (!backend->has_drm_format) {
             wlm_log_error("mirror-extcopy::on_capture_session_done(): missing DRM format\n");
@@ -167,15 +187,16 @@ static void on_capture_session_done(void * data, struct ext_image_copy_capture_s
             return;
         }
 
-        if (backend->frame_drm_modifiers == NULL) {
+        // the modifiers array is kept across sessions, only the count belongs to this one
+        if (backend->frame_num_drm_modifiers == 0) {
             wlm_log_error("mirror-extcopy::on_capture_session_done(): missing DRM modifiers\n");
             backend_cancel(ctx, backend);
             return;
         }
 
-        wlm_log_debug(ctx, "mirror-extcopy::on_capture_session_done(): allocating DMA-BUF\n");
-        wlm_wayland_dmabuf_dealloc(ctx);
-        wlm_wayland_dmabuf_alloc(ctx, backend->frame_drm_format, backend->frame_width, backend->frame_height, backend->frame_drm_modifiers, backend->frame_num_drm_modifiers, on_dmabuf_allocated);
+        // DMA-BUFs are acquired from the pool for each capture
+        wlm_log_debug(ctx, "mirror-extcopy::on_capture_session_done(): DMA-BUF constraints received\n");
+        backend->state = STATE_READY;
     } else {
         if (!backend->has_shm_format) {
             wlm_log_error("mirror-extcopy::on_capture_session_done(): missing SHM format\n");
@@ -183,7 +204,9 @@ static void on_capture_session_done(void * data, struct ext_image_copy_capture_s
             return;
         }
 
+        // the new ring doesn't contain the shown buffer
         wlm_wayland_shm_dealloc(ctx);
+        backend->shown_shm_handle = WLM_WAYLAND_SHM_INVALID_HANDLE;
         bool success = wlm_wayland_shm_alloc(ctx, backend->frame_shm_format, backend->frame_width, backend->frame_height, backend->frame_shm_stride);
 
         if (!success) {
@@ -201,6 +224,7 @@ static void on_capture_session_done(void * data, struct ext_image_copy_capture_s
 
 static void on_capture_session_stopped(void * data, struct ext_image_copy_capture_session_v1 * session) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-extcopy::on_capture_session_stopped");
     extcopy_mirror_backend_t * backend = (extcopy_mirror_backend_t *)ctx->mirror.backend;
 
     wlm_log_error("mirror-extcopy::on_capture_session_stoppped(): capture session closed unexpectedly\n");
@@ -209,19 +233,6 @@ static void on_capture_session_stopped(void * data, struct ext_image_copy_captur
     (void)session;
 }
 
-static void on_dmabuf_allocated(ctx_t * ctx, bool success) {
-    extcopy_mirror_backend_t * backend = (extcopy_mirror_backend_t *)ctx->mirror.backend;
-
-    if (!success) {
-        wlm_log_error("mirror-extcopy::on_dmabuf_allocated(): failed to allocate DMA-BUF\n");
-        backend_cancel(ctx, backend);
-        return;
-    }
-
-    wlm_log_debug(ctx, "mirror-extcopy::on_dmabuf_allocated(): DMA-BUF allocated\n");
-    backend->state = STATE_READY;
-}
-
 static const struct ext_image_copy_capture_session_v1_listener capture_session_listener = {
     .buffer_size = on_capture_session_buffer_size,
     .shm_format = on_capture_session_shm_format,
@@ -235,6 +246,7 @@ static const struct ext_image_copy_capture_session_v1_listener capture_session_l
 
 static void on_capture_frame_transform(void * data, struct ext_image_copy_capture_frame_v1 * frame, uint32_t transform) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-extcopy::on_capture_frame_transform");
     extcopy_mirror_backend_t * backend = (extcopy_mirror_backend_t *)ctx->mirror.backend;
 
     wlm_log_debug(ctx, "mirror-extcopy::on_capture_frame_transform(): transform = %d\n", transform);
@@ -246,37 +258,55 @@ static void on_capture_frame_damage(void * data, struct ext_image_copy_capture_f
     int32_t x, int32_t y, int32_t width, int32_t height
 ) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-extcopy::on_capture_frame_damage");
     extcopy_mirror_backend_t * backend = (extcopy_mirror_backend_t *)ctx->mirror.backend;
 
-    (void)ctx;
-    (void)backend;
+    wlm_log_debug(ctx, "mirror-extcopy::on_capture_frame_damage(): damage = %dx%d+%d+%d\n", width, height, x, y);
+    wlm_damage_add(&backend->frame_damage, x, y, width, height);
+
     (void)frame;
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
 }
 
 static void on_capture_frame_presentation_time(void * data, struct ext_image_copy_capture_frame_v1 * frame,
     uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec
 ) {
     ctx_t * ctx = (ctx_t *)data;
-    extcopy_mirror_backend_t * backend = (extcopy_mirror_backend_t *)ctx->mirror.backend;
+    WLM_TRACE_SCOPE(ctx, "mirror-extcopy::on_capture_frame_presentation_time");
+
+    // remember when the source produced this frame for capture pacing
+    wlm_mirror_source_presented(ctx, tv_sec_hi, tv_sec_lo, tv_nsec);
 
-    (void)ctx;
-    (void)backend;
     (void)frame;
-    (void)tv_sec_hi;
-    (void)tv_sec_lo;
-    (void)tv_nsec;
 }
 
+static bool start_capture(ctx_t * ctx, extcopy_mirror_backend_t * backend);
 static void on_capture_frame_ready(void * data, struct ext_image_copy_capture_frame_v1 * frame) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-extcopy::on_capture_frame_ready");
     extcopy_mirror_backend_t * backend = (extcopy_mirror_backend_t *)ctx->mirror.backend;
 
     wlm_log_debug(ctx, "mirror-extcopy::on_capture_frame_ready(): frame captured\n");
 
+    wlm_damage_t damage = backend->frame_damage;
+    wlm_wayland_shm_handle_t shm_handle = backend->shm_handle;
+    wlm_wayland_dmabuf_handle_t dmabuf_handle = backend->dmabuf_handle;
+    backend->dmabuf_handle = WLM_WAYLAND_DMABUF_INVALID_HANDLE;
+    backend->state = STATE_READY;
+    backend->header.fail_count = 0;
+
+    if (backend->capture_queued || wlm_mirror_capture_early(ctx)) {
+        // start the next capture before importing this frame
+        // - the compositor copies into the next buffer while this one is imported
+        backend->capture_queued = false;
+        if (start_capture(ctx, backend)) {
+            wlm_mirror_capture_started(ctx);
+            wl_display_flush(ctx->wl.display);
+        } else {
+            wlm_wayland_dmabuf_release(ctx, dmabuf_handle);
+            return;
+        }
+    }
+
     if (backend->use_dmabuf) {
         const wlm_egl_format_t * format = wlm_egl_formats_find_drm(backend->frame_drm_format);
         if (format == NULL) {
@@ -285,21 +315,27 @@ static void on_capture_frame_ready(void * data, struct ext_image_copy_capture_fr
             return;
         }
 
-        dmabuf_t * dmabuf = wlm_wayland_dmabuf_get_raw_buffer(ctx);
+        dmabuf_t * dmabuf = wlm_wayland_dmabuf_get_raw_buffer(ctx, dmabuf_handle);
         if (dmabuf == NULL) {
             wlm_log_error("mirror-extcopy::on_capture_frame_ready(): DMA-BUF disappeared\n");
+            wlm_wayland_dmabuf_release(ctx, dmabuf_handle);
             backend_cancel(ctx, backend);
             return;
         }
 
         // TODO: invert_y?
         // TODO: pass correct format entry
-        if (!wlm_egl_dmabuf_import(ctx, dmabuf, NULL, false, false)) {
+        if (!wlm_egl_dmabuf_import(ctx, dmabuf, NULL, false, false, true)) {
             wlm_log_error("mirror-extcopy::on_capture_frame_ready(): failed to import dmabuf\n");
+            wlm_wayland_dmabuf_release(ctx, dmabuf_handle);
             backend_cancel(ctx, backend);
             return;
         }
 
+        // the texture now aliases this buffer, return the previous one to the pool
+        wlm_wayland_dmabuf_release(ctx, backend->shown_dmabuf_handle);
+        backend->shown_dmabuf_handle = dmabuf_handle;
+
         wlm_log_debug(ctx, "mirror-extcopy::on_capture_frame_ready(): frame captured and DMA-BUF imported\n");
     } else {
         const wlm_egl_format_t * format = wlm_egl_formats_find_shm(backend->frame_shm_format);
@@ -309,29 +345,40 @@ static void on_capture_frame_ready(void * data, struct ext_image_copy_capture_fr
             return;
         }
 
-        void * shm_addr = wlm_wayland_shm_get_addr(ctx);
+        void * shm_addr = wlm_wayland_shm_get_addr(ctx, shm_handle);
         if (shm_addr == NULL) {
-            wlm_log_error("mirror-screencopy::on_ready(): shm buffer addr disappeared\n");
+            wlm_log_error("mirror-extcopy::on_capture_frame_ready(): shm buffer addr disappeared\n");
             backend_cancel(ctx, backend);
             return;
         }
 
+        // upload only damaged regions if the texture holds the previous frame
+        // - treat frames without damage events as fully damaged
+        bool use_damage = backend->damage_tracked && !wlm_damage_is_empty(&damage);
+
+        // import without copying if the shm buffer is also available as a dmabuf
         // TODO: invert_y?
-        if (!wlm_egl_shm_import(ctx, shm_addr, format, backend->frame_width, backend->frame_height, backend->frame_shm_stride, false, false)) {
-            wlm_log_error("mirror-screencopy::on_ready(): shm buffer import failed\n");
+        bool imported = wlm_egl_shm_import_udmabuf(ctx, shm_handle, format, false, false);
+        if (!imported && !wlm_egl_shm_import(ctx, shm_addr, format, backend->frame_width, backend->frame_height, backend->frame_shm_stride, false, false, use_damage ? &damage : NULL)) {
+            wlm_log_error("mirror-extcopy::on_capture_frame_ready(): shm buffer import failed\n");
             backend_cancel(ctx, backend);
             return;
         }
+
+        // the texture aliases the buffer when imported through udmabuf, keep it out of the ring
+        backend->shown_shm_handle = imported ? shm_handle : WLM_WAYLAND_SHM_INVALID_HANDLE;
+        backend->damage_tracked = true;
     }
 
-    backend->state = STATE_READY;
-    backend->header.fail_count = 0;
+    // draw and commit the new frame
+    wlm_mirror_frame_ready(ctx);
 
     (void)frame;
 }
 
 static void on_capture_frame_failed(void * data, struct ext_image_copy_capture_frame_v1 * frame, uint32_t reason) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-extcopy::on_capture_frame_failed");
     extcopy_mirror_backend_t * backend = (extcopy_mirror_backend_t *)ctx->mirror.backend;
 
     wlm_log_error("mirror-extcopy::on_capture_frame_failed(): failed to capture frame, reason = %d\n", reason);
@@ -350,45 +397,110 @@ static const struct ext_image_copy_capture_frame_v1_listener capture_frame_liste
 
 // --- backend event handlers ---
 
-static void do_capture(ctx_t * ctx) {
+static void attach_and_capture(ctx_t * ctx, extcopy_mirror_backend_t * backend, struct wl_buffer * buffer) {
+    wlm_log_debug(ctx, "mirror-extcopy::attach_and_capture(): capturing frame\n");
+    wlm_damage_clear(&backend->frame_damage);
+    backend->capture_frame = ext_image_copy_capture_session_v1_create_frame(backend->capture_session);
+    ext_image_copy_capture_frame_v1_add_listener(backend->capture_frame, &capture_frame_listener, (void *)ctx);
+    ext_image_copy_capture_frame_v1_attach_buffer(backend->capture_frame, buffer);
+
+    // ring and pool buffers still hold whatever frame was last copied into them
+    // - the compositor only has to copy what changed since the previous frame of the session
+    ext_image_copy_capture_frame_v1_damage_buffer(backend->capture_frame, 0, 0, backend->frame_width, backend->frame_height);
+    ext_image_copy_capture_frame_v1_capture(backend->capture_frame);
+    backend->state = STATE_WAIT_READY;
+}
+
+static void on_dmabuf_allocated(ctx_t * ctx, bool success) {
+    WLM_TRACE_SCOPE(ctx, "mirror-extcopy::on_dmabuf_allocated");
+    extcopy_mirror_backend_t * backend = (extcopy_mirror_backend_t *)ctx->mirror.backend;
+
+    if (!success) {
+        // the compositor may also reject the shown buffer, the pool already freed it
+        if (wlm_wayland_dmabuf_get_raw_buffer(ctx, backend->shown_dmabuf_handle) == NULL) {
+            backend->shown_dmabuf_handle = WLM_WAYLAND_DMABUF_INVALID_HANDLE;
+        }
+
+        wlm_log_error("mirror-extcopy::on_dmabuf_allocated(): failed to allocate DMA-BUF\n");
+        backend_cancel(ctx, backend);
+        return;
+    }
+
+    if (backend->state != STATE_WAIT_BUFFER_ALLOCATED) return;
+
+    struct wl_buffer * buffer = wlm_wayland_dmabuf_get_buffer(ctx, backend->dmabuf_handle);
+    if (buffer == NULL) {
+        wlm_log_error("mirror-extcopy::on_dmabuf_allocated(): DMA-BUF disappeared\n");
+        backend_cancel(ctx, backend);
+        return;
+    }
+
+    attach_and_capture(ctx, backend, buffer);
+}
+
+static bool start_capture(ctx_t * ctx, extcopy_mirror_backend_t * backend) {
+    if (backend->capture_frame != NULL) {
+        ext_image_copy_capture_frame_v1_destroy(backend->capture_frame);
+        backend->capture_frame = NULL;
+    }
+
+    if (backend->use_dmabuf) {
+        // get buffer from dmabuf pool
+        // - pool buffers are reused across frames and sessions, allocation only happens on size or format changes
+        backend->state = STATE_WAIT_BUFFER_ALLOCATED;
+        if (!wlm_wayland_dmabuf_acquire(ctx,
+            backend->frame_drm_format, backend->frame_width, backend->frame_height,
+            backend->frame_drm_modifiers, backend->frame_num_drm_modifiers,
+            on_dmabuf_allocated, &backend->dmabuf_handle
+        )) {
+            wlm_log_error("mirror-extcopy::start_capture(): failed to acquire DMA-BUF\n");
+            backend_cancel(ctx, backend);
+            return false;
+        }
+
+        return backend->state != STATE_CANCELED;
+    }
+
+    // copy into the next ring buffer, the previous one may still be uploading
+    backend->shm_handle = wlm_wayland_shm_next_buffer(ctx, backend->shown_shm_handle);
+    struct wl_buffer * buffer = wlm_wayland_shm_get_buffer(ctx, backend->shm_handle);
+    if (buffer == NULL) {
+        wlm_log_error("mirror-extcopy::start_capture(): buffer disappeared\n");
+        backend_cancel(ctx, backend);
+        return false;
+    }
+
+    attach_and_capture(ctx, backend, buffer);
+    return true;
+}
+
+static bool do_capture(ctx_t * ctx) {
+    WLM_TRACE_SCOPE(ctx, "mirror-extcopy::do_capture");
     extcopy_mirror_backend_t * backend = (extcopy_mirror_backend_t *)ctx->mirror.backend;
 
     if (backend->state == STATE_INIT || backend->state == STATE_CANCELED) {
         backend->capture_source = ext_output_image_capture_source_manager_v1_create_source(ctx->wl.output_capture_source_manager, ctx->mirror.current_target->output);
 
         wlm_log_debug(ctx, "mirror-extcopy::do_capture(): creating capture session\n");
+        backend->session_output = ctx->mirror.current_target->output;
+        backend->session_show_cursor = ctx->opt.show_cursor;
         backend->state = STATE_WAIT_BUFFER_INFO;
         backend->capture_session = ext_image_copy_capture_manager_v1_create_session(ctx->wl.copy_capture_manager, backend->capture_source, ctx->opt.show_cursor ? EXT_IMAGE_COPY_CAPTURE_MANAGER_V1_OPTIONS_PAINT_CURSORS : 0);
         ext_image_copy_capture_session_v1_add_listener(backend->capture_session, &capture_session_listener, (void *)ctx);
+        return false;
     } else if (backend->state == STATE_READY) {
-        if (backend->capture_frame != NULL) {
-            ext_image_copy_capture_frame_v1_destroy(backend->capture_frame);
-            backend->capture_frame = NULL;
-        }
-
-        wlm_log_debug(ctx, "mirror-extcopy::do_capture(): capturing frame\n");
-        backend->capture_frame = ext_image_copy_capture_session_v1_create_frame(backend->capture_session);
-        ext_image_copy_capture_frame_v1_add_listener(backend->capture_frame, &capture_frame_listener, (void *)ctx);
-
-        struct wl_buffer * buffer = NULL;
-        if (backend->use_dmabuf) {
-            buffer = wlm_wayland_dmabuf_get_buffer(ctx);
-        } else {
-            buffer = wlm_wayland_shm_get_buffer(ctx);
-        }
-
-        if (buffer == NULL) {
-            wlm_log_error("mirror-extcopy::do_capture(): buffer disappeared\n");
-            backend_cancel(ctx, backend);
-            return;
-        }
-
-        ext_image_copy_capture_frame_v1_attach_buffer(backend->capture_frame, buffer);
-        ext_image_copy_capture_frame_v1_capture(backend->capture_frame);
-        backend->state = STATE_WAIT_READY;
-    } else if (backend->state == STATE_WAIT_READY) {
-        // nop
+        return start_capture(ctx, backend);
+    } else if (backend->state == STATE_WAIT_BUFFER_ALLOCATED || backend->state == STATE_WAIT_READY) {
+        // only one frame may be in flight per session
+        // - queue the next capture into the next buffer
+        backend->capture_queued = true;
+
+        // capture in flight
+        return true;
     }
+
+    // waiting for buffer constraints
+    return false;
 }
 
 static void do_cleanup(ctx_t * ctx) {
@@ -396,7 +508,9 @@ static void do_cleanup(ctx_t * ctx) {
 
     wlm_log_debug(ctx, "mirror-extcopy::do_cleanup(): destroying mirror-extcopy objects\n");
     extcopy_session_cleanup(ctx, backend);
+    wlm_wayland_dmabuf_release(ctx, backend->shown_dmabuf_handle);
 
+    free(backend->frame_drm_modifiers);
     free(backend);
     ctx->mirror.backend = NULL;
 }
@@ -404,9 +518,23 @@ static void do_cleanup(ctx_t * ctx) {
 static void on_options_updated(ctx_t * ctx) {
     extcopy_mirror_backend_t * backend = (extcopy_mirror_backend_t *)ctx->mirror.backend;
 
+    // only the output and cursor options affect the capture session
+    // - regions, transforms and scaling are applied when drawing
+    if (
+        backend->capture_session != NULL &&
+        backend->session_output == ctx->mirror.current_target->output &&
+        backend->session_show_cursor == ctx->opt.show_cursor
+    ) {
+        wlm_log_debug(ctx, "mirror-extcopy::on_options_updated(): capture options unchanged, keeping session\n");
+        return;
+    }
+
     wlm_log_debug(ctx, "mirror-extcopy::on_options_updated(): options updated, restarting capture\n");
     extcopy_session_cleanup(ctx, backend);
     backend->state = STATE_INIT;
+
+    // a capture in flight on the old session never completes
+    wlm_mirror_frame_dropped(ctx);
     do_capture(ctx);
 }
 
@@ -432,6 +560,7 @@ static void wlm_mirror_extcopy_init(ctx_t * ctx, bool use_dmabuf) {
         return;
     }
 
+    backend->header.name = use_dmabuf ? "extcopy-dmabuf" : "extcopy-shm";
     backend->header.do_capture = do_capture;
     backend->header.do_cleanup = do_cleanup;
     backend->header.on_options_updated = on_options_updated;
@@ -442,6 +571,9 @@ static void wlm_mirror_extcopy_init(ctx_t * ctx, bool use_dmabuf) {
     backend->capture_session = NULL;
     backend->capture_frame = NULL;
 
+    backend->session_output = NULL;
+    backend->session_show_cursor = false;
+
     backend->frame_width = 0;
     backend->frame_height = 0;
     backend->frame_shm_stride = 0;
@@ -449,8 +581,17 @@ static void wlm_mirror_extcopy_init(ctx_t * ctx, bool use_dmabuf) {
     backend->frame_drm_format = 0;
     backend->frame_drm_modifiers = NULL;
     backend->frame_num_drm_modifiers = 0;
+    backend->frame_drm_modifiers_capacity = 0;
+    wlm_damage_clear(&backend->frame_damage);
+
+    backend->shm_handle = 0;
+    backend->shown_shm_handle = WLM_WAYLAND_SHM_INVALID_HANDLE;
+    backend->dmabuf_handle = WLM_WAYLAND_DMABUF_INVALID_HANDLE;
+    backend->shown_dmabuf_handle = WLM_WAYLAND_DMABUF_INVALID_HANDLE;
 
     backend->state = STATE_INIT;
+    backend->capture_queued = false;
+    backend->damage_tracked = false;
 
     // set backend object as current backend
     ctx->mirror.backend = (mirror_backend_t *)backend;
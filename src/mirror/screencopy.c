@@ -6,14 +6,22 @@
 #include <wlm/egl/dmabuf.h>
 #include <wlm/egl/formats.h>
 
-static void backend_cancel(screencopy_mirror_backend_t * backend) {
+static void backend_cancel(ctx_t * ctx, screencopy_mirror_backend_t * backend) {
     wlm_log_error("mirror-screencopy::backend_cancel(): cancelling capture due to error\n");
 
     // destroy screencopy frame object
-    zwlr_screencopy_frame_v1_destroy(backend->screencopy_frame);
+    if (backend->screencopy_frame != NULL) zwlr_screencopy_frame_v1_destroy(backend->screencopy_frame);
     backend->screencopy_frame = NULL;
+
+    // return capture buffer to the pool
+    wlm_wayland_dmabuf_release(ctx, backend->dmabuf_handle);
+    backend->dmabuf_handle = WLM_WAYLAND_DMABUF_INVALID_HANDLE;
     backend->state = STATE_CANCELED;
+    backend->capture_queued = false;
+    backend->damage_tracked = false;
     backend->header.fail_count++;
+
+    wlm_mirror_frame_dropped(ctx);
 }
 
 // --- screencopy_frame event handlers ---
@@ -23,6 +31,7 @@ static void on_buffer(
     uint32_t format, uint32_t width, uint32_t height, uint32_t stride
 ) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-screencopy::on_buffer");
     screencopy_mirror_backend_t * backend = (screencopy_mirror_backend_t *)ctx->mirror.backend;
 
     if (backend->use_dmabuf) return;
@@ -30,12 +39,12 @@ static void on_buffer(
     wlm_log_debug(ctx, "mirror-screencopy::on_buffer(): received buffer offer for %dx%d+%d frame\n", width, height, stride);
     if (backend->state != STATE_WAIT_BUFFER) {
         wlm_log_error("mirror-screencopy::on_buffer(): got buffer event while in state %d\n", backend->state);
-        backend_cancel(backend);
+        backend_cancel(ctx, backend);
         return;
     }
 
     if (
-        wlm_wayland_shm_get_buffer(ctx) == NULL ||
+        !wlm_wayland_shm_is_allocated(ctx) ||
         backend->frame_width != width || backend->frame_height != height ||
         backend->frame_stride != stride || backend->frame_format != format
     ) {
@@ -43,9 +52,12 @@ static void on_buffer(
         wlm_wayland_shm_dealloc(ctx);
         if (!wlm_wayland_shm_alloc(ctx, format, width, height, stride)) {
             wlm_log_error("mirror-screencopy::on_buffer(): failed to alloc shm buffer\n");
-            backend_cancel(backend);
+            backend_cancel(ctx, backend);
             return;
         }
+
+        // the new ring doesn't contain the shown buffer
+        backend->shown_shm_handle = WLM_WAYLAND_SHM_INVALID_HANDLE;
     }
 
     backend->frame_width = width;
@@ -57,12 +69,25 @@ static void on_buffer(
     (void)frame;
 }
 
+static void copy_frame(ctx_t * ctx, screencopy_mirror_backend_t * backend, struct wl_buffer * buffer) {
+    // in idle mode, the copy only completes once the screen changes
+    // - needs a previous frame in the texture, so the first copy is a plain copy
+    // - backend trials measure copy time, not time until the screen changes
+    backend->frame_with_damage = ctx->opt.idle_capture && backend->damage_tracked && !ctx->mirror.backend_trial.active;
+    if (backend->frame_with_damage) {
+        zwlr_screencopy_frame_v1_copy_with_damage(backend->screencopy_frame, buffer);
+    } else {
+        zwlr_screencopy_frame_v1_copy(backend->screencopy_frame, buffer);
+    }
+}
+
 static void on_dmabuf_allocated(ctx_t * ctx, bool success);
 static void on_linux_dmabuf(
     void * data, struct zwlr_screencopy_frame_v1 * frame,
     uint32_t format, uint32_t width, uint32_t height
 ) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-screencopy::on_linux_dmabuf");
     screencopy_mirror_backend_t * backend = (screencopy_mirror_backend_t *)ctx->mirror.backend;
 
     if (!backend->use_dmabuf) return;
@@ -70,51 +95,61 @@ static void on_linux_dmabuf(
     wlm_log_debug(ctx, "mirror-screencopy::on_linux_dmabuf(): received buffer offer for %dx%d frame\n", width, height);
     if (backend->state != STATE_WAIT_BUFFER) {
         wlm_log_error("mirror-screencopy::on_linux_dmabuf(): got buffer event while in state %d\n", backend->state);
-        backend_cancel(backend);
+        backend_cancel(ctx, backend);
         return;
     }
 
-    if (
-        wlm_wayland_dmabuf_get_buffer(ctx) == NULL ||
-        backend->frame_width != width || backend->frame_height != height ||
-        backend->frame_format != format
-    ) {
-        wlm_wayland_dmabuf_dealloc(ctx);
-        wlm_wayland_dmabuf_alloc(ctx, format, width, height, NULL, 0, on_dmabuf_allocated);
-        backend->state = STATE_WAIT_BUFFER_ALLOCATED;
-    } else {
-        backend->state = STATE_WAIT_BUFFER_DONE;
-    }
-
     backend->frame_width = width;
     backend->frame_height = height;
     backend->frame_stride = 0;
     backend->frame_format = format;
 
+    // get buffer from dmabuf pool
+    // - pool buffers are reused across frames, allocation only happens on size or format changes
+    wlm_wayland_dmabuf_release(ctx, backend->dmabuf_handle);
+    backend->dmabuf_handle = WLM_WAYLAND_DMABUF_INVALID_HANDLE;
+    backend->state = STATE_WAIT_BUFFER_ALLOCATED;
+    if (!wlm_wayland_dmabuf_acquire(ctx, format, width, height, NULL, 0, on_dmabuf_allocated, &backend->dmabuf_handle)) {
+        wlm_log_error("mirror-screencopy::on_linux_dmabuf(): failed to acquire dmabuf\n");
+        backend_cancel(ctx, backend);
+        return;
+    }
+
     (void)frame;
 }
 
 static void on_dmabuf_allocated(ctx_t * ctx, bool success) {
+    WLM_TRACE_SCOPE(ctx, "mirror-screencopy::on_dmabuf_allocated");
     screencopy_mirror_backend_t * backend = (screencopy_mirror_backend_t *)ctx->mirror.backend;
 
     if (!success) {
+        // the compositor may also reject the shown buffer, the pool already freed it
+        if (wlm_wayland_dmabuf_get_raw_buffer(ctx, backend->shown_dmabuf_handle) == NULL) {
+            backend->shown_dmabuf_handle = WLM_WAYLAND_DMABUF_INVALID_HANDLE;
+        }
+
         wlm_log_error("mirror-screencopy::on_dmabuf_allocated(): failed to allocate dmabuf\n");
         wlm_mirror_backend_fail(ctx);
         return;
     }
 
     wlm_log_debug(ctx, "mirror-screencopy::on_dmabuf_allocated(): dmabuf allocated\n");
-    if (backend->state != STATE_WAIT_FLAGS) {
+    if (backend->state == STATE_WAIT_BUFFER_ALLOCATED) {
+        // buffer_done not received yet
+        backend->state = STATE_WAIT_BUFFER_DONE;
+        return;
+    } else if (backend->state != STATE_WAIT_FLAGS) {
         return;
     }
 
-    zwlr_screencopy_frame_v1_copy(backend->screencopy_frame, wlm_wayland_dmabuf_get_buffer(ctx));
+    copy_frame(ctx, backend, wlm_wayland_dmabuf_get_buffer(ctx, backend->dmabuf_handle));
 }
 
 static void on_buffer_done(
     void * data, struct zwlr_screencopy_frame_v1 * frame
 ) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-screencopy::on_buffer_done");
     screencopy_mirror_backend_t * backend = (screencopy_mirror_backend_t *)ctx->mirror.backend;
 
     wlm_log_debug(ctx, "mirror-screencopy::on_buffer_done(): received buffer done event\n");
@@ -125,25 +160,27 @@ static void on_buffer_done(
         return;
     } else if (backend->state != STATE_WAIT_BUFFER_DONE) {
         wlm_log_error("mirror-screencopy::on_buffer_done(): received buffer_done without supported buffer offer\n");
-        backend_cancel(backend);
+        backend_cancel(ctx, backend);
         return;
     }
 
     struct wl_buffer * buffer = NULL;
     if (backend->use_dmabuf) {
-        buffer = wlm_wayland_dmabuf_get_buffer(ctx);
+        buffer = wlm_wayland_dmabuf_get_buffer(ctx, backend->dmabuf_handle);
     } else {
-        buffer = wlm_wayland_shm_get_buffer(ctx);
+        // copy into the next ring buffer, the previous one may still be uploading
+        backend->shm_handle = wlm_wayland_shm_next_buffer(ctx, backend->shown_shm_handle);
+        buffer = wlm_wayland_shm_get_buffer(ctx, backend->shm_handle);
     }
 
     if (buffer == NULL) {
         wlm_log_error("mirror-screencopy::on_buffer_done(): buffer disappeared\n");
-        backend_cancel(backend);
+        backend_cancel(ctx, backend);
         return;
     }
 
     backend->state = STATE_WAIT_FLAGS;
-    zwlr_screencopy_frame_v1_copy(backend->screencopy_frame, buffer);
+    copy_frame(ctx, backend, buffer);
 
     (void)frame;
 }
@@ -152,12 +189,14 @@ static void on_damage(
     void * data, struct zwlr_screencopy_frame_v1 * frame,
     uint32_t x, uint32_t y, uint32_t width, uint32_t height
 ) {
-    (void)data;
+    ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-screencopy::on_damage");
+    screencopy_mirror_backend_t * backend = (screencopy_mirror_backend_t *)ctx->mirror.backend;
+
+    wlm_log_debug(ctx, "mirror-screencopy::on_damage(): received damage %dx%d+%d+%d\n", width, height, x, y);
+    wlm_damage_add(&backend->frame_damage, x, y, width, height);
+
     (void)frame;
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
 }
 
 static void on_flags(
@@ -165,12 +204,13 @@ static void on_flags(
     uint32_t flags
 ) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-screencopy::on_flags");
     screencopy_mirror_backend_t * backend = (screencopy_mirror_backend_t *)ctx->mirror.backend;
 
     wlm_log_debug(ctx, "mirror-screencopy::on_flags(): received flags event: flags=%x\n", flags);
     if (backend->state != STATE_WAIT_FLAGS) {
         wlm_log_error("mirror-screencopy::on_flags(): received unexpected flags event\n");
-        backend_cancel(backend);
+        backend_cancel(ctx, backend);
         return;
     }
 
@@ -180,11 +220,13 @@ static void on_flags(
     (void)frame;
 }
 
+static bool start_capture(ctx_t * ctx, screencopy_mirror_backend_t * backend);
 static void on_ready(
     void * data, struct zwlr_screencopy_frame_v1 * frame,
     uint32_t sec_hi, uint32_t sec_lo, uint32_t nsec
 ) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-screencopy::on_ready");
     screencopy_mirror_backend_t * backend = (screencopy_mirror_backend_t *)ctx->mirror.backend;
 
     if (ctx->opt.verbose) {
@@ -198,65 +240,127 @@ static void on_ready(
         );
     }
 
+    // remember when the source produced this frame for capture pacing
+    wlm_mirror_source_presented(ctx, sec_hi, sec_lo, nsec);
+
+    if (backend->frame_with_damage && wlm_damage_is_empty(&backend->frame_damage)) {
+        // nothing changed, wait for the next damage without redrawing
+        wlm_log_debug(ctx, "mirror-screencopy::on_ready(): frame has no damage, skipping redraw\n");
+        zwlr_screencopy_frame_v1_destroy(backend->screencopy_frame);
+        backend->screencopy_frame = NULL;
+        wlm_wayland_dmabuf_release(ctx, backend->dmabuf_handle);
+        backend->dmabuf_handle = WLM_WAYLAND_DMABUF_INVALID_HANDLE;
+        backend->state = STATE_READY;
+
+        // a queued capture is covered by the next one the mirror requests
+        backend->capture_queued = false;
+        wlm_mirror_frame_unchanged(ctx);
+        return;
+    }
+
+    bool invert_y = backend->frame_flags & ZWLR_SCREENCOPY_FRAME_V1_FLAGS_Y_INVERT;
+    wlm_damage_t damage = backend->frame_damage;
+    wlm_wayland_shm_handle_t shm_handle = backend->shm_handle;
+    wlm_wayland_dmabuf_handle_t dmabuf_handle = backend->dmabuf_handle;
+    backend->dmabuf_handle = WLM_WAYLAND_DMABUF_INVALID_HANDLE;
+
+    zwlr_screencopy_frame_v1_destroy(backend->screencopy_frame);
+    backend->screencopy_frame = NULL;
+    backend->state = STATE_READY;
+    backend->header.fail_count = 0;
+
+    if (backend->capture_queued || wlm_mirror_capture_early(ctx)) {
+        // start the next capture before importing this frame
+        // - the compositor copies into the next buffer while this one is imported
+        backend->capture_queued = false;
+        if (start_capture(ctx, backend)) {
+            wlm_mirror_capture_started(ctx);
+            wl_display_flush(ctx->wl.display);
+        } else {
+            wlm_log_error("mirror-screencopy::on_ready(): failed to start queued capture\n");
+            wlm_wayland_dmabuf_release(ctx, dmabuf_handle);
+            backend_cancel(ctx, backend);
+            return;
+        }
+    }
+
     if (backend->use_dmabuf) {
         const wlm_egl_format_t * format = wlm_egl_formats_find_drm(backend->frame_format);
         if (format == NULL) {
             wlm_log_error("mirror-screencopy::on_ready(): failed to find GL format for drm format\n");
-            backend_cancel(backend);
+            backend_cancel(ctx, backend);
+            return;
+        }
+
+        dmabuf_t * dmabuf = wlm_wayland_dmabuf_get_raw_buffer(ctx, dmabuf_handle);
+        if (dmabuf == NULL) {
+            wlm_log_error("mirror-screencopy::on_ready(): dmabuf disappeared\n");
+            wlm_wayland_dmabuf_release(ctx, dmabuf_handle);
+            backend_cancel(ctx, backend);
             return;
         }
 
-        bool invert_y = backend->frame_flags & ZWLR_SCREENCOPY_FRAME_V1_FLAGS_Y_INVERT;
         // TODO: pass correct format entry
-        if (!wlm_egl_dmabuf_import(ctx, wlm_wayland_dmabuf_get_raw_buffer(ctx), NULL, invert_y, true)) {
+        if (!wlm_egl_dmabuf_import(ctx, dmabuf, NULL, invert_y, true, true)) {
             wlm_log_error("mirror-screencopy::on_ready(): failed to import dmabuf\n");
-            backend_cancel(backend);
+            wlm_wayland_dmabuf_release(ctx, dmabuf_handle);
+            backend_cancel(ctx, backend);
             return;
         }
+
+        // the texture now aliases this buffer, return the previous one to the pool
+        wlm_wayland_dmabuf_release(ctx, backend->shown_dmabuf_handle);
+        backend->shown_dmabuf_handle = dmabuf_handle;
+        backend->damage_tracked = true;
     } else {
         // find correct texture format
         const wlm_egl_format_t * format = wlm_egl_formats_find_shm(backend->frame_format);
         if (format == NULL) {
             wlm_log_error("mirror-screencopy::on_ready(): failed to find GL format for shm format\n");
-            backend_cancel(backend);
+            backend_cancel(ctx, backend);
             return;
         }
 
-        void * shm_addr = wlm_wayland_shm_get_addr(ctx);
+        void * shm_addr = wlm_wayland_shm_get_addr(ctx, shm_handle);
         if (shm_addr == NULL) {
             wlm_log_error("mirror-screencopy::on_ready(): shm buffer addr disappeared\n");
-            backend_cancel(backend);
+            backend_cancel(ctx, backend);
             return;
         }
 
-        bool invert_y = backend->frame_flags & ZWLR_SCREENCOPY_FRAME_V1_FLAGS_Y_INVERT;
-        if (!wlm_egl_shm_import(ctx, shm_addr, format, backend->frame_width, backend->frame_height, backend->frame_stride, invert_y, true)) {
+        // upload only damaged regions if the texture holds the previous frame
+        // - no damage is reported for plain copies, upload everything then
+        bool use_damage = backend->damage_tracked && !wlm_damage_is_empty(&damage);
+
+        // import without copying if the shm buffer is also available as a dmabuf
+        bool imported = wlm_egl_shm_import_udmabuf(ctx, shm_handle, format, invert_y, true);
+        if (!imported && !wlm_egl_shm_import(ctx, shm_addr, format, backend->frame_width, backend->frame_height, backend->frame_stride, invert_y, true, use_damage ? &damage : NULL)) {
             wlm_log_error("mirror-screencopy::on_ready(): shm buffer import failed\n");
-            backend_cancel(backend);
+            backend_cancel(ctx, backend);
             return;
         }
+
+        // the texture aliases the buffer when imported through udmabuf, keep it out of the ring
+        backend->shown_shm_handle = imported ? shm_handle : WLM_WAYLAND_SHM_INVALID_HANDLE;
+        backend->damage_tracked = true;
     }
 
-    zwlr_screencopy_frame_v1_destroy(backend->screencopy_frame);
-    backend->screencopy_frame = NULL;
-    backend->state = STATE_READY;
-    backend->header.fail_count = 0;
+    // draw and commit the new frame
+    wlm_mirror_frame_ready(ctx);
 
     (void)frame;
-    (void)sec_hi;
-    (void)sec_lo;
-    (void)nsec;
 }
 
 static void on_failed(
     void * data, struct zwlr_screencopy_frame_v1 * frame
 ) {
     ctx_t * ctx = (ctx_t *)data;
+    WLM_TRACE_SCOPE(ctx, "mirror-screencopy::on_failed");
     screencopy_mirror_backend_t * backend = (screencopy_mirror_backend_t *)ctx->mirror.backend;
 
     wlm_log_debug(ctx, "mirror-screencopy::on_failed(): received cancel event\n");
 
-    backend_cancel(backend);
+    backend_cancel(ctx, backend);
 
     (void)frame;
 }
@@ -273,41 +377,61 @@ static const struct zwlr_screencopy_frame_v1_listener screencopy_frame_listener
 
 // --- backend event handlers ---
 
-static void do_capture(ctx_t * ctx) {
+static bool start_capture(ctx_t * ctx, screencopy_mirror_backend_t * backend) {
+    // clear frame state for next frame
+    backend->frame_flags = 0;
+    wlm_damage_clear(&backend->frame_damage);
+    backend->frame_with_damage = false;
+    backend->state = STATE_WAIT_BUFFER;
+
+    // create screencopy_frame
+    if (ctx->opt.has_region) {
+        backend->screencopy_frame = zwlr_screencopy_manager_v1_capture_output_region(
+            ctx->wl.screencopy_manager, ctx->opt.show_cursor, ctx->mirror.current_target->output,
+            ctx->mirror.current_target->x + ctx->mirror.current_region.x,
+            ctx->mirror.current_target->y + ctx->mirror.current_region.y,
+            ctx->mirror.current_region.width,
+            ctx->mirror.current_region.height
+        );
+    } else {
+        backend->screencopy_frame = zwlr_screencopy_manager_v1_capture_output(
+            ctx->wl.screencopy_manager, ctx->opt.show_cursor, ctx->mirror.current_target->output
+        );
+    }
+    if (backend->screencopy_frame == NULL) {
+        wlm_log_error("mirror-screencopy::start_capture(): failed to create wlr_screencopy_frame\n");
+        return false;
+    }
+
+    // add screencopy_frame event listener
+    // - for buffer event
+    // - for buffer_done event
+    // - for flags event
+    // - for ready event
+    // - for failed event
+    zwlr_screencopy_frame_v1_add_listener(backend->screencopy_frame, &screencopy_frame_listener, (void *)ctx);
+    return true;
+}
+
+static bool do_capture(ctx_t * ctx) {
+    WLM_TRACE_SCOPE(ctx, "mirror-screencopy::do_capture");
     screencopy_mirror_backend_t * backend = (screencopy_mirror_backend_t *)ctx->mirror.backend;
 
-    if (backend->state == STATE_READY || backend->state == STATE_CANCELED) {
-        // clear frame state for next frame
-        backend->frame_flags = 0;
-        backend->state = STATE_WAIT_BUFFER;
-
-        // create screencopy_frame
-        if (ctx->opt.has_region) {
-            backend->screencopy_frame = zwlr_screencopy_manager_v1_capture_output_region(
-                ctx->wl.screencopy_manager, ctx->opt.show_cursor, ctx->mirror.current_target->output,
-                ctx->mirror.current_target->x + ctx->mirror.current_region.x,
-                ctx->mirror.current_target->y + ctx->mirror.current_region.y,
-                ctx->mirror.current_region.width,
-                ctx->mirror.current_region.height
-            );
-        } else {
-            backend->screencopy_frame = zwlr_screencopy_manager_v1_capture_output(
-                ctx->wl.screencopy_manager, ctx->opt.show_cursor, ctx->mirror.current_target->output
-            );
-        }
-        if (backend->screencopy_frame == NULL) {
-            wlm_log_error("do_capture: failed to create wlr_screencopy_frame\n");
+    if (backend->state == STATE_WAIT_DMABUF_DEVICE) {
+        // no capture possible until the dmabuf device is open
+        return false;
+    } else if (backend->state == STATE_READY || backend->state == STATE_CANCELED) {
+        if (!start_capture(ctx, backend)) {
             wlm_mirror_backend_fail(ctx);
+            return false;
         }
-
-        // add screencopy_frame event listener
-        // - for buffer event
-        // - for buffer_done event
-        // - for flags event
-        // - for ready event
-        // - for failed event
-        zwlr_screencopy_frame_v1_add_listener(backend->screencopy_frame, &screencopy_frame_listener, (void *)ctx);
+    } else {
+        // queue the next capture into the next buffer
+        backend->capture_queued = true;
     }
+
+    // capture in flight
+    return true;
 }
 
 static void do_cleanup(ctx_t * ctx) {
@@ -315,14 +439,36 @@ static void do_cleanup(ctx_t * ctx) {
 
     wlm_log_debug(ctx, "mirror-screencopy::do_cleanup(): destroying mirror-screencopy objects\n");
 
-    if (wlm_wayland_dmabuf_get_buffer(ctx) != NULL) wlm_wayland_dmabuf_dealloc(ctx);
-    if (wlm_wayland_shm_get_buffer(ctx) != NULL) wlm_wayland_shm_dealloc(ctx);
+    wlm_wayland_dmabuf_release(ctx, backend->dmabuf_handle);
+    wlm_wayland_dmabuf_release(ctx, backend->shown_dmabuf_handle);
+    if (wlm_wayland_shm_is_allocated(ctx)) wlm_wayland_shm_dealloc(ctx);
     if (backend->screencopy_frame != NULL) zwlr_screencopy_frame_v1_destroy(backend->screencopy_frame);
 
     free(backend);
     ctx->mirror.backend = NULL;
 }
 
+static void on_options_updated(ctx_t * ctx) {
+    screencopy_mirror_backend_t * backend = (screencopy_mirror_backend_t *)ctx->mirror.backend;
+
+    // a copy waiting for damage may never complete on a static screen
+    // - restart it so the new options apply right away
+    if (!backend->frame_with_damage) return;
+    if (backend->state != STATE_WAIT_FLAGS && backend->state != STATE_WAIT_READY) return;
+
+    wlm_log_debug(ctx, "mirror-screencopy::on_options_updated(): options updated, restarting capture\n");
+    zwlr_screencopy_frame_v1_destroy(backend->screencopy_frame);
+    backend->screencopy_frame = NULL;
+    wlm_wayland_dmabuf_release(ctx, backend->dmabuf_handle);
+    backend->dmabuf_handle = WLM_WAYLAND_DMABUF_INVALID_HANDLE;
+    backend->frame_with_damage = false;
+    backend->state = STATE_READY;
+    backend->capture_queued = false;
+    backend->damage_tracked = false;
+
+    wlm_mirror_frame_dropped(ctx);
+}
+
 static void on_dmabuf_device_opened(ctx_t * ctx, bool success) {
     screencopy_mirror_backend_t * backend = (screencopy_mirror_backend_t *)ctx->mirror.backend;
 
@@ -359,9 +505,10 @@ static void wlm_mirror_screencopy_init(ctx_t * ctx, bool use_dmabuf) {
     }
 
     // initialize context structure
+    backend->header.name = use_dmabuf ? "screencopy-dmabuf" : "screencopy-shm";
     backend->header.do_capture = do_capture;
     backend->header.do_cleanup = do_cleanup;
-    backend->header.on_options_updated = NULL;
+    backend->header.on_options_updated = on_options_updated;
     backend->header.fail_count = 0;
     backend->use_dmabuf = use_dmabuf;
 
@@ -372,6 +519,14 @@ static void wlm_mirror_screencopy_init(ctx_t * ctx, bool use_dmabuf) {
     backend->frame_stride = 0;
     backend->frame_format = 0;
     backend->frame_flags = 0;
+    wlm_damage_clear(&backend->frame_damage);
+
+    backend->shm_handle = 0;
+    backend->shown_shm_handle = WLM_WAYLAND_SHM_INVALID_HANDLE;
+    backend->dmabuf_handle = WLM_WAYLAND_DMABUF_INVALID_HANDLE;
+    backend->shown_dmabuf_handle = WLM_WAYLAND_DMABUF_INVALID_HANDLE;
+    backend->capture_queued = false;
+    backend->damage_tracked = false;
 
     // set backend object as current backend
     ctx->mirror.backend = (mirror_backend_t *)backend;
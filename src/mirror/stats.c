@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <wlm/context.h>
+#include <wlm/mirror/stats.h>
+
+// --- wlm_mirror_stats_import ---
+
+void wlm_mirror_stats_import(ctx_t * ctx, uint32_t drm_format, uint64_t start_ns, uint64_t bytes_uploaded) {
+    ctx_mirror_stats_t * stats = &ctx->mirror.stats;
+    uint64_t duration_ns = wlm_event_now_ns() - start_ns;
+
+    stats->imports++;
+    stats->import_total_ns += duration_ns;
+    if (duration_ns > stats->import_max_ns) stats->import_max_ns = duration_ns;
+    stats->last_import_ns = duration_ns;
+    stats->drm_format = drm_format;
+    stats->bytes_uploaded += bytes_uploaded;
+}
+
+void wlm_mirror_stats_fail_count(ctx_t * ctx, size_t fail_count) {
+    if (fail_count > ctx->mirror.stats.fail_count_max) ctx->mirror.stats.fail_count_max = fail_count;
+}
+
+// --- wlm_mirror_stats_print ---
+
+void wlm_mirror_stats_print(ctx_t * ctx) {
+    ctx_mirror_stats_t * stats = &ctx->mirror.stats;
+    uint64_t now = wlm_event_now_ns();
+
+    const char * backend = ctx->mirror.backend == NULL ? "none" : ctx->mirror.backend->name;
+    size_t fail_count = ctx->mirror.backend == NULL ? 0 : ctx->mirror.backend->fail_count;
+    uint64_t import_avg_ns = stats->imports == 0 ? 0 : stats->import_total_ns / stats->imports;
+
+    // upload rate since the previous query
+    uint64_t elapsed_ns = now - stats->last_query_ns;
+    uint64_t bytes = stats->bytes_uploaded - stats->last_query_bytes;
+    uint64_t bytes_per_sec = elapsed_ns == 0 ? 0 : (uint64_t)(bytes * 1e9 / elapsed_ns);
+    stats->last_query_ns = now;
+    stats->last_query_bytes = stats->bytes_uploaded;
+
+    // latencies from presentation feedback, 0 if unavailable
+    uint64_t capture_latency_ns = 0;
+    uint64_t present_latency_ns = 0;
+    wlm_mirror_timing_percentile(ctx, WLM_TIMING_LATENCY_CAPTURE, 50, &capture_latency_ns);
+    wlm_mirror_timing_percentile(ctx, WLM_TIMING_LATENCY_PRESENT, 50, &present_latency_ns);
+
+    // drm formats are little-endian fourcc codes
+    char format[5] = "none";
+    if (stats->drm_format != 0) {
+        for (size_t i = 0; i < 4; i++) {
+            char c = (char)((stats->drm_format >> (8 * i)) & 0xff);
+            format[i] = c == '\0' ? ' ' : c;
+        }
+    }
+
+    printf("stats backend=%s captured=%llu drawn=%llu dropped=%llu fail_count=%zu fail_count_max=%zu fallbacks=%llu"
+        " import_avg_us=%llu import_max_us=%llu texture=%ux%u format=%.4s upload_bytes_per_sec=%llu"
+        " capture_latency_p50_us=%llu present_latency_p50_us=%llu\n",
+        backend,
+        (unsigned long long)stats->frames_captured,
+        (unsigned long long)stats->frames_drawn,
+        (unsigned long long)stats->frames_dropped,
+        fail_count, stats->fail_count_max,
+        (unsigned long long)stats->backend_fallbacks,
+        (unsigned long long)(import_avg_ns / 1000),
+        (unsigned long long)(stats->import_max_ns / 1000),
+        ctx->egl.width, ctx->egl.height, format,
+        (unsigned long long)bytes_per_sec,
+        (unsigned long long)(capture_latency_ns / 1000),
+        (unsigned long long)(present_latency_ns / 1000)
+    );
+    fflush(stdout);
+}
+
+// --- init_stats ---
+
+void wlm_mirror_stats_init(ctx_t * ctx) {
+    ctx_mirror_stats_t * stats = &ctx->mirror.stats;
+
+    stats->frames_captured = 0;
+    stats->frames_drawn = 0;
+    stats->frames_dropped = 0;
+
+    stats->fail_count_max = 0;
+    stats->backend_fallbacks = 0;
+
+    stats->imports = 0;
+    stats->import_total_ns = 0;
+    stats->import_max_ns = 0;
+    stats->last_import_ns = 0;
+    stats->drm_format = 0;
+
+    stats->bytes_uploaded = 0;
+
+    stats->last_query_ns = wlm_event_now_ns();
+    stats->last_query_bytes = 0;
+}
@@ -0,0 +1,274 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wlm/context.h>
+#include <wlm/mirror/timing.h>
+
+// interval between latency reports in the debug log
+#define REPORT_INTERVAL_NS 5000000000ull
+
+// --- helper functions ---
+
+static void frame_clear(wlm_mirror_timing_frame_t * frame) {
+    frame->feedback = NULL;
+    frame->source_ns = 0;
+    for (size_t i = 0; i < WLM_TIMING_NUM_STAGES; i++) {
+        frame->stages[i] = 0;
+    }
+}
+
+static void add_sample(wlm_mirror_timing_samples_t * samples, uint64_t value_ns) {
+    samples->samples[samples->next_sample] = value_ns;
+    samples->next_sample = (samples->next_sample + 1) % WLM_MIRROR_TIMING_SAMPLES;
+    if (samples->num_samples < WLM_MIRROR_TIMING_SAMPLES) samples->num_samples++;
+}
+
+static int compare_samples(const void * a, const void * b) {
+    uint64_t sample_a = *(const uint64_t *)a;
+    uint64_t sample_b = *(const uint64_t *)b;
+    return (sample_a > sample_b) - (sample_a < sample_b);
+}
+
+static void log_latency(ctx_t * ctx, const char * name, wlm_timing_latency_t latency) {
+    uint64_t p50, p90, p99;
+    if (!wlm_mirror_timing_percentile(ctx, latency, 50, &p50)) return;
+    wlm_mirror_timing_percentile(ctx, latency, 90, &p90);
+    wlm_mirror_timing_percentile(ctx, latency, 99, &p99);
+
+    wlm_log_debug(ctx, "mirror::timing::report(): %s latency p50 = %.2f ms, p90 = %.2f ms, p99 = %.2f ms\n",
+        name, p50 / 1e6, p90 / 1e6, p99 / 1e6
+    );
+}
+
+static void report(ctx_t * ctx, uint64_t now) {
+    if (now - ctx->mirror.timing.last_report_ns < REPORT_INTERVAL_NS) return;
+    ctx->mirror.timing.last_report_ns = now;
+
+    log_latency(ctx, "source-to-present", WLM_TIMING_LATENCY_SOURCE);
+    log_latency(ctx, "capture-to-present", WLM_TIMING_LATENCY_CAPTURE);
+    log_latency(ctx, "swap-to-present", WLM_TIMING_LATENCY_PRESENT);
+}
+
+static wlm_mirror_timing_frame_t * oldest_capture(ctx_t * ctx) {
+    ctx_mirror_timing_t * timing = &ctx->mirror.timing;
+    if (timing->num_captures == 0) return NULL;
+    return &timing->captures[timing->first_capture];
+}
+
+static void pop_capture(ctx_t * ctx) {
+    ctx_mirror_timing_t * timing = &ctx->mirror.timing;
+    if (timing->num_captures == 0) return;
+
+    frame_clear(&timing->captures[timing->first_capture]);
+    timing->first_capture = (timing->first_capture + 1) % WLM_MIRROR_TIMING_MAX_CAPTURES;
+    timing->num_captures--;
+}
+
+// --- presentation_feedback event handlers ---
+
+static void on_feedback_sync_output(
+    void * data, struct wp_presentation_feedback * feedback,
+    struct wl_output * output
+) {
+    (void)data;
+    (void)feedback;
+    (void)output;
+}
+
+static void on_feedback_presented(
+    void * data, struct wp_presentation_feedback * feedback,
+    uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec,
+    uint32_t refresh, uint32_t seq_hi, uint32_t seq_lo, uint32_t flags
+) {
+    wlm_mirror_timing_frame_t * frame = (wlm_mirror_timing_frame_t *)data;
+    ctx_t * ctx = frame->ctx;
+
+    wp_presentation_feedback_destroy(feedback);
+    frame->feedback = NULL;
+
+    // latencies can only be computed against our own clock
+    if (ctx->wl.presentation_clock == CLOCK_MONOTONIC) {
+        uint64_t sec = ((uint64_t)tv_sec_hi << 32) | tv_sec_lo;
+        uint64_t presented = sec * 1000000000 + tv_nsec;
+        frame->stages[WLM_TIMING_PRESENTED] = presented;
+
+        uint64_t source = frame->source_ns;
+        if (source != 0 && source <= presented) {
+            add_sample(&ctx->mirror.timing.latencies[WLM_TIMING_LATENCY_SOURCE], presented - source);
+        }
+
+        uint64_t requested = frame->stages[WLM_TIMING_CAPTURE_REQUESTED];
+        if (requested != 0 && requested <= presented) {
+            add_sample(&ctx->mirror.timing.latencies[WLM_TIMING_LATENCY_CAPTURE], presented - requested);
+        }
+
+        uint64_t swapped = frame->stages[WLM_TIMING_SWAP];
+        if (swapped != 0 && swapped <= presented) {
+            add_sample(&ctx->mirror.timing.latencies[WLM_TIMING_LATENCY_PRESENT], presented - swapped);
+        }
+
+        if (ctx->opt.verbose) report(ctx, presented);
+    }
+
+    frame_clear(frame);
+
+    (void)refresh;
+    (void)seq_hi;
+    (void)seq_lo;
+    (void)flags;
+}
+
+static void on_feedback_discarded(
+    void * data, struct wp_presentation_feedback * feedback
+) {
+    wlm_mirror_timing_frame_t * frame = (wlm_mirror_timing_frame_t *)data;
+
+    wp_presentation_feedback_destroy(feedback);
+    frame_clear(frame);
+}
+
+static const struct wp_presentation_feedback_listener feedback_listener = {
+    .sync_output = on_feedback_sync_output,
+    .presented = on_feedback_presented,
+    .discarded = on_feedback_discarded
+};
+
+// --- wlm_mirror_timing_mark ---
+
+void wlm_mirror_timing_mark(ctx_t * ctx, wlm_timing_stage_t stage) {
+    ctx_mirror_timing_t * timing = &ctx->mirror.timing;
+
+    if (stage == WLM_TIMING_CAPTURE_REQUESTED) {
+        // more captures than ring buffers, forget the oldest one
+        if (timing->num_captures == WLM_MIRROR_TIMING_MAX_CAPTURES) pop_capture(ctx);
+
+        size_t index = (timing->first_capture + timing->num_captures) % WLM_MIRROR_TIMING_MAX_CAPTURES;
+        timing->num_captures++;
+        frame_clear(&timing->captures[index]);
+        timing->captures[index].stages[stage] = wlm_event_now_ns();
+        return;
+    }
+
+    wlm_mirror_timing_frame_t * frame = oldest_capture(ctx);
+    if (frame == NULL) return;
+
+    frame->stages[stage] = wlm_event_now_ns();
+}
+
+void wlm_mirror_timing_source(ctx_t * ctx, uint64_t source_ns) {
+    wlm_mirror_timing_frame_t * frame = oldest_capture(ctx);
+    if (frame == NULL) return;
+
+    frame->source_ns = source_ns;
+}
+
+uint64_t wlm_mirror_timing_requested(ctx_t * ctx) {
+    wlm_mirror_timing_frame_t * frame = oldest_capture(ctx);
+    if (frame == NULL) return 0;
+
+    return frame->stages[WLM_TIMING_CAPTURE_REQUESTED];
+}
+
+void wlm_mirror_timing_reset(ctx_t * ctx) {
+    while (ctx->mirror.timing.num_captures > 0) pop_capture(ctx);
+    ctx->mirror.timing.first_capture = 0;
+}
+
+// --- wlm_mirror_timing_present ---
+
+void wlm_mirror_timing_present_begin(ctx_t * ctx) {
+    ctx_mirror_timing_t * timing = &ctx->mirror.timing;
+    timing->submitted = NULL;
+
+    // the oldest capture is the one being drawn
+    wlm_mirror_timing_frame_t * capture = oldest_capture(ctx);
+    if (capture == NULL) return;
+
+    if (ctx->wl.presentation == NULL) {
+        pop_capture(ctx);
+        return;
+    }
+
+    for (size_t i = 0; i < WLM_MIRROR_TIMING_MAX_FRAMES; i++) {
+        if (timing->frames[i].feedback == NULL) {
+            timing->submitted = &timing->frames[i];
+            break;
+        }
+    }
+
+    // too many frames waiting for feedback, skip this one
+    if (timing->submitted == NULL) {
+        pop_capture(ctx);
+        return;
+    }
+
+    wlm_mirror_timing_frame_t * frame = timing->submitted;
+    *frame = *capture;
+    frame->ctx = ctx;
+    frame->feedback = wp_presentation_feedback(ctx->wl.presentation, ctx->wl.surface);
+    wp_presentation_feedback_add_listener(frame->feedback, &feedback_listener, (void *)frame);
+
+    pop_capture(ctx);
+}
+
+void wlm_mirror_timing_present_end(ctx_t * ctx) {
+    ctx_mirror_timing_t * timing = &ctx->mirror.timing;
+    if (timing->submitted == NULL) return;
+
+    timing->submitted->stages[WLM_TIMING_SWAP] = wlm_event_now_ns();
+    timing->submitted = NULL;
+}
+
+// --- wlm_mirror_timing_percentile ---
+
+bool wlm_mirror_timing_percentile(ctx_t * ctx, wlm_timing_latency_t latency, unsigned int percent, uint64_t * value_ns) {
+    wlm_mirror_timing_samples_t * samples = &ctx->mirror.timing.latencies[latency];
+    if (samples->num_samples == 0) return false;
+    if (percent > 100) percent = 100;
+
+    uint64_t sorted[WLM_MIRROR_TIMING_SAMPLES];
+    memcpy(sorted, samples->samples, samples->num_samples * sizeof (uint64_t));
+    qsort(sorted, samples->num_samples, sizeof (uint64_t), compare_samples);
+
+    // nearest-rank percentile
+    size_t rank = (percent * samples->num_samples + 99) / 100;
+    if (rank > 0) rank--;
+
+    *value_ns = sorted[rank];
+    return true;
+}
+
+// --- init_timing ---
+
+void wlm_mirror_timing_init(ctx_t * ctx) {
+    ctx_mirror_timing_t * timing = &ctx->mirror.timing;
+
+    for (size_t i = 0; i < WLM_MIRROR_TIMING_MAX_CAPTURES; i++) {
+        timing->captures[i].ctx = ctx;
+        frame_clear(&timing->captures[i]);
+    }
+    timing->first_capture = 0;
+    timing->num_captures = 0;
+    for (size_t i = 0; i < WLM_MIRROR_TIMING_MAX_FRAMES; i++) {
+        timing->frames[i].ctx = ctx;
+        frame_clear(&timing->frames[i]);
+    }
+    timing->submitted = NULL;
+
+    for (size_t i = 0; i < WLM_TIMING_NUM_LATENCIES; i++) {
+        timing->latencies[i].num_samples = 0;
+        timing->latencies[i].next_sample = 0;
+    }
+    timing->last_report_ns = 0;
+}
+
+// --- cleanup_timing ---
+
+void wlm_mirror_timing_cleanup(ctx_t * ctx) {
+    ctx_mirror_timing_t * timing = &ctx->mirror.timing;
+
+    for (size_t i = 0; i < WLM_MIRROR_TIMING_MAX_FRAMES; i++) {
+        if (timing->frames[i].feedback != NULL) wp_presentation_feedback_destroy(timing->frames[i].feedback);
+        frame_clear(&timing->frames[i]);
+    }
+}
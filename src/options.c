@@ -10,22 +10,30 @@ void wlm_opt_init(ctx_t * ctx) {
     ctx->opt.show_cursor = true;
     ctx->opt.invert_colors = false;
     ctx->opt.freeze = false;
+    ctx->opt.hud = false;
+    ctx->opt.idle_capture = false;
     ctx->opt.has_region = false;
     ctx->opt.fullscreen = false;
     ctx->opt.scaling = SCALE_FIT;
     ctx->opt.scaling_filter = SCALE_FILTER_LINEAR;
     ctx->opt.backend = BACKEND_AUTO;
+    ctx->opt.dmabuf_allocator = DMABUF_ALLOCATOR_AUTO;
+    ctx->opt.capture_rate = CAPTURE_RATE_WINDOW;
+    ctx->opt.capture_fps = 0;
+    ctx->opt.max_fps = 0;
     ctx->opt.transform = (transform_t){ .rotation = ROT_NORMAL, .flip_x = false, .flip_y = false };
     ctx->opt.region = (region_t){ .x = 0, .y = 0, .width = 0, .height = 0 };
     ctx->opt.output = NULL;
     ctx->opt.fullscreen_output = NULL;
     ctx->opt.window_title = NULL;
+    ctx->opt.trace_file = NULL;
 }
 
 void wlm_cleanup_opt(ctx_t * ctx) {
     free(ctx->opt.output);
     free(ctx->opt.fullscreen_output);
     free(ctx->opt.window_title);
+    free(ctx->opt.trace_file);
 }
 
 bool wlm_opt_parse_scaling(scale_t * scaling, scale_filter_t * scaling_filter, const char * scaling_arg) {
@@ -53,6 +61,9 @@ bool wlm_opt_parse_backend(backend_t * backend, const char * backend_arg) {
     if (strcmp(backend_arg, "auto") == 0) {
         *backend = BACKEND_AUTO;
         return true;
+    } else if (strcmp(backend_arg, "auto-fastest") == 0) {
+        *backend = BACKEND_AUTO_FASTEST;
+        return true;
     } else if (strcmp(backend_arg, "export-dmabuf") == 0) {
         *backend = BACKEND_EXPORT_DMABUF;
         return true;
@@ -83,6 +94,47 @@ bool wlm_opt_parse_backend(backend_t * backend, const char * backend_arg) {
     }
 }
 
+bool wlm_opt_parse_dmabuf_allocator(dmabuf_allocator_t * dmabuf_allocator, const char * dmabuf_allocator_arg) {
+    if (strcmp(dmabuf_allocator_arg, "auto") == 0) {
+        *dmabuf_allocator = DMABUF_ALLOCATOR_AUTO;
+        return true;
+    } else if (strcmp(dmabuf_allocator_arg, "gbm") == 0) {
+        *dmabuf_allocator = DMABUF_ALLOCATOR_GBM;
+        return true;
+    } else if (strcmp(dmabuf_allocator_arg, "dma-heap") == 0) {
+        *dmabuf_allocator = DMABUF_ALLOCATOR_DMA_HEAP;
+        return true;
+    } else {
+        return false;
+    }
+}
+
+bool wlm_opt_parse_fps(uint32_t * fps, const char * fps_arg) {
+    char * end = NULL;
+    long value = strtol(fps_arg, &end, 10);
+    if (end == fps_arg || *end != '\0' || value <= 0 || value > 1000) {
+        return false;
+    }
+
+    *fps = value;
+    return true;
+}
+
+bool wlm_opt_parse_capture_rate(capture_rate_t * capture_rate, uint32_t * capture_fps, const char * capture_rate_arg) {
+    if (strcmp(capture_rate_arg, "window") == 0) {
+        *capture_rate = CAPTURE_RATE_WINDOW;
+        return true;
+    } else if (strcmp(capture_rate_arg, "source") == 0) {
+        *capture_rate = CAPTURE_RATE_SOURCE;
+        return true;
+    } else if (wlm_opt_parse_fps(capture_fps, capture_rate_arg)) {
+        *capture_rate = CAPTURE_RATE_FIXED;
+        return true;
+    } else {
+        return false;
+    }
+}
+
 bool wlm_opt_parse_transform(transform_t * transform, const char * transform_arg) {
     transform_t local_transform = { .rotation = ROT_NORMAL, .flip_x = false, .flip_y = false };
 
@@ -372,6 +424,11 @@ void wlm_opt_usage(ctx_t * ctx) {
     printf("  -f,   --freeze                freeze the current image on the screen\n");
     printf("        --unfreeze              resume the screen capture after a freeze\n");
     printf("        --toggle-freeze         toggle freeze state of screen capture\n");
+    printf("        --hud                   show a performance overlay in the mirror window\n");
+    printf("        --no-hud                hide the performance overlay (default)\n");
+    printf("        --toggle-hud            toggle the performance overlay\n");
+    printf("        --idle-capture          only capture and redraw when the screen changes (screencopy backends)\n");
+    printf("        --no-idle-capture       capture and redraw every frame (default)\n");
     printf("  -F,   --fullscreen            display wl-mirror as fullscreen\n");
     printf("        --no-fullscreen         display wl-mirror as a window (default)\n");
     printf("        --fullscreen-output O   set fullscreen target output to output O, implies --fullscreen\n");
@@ -382,14 +439,21 @@ void wlm_opt_usage(ctx_t * ctx) {
     printf("  -s l, --scaling linear        use linear scaling (default)\n");
     printf("  -s n, --scaling nearest       use nearest neighbor scaling\n");
     printf("  -b B  --backend B             use a specific backend for capturing the screen\n");
+    printf("        --dmabuf-allocator A    allocate DMA-BUFs with allocator A (default: auto)\n");
+    printf("        --capture-rate R        capture at rate R (default: window)\n");
+    printf("        --max-fps N             capture at most N frames per second\n");
+    printf("        --no-max-fps            don't limit the capture frame rate (default)\n");
     printf("  -t T, --transform T           apply custom transform T\n");
     printf("  -r R, --region R              capture custom region R\n");
     printf("        --no-region             capture the entire output (default)\n");
     printf("  -S,   --stream                accept a stream of additional options on stdin\n");
     printf("        --title N               specify a custom title N for the mirror window\n");
+    printf("        --trace-file P          write a trace of the frame pipeline to P (trace event JSON)\n");
+    printf("        --stats                 print frame statistics to stdout (stream mode only)\n");
     printf("\n");
     printf("backends:\n");
     printf("  - auto                automatically try the backends in order of efficiency and use the first that works (default)\n");
+    printf("  - auto-fastest        briefly try each backend at startup and use the one with the fastest captures\n");
     printf("  - export-dmabuf       use the wlr-export-dmabuf-unstable-v1 protocol to capture outputs\n");
     printf("  - screencopy          use the wlr-screencopy-unstable-v1 protocol to capture outputs (auto)\n");
     printf("  - screencopy-dmabuf   use the wlr-screencopy-unstable-v1 protocol to capture outputs (via DMA-BUF)\n");
@@ -398,6 +462,17 @@ void wlm_opt_usage(ctx_t * ctx) {
     printf("  - extcopy-dmabuf      use the ext-image-copy-capture-v1 protocol to capture outputs (via DMA-BUF)\n");
     printf("  - extcopy-shm         use the ext-image-copy-capture-v1 protocol to capture outputs (via SHM)\n");
     printf("\n");
+    printf("dmabuf allocators:\n");
+    printf("  - auto                use GBM if available, otherwise the system dma-heap (default)\n");
+    printf("  - gbm                 allocate through a GBM device, supports tiled buffers\n");
+    printf("  - dma-heap            allocate linear buffers from /dev/dma_heap/system, needs no GPU driver\n");
+    printf("\n");
+    printf("capture rates:\n");
+    printf("  - window              capture a new frame for every frame the mirror window draws (default)\n");
+    printf("  - source              like window, but at most at the refresh rate of the mirrored output\n");
+    printf("  - <N>                 capture N frames per second, independent of the mirror window\n");
+    printf("  --max-fps limits both capture rates, e.g. to save power on background mirrors\n");
+    printf("\n");
     printf("transforms:\n");
     printf("  transforms are specified as a dash-separated list of flips followed by a rotation\n");
     printf("  flips are applied before rotations\n");
@@ -422,6 +497,7 @@ void wlm_opt_usage(ctx_t * ctx) {
     printf("    quoted or fully unquoted\n");
     printf("  - unquoted arguments are split on whitespace\n");
     printf("  - no escape sequences are implemented\n");
+    printf("  - a --stats line prints a single line of frame statistics to stdout\n");
     printf("\n");
     printf("title placeholders:\n");
     printf("  the title string supports the following placeholders:\n");
@@ -453,6 +529,13 @@ void wlm_opt_parse(ctx_t * ctx, int argc, char ** argv) {
     bool new_fullscreen_output = false;
     char * region_output = NULL;
     char * arg_output = NULL;
+    bool print_stats = false;
+
+    // a stats query on its own doesn't update any options
+    if (!is_cli_args && argc == 1 && strcmp(argv[0], "--stats") == 0) {
+        wlm_mirror_stats_print(ctx);
+        return;
+    }
 
     while (argc > 0 && argv[0][0] == '-') {
         if (is_cli_args && (strcmp(argv[0], "-h") == 0 || strcmp(argv[0], "--help") == 0)) {
@@ -480,6 +563,16 @@ void wlm_opt_parse(ctx_t * ctx, int argc, char ** argv) {
             ctx->opt.freeze = false;
         } else if (strcmp(argv[0], "--toggle-freeze") == 0) {
             ctx->opt.freeze ^= 1;
+        } else if (strcmp(argv[0], "--hud") == 0) {
+            ctx->opt.hud = true;
+        } else if (strcmp(argv[0], "--no-hud") == 0) {
+            ctx->opt.hud = false;
+        } else if (strcmp(argv[0], "--toggle-hud") == 0) {
+            ctx->opt.hud ^= 1;
+        } else if (strcmp(argv[0], "--idle-capture") == 0) {
+            ctx->opt.idle_capture = true;
+        } else if (strcmp(argv[0], "--no-idle-capture") == 0) {
+            ctx->opt.idle_capture = false;
         } else if (strcmp(argv[0], "-F") == 0 || strcmp(argv[0], "--fullscreen") == 0) {
             ctx->opt.fullscreen = true;
         } else if (strcmp(argv[0], "--no-fullscreen") == 0) {
@@ -528,6 +621,49 @@ void wlm_opt_parse(ctx_t * ctx, int argc, char ** argv) {
                 argv++;
                 argc--;
             }
+        } else if (strcmp(argv[0], "--dmabuf-allocator") == 0) {
+            if (argc < 2) {
+                wlm_log_error("options::parse(): option %s requires an argument\n", argv[0]);
+                if (is_cli_args) wlm_exit_fail(ctx);
+            } else {
+                if (!wlm_opt_parse_dmabuf_allocator(&ctx->opt.dmabuf_allocator, argv[1])) {
+                    wlm_log_error("options::parse(): invalid dmabuf allocator %s\n", argv[1]);
+                    if (is_cli_args) wlm_exit_fail(ctx);
+                }
+
+                // buffers are allocated when the backend opens its device
+                new_backend = true;
+                argv++;
+                argc--;
+            }
+        } else if (strcmp(argv[0], "--capture-rate") == 0) {
+            if (argc < 2) {
+                wlm_log_error("options::parse(): option %s requires an argument\n", argv[0]);
+                if (is_cli_args) wlm_exit_fail(ctx);
+            } else {
+                if (!wlm_opt_parse_capture_rate(&ctx->opt.capture_rate, &ctx->opt.capture_fps, argv[1])) {
+                    wlm_log_error("options::parse(): invalid capture rate %s\n", argv[1]);
+                    if (is_cli_args) wlm_exit_fail(ctx);
+                }
+
+                argv++;
+                argc--;
+            }
+        } else if (strcmp(argv[0], "--max-fps") == 0) {
+            if (argc < 2) {
+                wlm_log_error("options::parse(): option %s requires an argument\n", argv[0]);
+                if (is_cli_args) wlm_exit_fail(ctx);
+            } else {
+                if (!wlm_opt_parse_fps(&ctx->opt.max_fps, argv[1])) {
+                    wlm_log_error("options::parse(): invalid frame rate %s\n", argv[1]);
+                    if (is_cli_args) wlm_exit_fail(ctx);
+                }
+
+                argv++;
+                argc--;
+            }
+        } else if (strcmp(argv[0], "--no-max-fps") == 0) {
+            ctx->opt.max_fps = 0;
         } else if (strcmp(argv[0], "-t") == 0 || strcmp(argv[0], "--transform") == 0) {
             if (argc < 2) {
                 wlm_log_error("options::parse(): option %s requires an argument\n", argv[0]);
@@ -581,6 +717,28 @@ void wlm_opt_parse(ctx_t * ctx, int argc, char ** argv) {
                 argv++;
                 argc--;
             }
+        } else if (strcmp(argv[0], "--trace-file") == 0) {
+            if (argc < 2) {
+                wlm_log_error("options::parse(): option %s requires an argument\n", argv[0]);
+                if (is_cli_args) wlm_exit_fail(ctx);
+            } else {
+                if (!is_cli_args) {
+                    wlm_log_error("options::parse(): option %s can only be set on the command line\n", argv[0]);
+                } else {
+                    free(ctx->opt.trace_file);
+                    ctx->opt.trace_file = strdup(argv[1]);
+                }
+
+                argv++;
+                argc--;
+            }
+        } else if (strcmp(argv[0], "--stats") == 0) {
+            if (is_cli_args) {
+                wlm_log_error("options::parse(): option %s can only be used in stream mode\n", argv[0]);
+                wlm_exit_fail(ctx);
+            }
+
+            print_stats = true;
         } else if (strcmp(argv[0], "--") == 0) {
             argv++;
             argc--;
@@ -680,5 +838,9 @@ void wlm_opt_parse(ctx_t * ctx, int argc, char ** argv) {
         wlm_mirror_update_title(ctx);
         wlm_mirror_options_updated(ctx);
     }
+
+    if (print_stats) {
+        wlm_mirror_stats_print(ctx);
+    }
 }
 
@@ -195,6 +195,7 @@ void wlm_stream_init(ctx_t * ctx) {
     ctx->stream.event_handler.fd = STDIN_FILENO;
     ctx->stream.event_handler.events = EPOLLIN;
     ctx->stream.event_handler.timeout_ms = -1;
+    ctx->stream.event_handler.is_timer = false;
     ctx->stream.event_handler.on_event = on_stream_data;
     ctx->stream.event_handler.on_each = NULL;
 
@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <wlm/context.h>
+#include <wlm/trace.h>
+
+// buffered spans are written out once per interval
+#define FLUSH_INTERVAL_NS 1000000000ull
+
+// --- flush ---
+
+static bool write_all(int fd, const char * data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written == -1 && errno == EINTR) continue;
+        if (written == -1) return false;
+
+        data += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+static size_t format_span(ctx_trace_t * trace, char * dst, const char * name, uint64_t start_ns, uint64_t end_ns) {
+    uint64_t duration_ns = end_ns - start_ns;
+
+    // trace event timestamps are in microseconds
+    int len = snprintf(dst, WLM_TRACE_SPAN_SIZE,
+        "%s{\"name\":\"%s\",\"cat\":\"wl-mirror\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%llu.%03u,\"dur\":%llu.%03u}",
+        trace->first_span ? "\n" : ",\n", name, trace->pid, trace->pid,
+        (unsigned long long)(start_ns / 1000), (unsigned int)(start_ns % 1000),
+        (unsigned long long)(duration_ns / 1000), (unsigned int)(duration_ns % 1000)
+    );
+
+    // a truncated span would break the json, drop it
+    if (len < 0 || len >= WLM_TRACE_SPAN_SIZE) return 0;
+
+    trace->first_span = false;
+    return len;
+}
+
+static const char * flush_span_name = "trace::flush";
+
+static void flush(ctx_t * ctx) {
+    ctx_trace_t * trace = &ctx->trace;
+    if (trace->num_spans == 0 && trace->dropped_spans == 0) return;
+
+    // keep a lone span of the previous flush until there is something else to write
+    if (trace->num_spans == 1 && trace->spans[0].name == flush_span_name && trace->dropped_spans == 0) return;
+
+    uint64_t start_ns = wlm_event_now_ns();
+    size_t size = 0;
+    for (size_t i = 0; i < trace->num_spans; i++) {
+        wlm_trace_span_t * span = &trace->spans[i];
+        size += format_span(trace, trace->buffer + size, span->name, span->start_ns, span->end_ns);
+    }
+
+    if (trace->dropped_spans > 0) {
+        wlm_log_warn("trace::flush(): span buffer full, dropped %zd spans\n", trace->dropped_spans);
+    }
+
+    trace->num_spans = 0;
+    trace->dropped_spans = 0;
+    if (!write_all(trace->fd, trace->buffer, size)) {
+        wlm_log_error("trace::flush(): failed to write trace file, disabling tracing\n");
+        trace->enabled = false;
+        return;
+    }
+
+    // the flush itself shows up in the next flush
+    wlm_trace_record(trace, flush_span_name, start_ns, wlm_event_now_ns());
+}
+
+static void on_flush_timer(ctx_t * ctx, uint32_t events) {
+    flush(ctx);
+    wlm_event_arm_timer(ctx, &ctx->trace.flush_timer, wlm_event_now_ns() + FLUSH_INTERVAL_NS);
+
+    (void)events;
+}
+
+// --- wlm_trace_record ---
+
+void wlm_trace_record(ctx_trace_t * trace, const char * name, uint64_t start_ns, uint64_t end_ns) {
+    if (trace->num_spans == WLM_TRACE_MAX_SPANS) {
+        trace->dropped_spans++;
+        return;
+    }
+
+    wlm_trace_span_t * span = &trace->spans[trace->num_spans++];
+    span->name = name;
+    span->start_ns = start_ns;
+    span->end_ns = end_ns;
+}
+
+// --- init_trace ---
+
+void wlm_trace_init(ctx_t * ctx) {
+    ctx->trace.fd = -1;
+    ctx->trace.pid = getpid();
+    ctx->trace.flush_timer.next = NULL;
+    ctx->trace.flush_timer.fd = -1;
+    ctx->trace.flush_timer.on_event = on_flush_timer;
+    ctx->trace.flush_timer.on_each = NULL;
+    ctx->trace.spans = NULL;
+    ctx->trace.num_spans = 0;
+    ctx->trace.dropped_spans = 0;
+    ctx->trace.first_span = true;
+    ctx->trace.buffer = NULL;
+    ctx->trace.enabled = false;
+    ctx->trace.initialized = true;
+
+    if (ctx->opt.trace_file == NULL) return;
+
+    ctx->trace.spans = calloc(WLM_TRACE_MAX_SPANS, sizeof (wlm_trace_span_t));
+    if (ctx->trace.spans == NULL) {
+        wlm_log_error("trace::init(): failed to allocate span buffer\n");
+        wlm_exit_fail(ctx);
+    }
+
+    ctx->trace.buffer = malloc(WLM_TRACE_MAX_SPANS * WLM_TRACE_SPAN_SIZE);
+    if (ctx->trace.buffer == NULL) {
+        wlm_log_error("trace::init(): failed to allocate format buffer\n");
+        wlm_exit_fail(ctx);
+    }
+
+    ctx->trace.fd = open(ctx->opt.trace_file, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (ctx->trace.fd == -1) {
+        wlm_log_error("trace::init(): failed to open trace file %s\n", ctx->opt.trace_file);
+        wlm_exit_fail(ctx);
+    }
+
+    wlm_log_debug(ctx, "trace::init(): writing trace to %s\n", ctx->opt.trace_file);
+    write_all(ctx->trace.fd, "[", 1);
+
+    wlm_event_add_timer(ctx, &ctx->trace.flush_timer);
+    wlm_event_arm_timer(ctx, &ctx->trace.flush_timer, wlm_event_now_ns() + FLUSH_INTERVAL_NS);
+    ctx->trace.enabled = true;
+}
+
+// --- cleanup_trace ---
+
+void wlm_trace_cleanup(ctx_t * ctx) {
+    if (!ctx->trace.initialized) return;
+
+    wlm_log_debug(ctx, "trace::cleanup(): closing trace file\n");
+
+    if (ctx->trace.fd != -1) {
+        if (ctx->trace.enabled) flush(ctx);
+        write_all(ctx->trace.fd, "\n]\n", 3);
+        close(ctx->trace.fd);
+    }
+
+    wlm_event_remove_timer(ctx, &ctx->trace.flush_timer);
+    free(ctx->trace.spans);
+    free(ctx->trace.buffer);
+
+    ctx->trace.fd = -1;
+    ctx->trace.spans = NULL;
+    ctx->trace.buffer = NULL;
+    ctx->trace.enabled = false;
+    ctx->trace.initialized = false;
+}
@@ -72,12 +72,21 @@ static void on_output_mode(
     void * data, struct wl_output * output,
     uint32_t flags, int32_t width, int32_t height, int32_t refresh
 ) {
-    (void)data;
+    output_list_node_t * node = (output_list_node_t *)data;
+    ctx_t * ctx = node->ctx;
+
+    // only the current mode determines the refresh rate
+    if (!(flags & WL_OUTPUT_MODE_CURRENT)) return;
+
+    // update refresh only if changed
+    if (node->refresh != refresh) {
+        wlm_log_debug(ctx, "wayland::on_output_mode(): updating output %s (refresh = %d mHz, id = %d)\n", node->name, refresh, node->output_id);
+        node->refresh = refresh;
+    }
+
     (void)output;
-    (void)flags;
     (void)width;
     (void)height;
-    (void)refresh;
 }
 
 static void on_output_scale(
@@ -114,6 +123,24 @@ static const struct wl_output_listener output_listener = {
     .done = on_output_done
 };
 
+// --- presentation event handlers ---
+
+static void on_presentation_clock_id(
+    void * data, struct wp_presentation * presentation,
+    uint32_t clock_id
+) {
+    ctx_t * ctx = (ctx_t *)data;
+
+    wlm_log_debug(ctx, "wayland::on_presentation_clock_id(): presentation clock is %d\n", clock_id);
+    ctx->wl.presentation_clock = clock_id;
+
+    (void)presentation;
+}
+
+static const struct wp_presentation_listener presentation_listener = {
+    .clock_id = on_presentation_clock_id
+};
+
 // --- xdg_output event handlers ---
 
 static void on_xdg_output_description(
@@ -209,6 +236,15 @@ static void on_registry_add(
 
     wlm_log_debug(ctx, "wayland::on_registry_add(): %s (version = %d, id = %d)\n", interface, version, id);
 
+    // outputs and seats come and go with the hardware, they don't identify the compositor
+    // - summing keeps the hash independent of the announcement order
+    if (strcmp(interface, wl_output_interface.name) != 0 && strcmp(interface, wl_seat_interface.name) != 0) {
+        char version_str[16];
+        snprintf(version_str, sizeof version_str, "%u", version);
+        uint64_t hash = wlm_mirror_cache_hash(WLM_MIRROR_CACHE_HASH_INIT, interface);
+        ctx->wl.globals_hash += wlm_mirror_cache_hash(hash, version_str);
+    }
+
     // bind proxy object for each protocol we need
     // bind proxy object for each output
     if (strcmp(interface, wl_compositor_interface.name) == 0) {
@@ -264,6 +300,19 @@ static void on_registry_add(
             registry, id, &zxdg_output_manager_v1_interface, 2
         );
         ctx->wl.output_manager_id = id;
+    } else if (strcmp(interface, wp_presentation_interface.name) == 0) {
+        if (ctx->wl.presentation != NULL) {
+            wlm_log_error("wayland::on_registry_add(): duplicate wp_presentation\n");
+            wlm_exit_fail(ctx);
+        }
+
+        // bind wp_presentation object
+        // - for latency tracking, optional
+        ctx->wl.presentation = (struct wp_presentation *)wl_registry_bind(
+            registry, id, &wp_presentation_interface, 1
+        );
+        ctx->wl.presentation_id = id;
+        wp_presentation_add_listener(ctx->wl.presentation, &presentation_listener, (void *)ctx);
     } else if (strcmp(interface, zwlr_export_dmabuf_manager_v1_interface.name) == 0) {
         if (ctx->wl.dmabuf_manager != NULL) {
             wlm_log_error("wayland::on_registry_add(): duplicate dmabuf_manager\n");
@@ -365,6 +414,7 @@ static void on_registry_add(
         node->width = 0;
         node->height = 0;
         node->scale = 1;
+        node->refresh = 0;
         node->transform = 0;
 
         // prepend output node to output list
@@ -452,6 +502,13 @@ static void on_registry_remove(
     } else if (id == ctx->wl.output_manager_id) {
         wlm_log_error("wayland::on_registry_remove(): output_manager disappeared\n");
         wlm_exit_fail(ctx);
+    } else if (id == ctx->wl.presentation_id) {
+        // presentation feedback is optional, stop measuring latencies
+        wlm_log_warn("wayland::on_registry_remove(): presentation disappeared, disabling presentation feedback\n");
+        wp_presentation_destroy(ctx->wl.presentation);
+        ctx->wl.presentation = NULL;
+        ctx->wl.presentation_id = 0;
+        ctx->wl.presentation_clock = (uint32_t)-1;
     } else if (id == ctx->wl.shm_id) {
         wlm_log_error("wayland::on_registry_remove(): shm disappeared\n");
         wlm_exit_fail(ctx);
@@ -898,6 +955,7 @@ void wlm_wayland_init(ctx_t * ctx) {
     // initialize context structure
     ctx->wl.display = NULL;
     ctx->wl.registry = NULL;
+    ctx->wl.globals_hash = 0;
 
     ctx->wl.compositor = NULL;
     ctx->wl.compositor_id = 0;
@@ -909,6 +967,9 @@ void wlm_wayland_init(ctx_t * ctx) {
     ctx->wl.wm_base_id = 0;
     ctx->wl.output_manager = NULL;
     ctx->wl.output_manager_id = 0;
+    ctx->wl.presentation = NULL;
+    ctx->wl.presentation_id = 0;
+    ctx->wl.presentation_clock = (uint32_t)-1;
 
     ctx->wl.shm = NULL;
     ctx->wl.shm_id = 0;
@@ -950,6 +1011,7 @@ void wlm_wayland_init(ctx_t * ctx) {
     ctx->wl.event_handler.fd = -1;
     ctx->wl.event_handler.events = EPOLLIN;
     ctx->wl.event_handler.timeout_ms = -1;
+    ctx->wl.event_handler.is_timer = false;
     ctx->wl.event_handler.on_event = on_wayland_event;
     ctx->wl.event_handler.on_each = on_wayland_each;
 
@@ -1261,6 +1323,7 @@ void wlm_wayland_cleanup(ctx_t *ctx) {
     if (ctx->wl.viewport != NULL) wp_viewport_destroy(ctx->wl.viewport);
     if (ctx->wl.surface != NULL) wl_surface_destroy(ctx->wl.surface);
     if (ctx->wl.output_manager != NULL) zxdg_output_manager_v1_destroy(ctx->wl.output_manager);
+    if (ctx->wl.presentation != NULL) wp_presentation_destroy(ctx->wl.presentation);
     if (ctx->wl.wm_base != NULL) xdg_wm_base_destroy(ctx->wl.wm_base);
     if (ctx->wl.fractional_scale_manager != NULL) wp_fractional_scale_manager_v1_destroy(ctx->wl.fractional_scale_manager);
     if (ctx->wl.viewporter != NULL) wp_viewporter_destroy(ctx->wl.viewporter);
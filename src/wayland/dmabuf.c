@@ -1,9 +1,16 @@
 #include "wlm/proto/linux-dmabuf-unstable-v1.h"
 #include <wlm/context.h>
+#include <wlm/egl/dmabuf.h>
+#include <wlm/egl/formats.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#if __linux__
+#include <linux/dma-heap.h>
+#endif
 
 #ifdef WITH_GBM
 #include <xf86drm.h>
@@ -11,32 +18,47 @@
 
 // --- linux_dmabuf_feedback event handlers ---
 
+// entry of the format table shared by the compositor
+typedef struct {
+    uint32_t drm_format;
+    uint32_t padding;
+    uint64_t modifier;
+} format_table_entry_t;
+
 static void on_linux_dmabuf_feedback_main_device(void * data, struct zwp_linux_dmabuf_feedback_v1 * feedback, struct wl_array * device) {
     ctx_t * ctx = (ctx_t *)data;
-    wlm_log_debug(ctx, "wayland::dmabuf::on_feedback_main_device(): opening main device\n");
+    wlm_log_debug(ctx, "wayland::dmabuf::on_feedback_main_device(): received main device\n");
 
     if (device->size != sizeof (dev_t)) {
         wlm_log_error("array size mismatch: %zd != %zd\n", device->size, sizeof (dev_t));
         wlm_exit_fail(ctx);
     }
 
-    dev_t device_id;
-    memcpy(&device_id, device->data, sizeof (dev_t));
-
-    if (ctx->wl.dmabuf.open_device_callback != NULL) {
-        bool success = wlm_wayland_dmabuf_open_device(ctx, device_id);
-        ctx->wl.dmabuf.open_device_callback(ctx, success);
-        ctx->wl.dmabuf.open_device_callback = NULL;
-    }
+    memcpy(&ctx->wl.dmabuf.main_device, device->data, sizeof (dev_t));
 
     (void)feedback;
 }
 
 static void on_linux_dmabuf_feedback_format_table(void * data, struct zwp_linux_dmabuf_feedback_v1 * feedback, int fd, uint32_t size) {
-    (void)data;
+    ctx_t * ctx = (ctx_t *)data;
+    wlm_log_debug(ctx, "wayland::dmabuf::on_feedback_format_table(): received format table with %zd entries\n", size / sizeof (format_table_entry_t));
+
+    if (ctx->wl.dmabuf.format_table != NULL) munmap(ctx->wl.dmabuf.format_table, ctx->wl.dmabuf.format_table_size);
+    ctx->wl.dmabuf.format_table = NULL;
+    ctx->wl.dmabuf.format_table_size = 0;
+
+    // NOTE: the table must be mapped with MAP_PRIVATE
+    void * format_table = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (format_table == MAP_FAILED) {
+        wlm_log_error("wayland::dmabuf::on_feedback_format_table(): failed to map format table\n");
+        return;
+    }
+
+    ctx->wl.dmabuf.format_table = format_table;
+    ctx->wl.dmabuf.format_table_size = size;
+
     (void)feedback;
-    (void)fd;
-    (void)size;
 }
 
 static void on_linux_dmabuf_feedback_tranche_target_device(void * data, struct zwp_linux_dmabuf_feedback_v1 * feedback, struct wl_array * device) {
@@ -46,30 +68,84 @@ static void on_linux_dmabuf_feedback_tranche_target_device(void * data, struct z
 }
 
 static void on_linux_dmabuf_feedback_tranche_flags(void * data, struct zwp_linux_dmabuf_feedback_v1 * feedback, enum zwp_linux_dmabuf_feedback_v1_tranche_flags flags) {
-    (void)data;
+    ctx_t * ctx = (ctx_t *)data;
+
+    ctx->wl.dmabuf.pending_scanout = (flags & ZWP_LINUX_DMABUF_FEEDBACK_V1_TRANCHE_FLAGS_SCANOUT) != 0;
+
     (void)feedback;
-    (void)flags;
 }
 
 static void on_linux_dmabuf_feedback_tranche_formats(void * data, struct zwp_linux_dmabuf_feedback_v1 * feedback, struct wl_array * indices) {
-    (void)data;
+    ctx_t * ctx = (ctx_t *)data;
+    wlm_wayland_dmabuf_feedback_formats_t * pending = &ctx->wl.dmabuf.pending_formats;
+
+    const format_table_entry_t * format_table = ctx->wl.dmabuf.format_table;
+    size_t num_entries = ctx->wl.dmabuf.format_table_size / sizeof (format_table_entry_t);
+    size_t num_indices = indices->size / sizeof (uint16_t);
+    if (format_table == NULL) {
+        wlm_log_error("wayland::dmabuf::on_feedback_tranche_formats(): missing format table\n");
+        return;
+    }
+
+    if (pending->num_formats + num_indices > pending->capacity) {
+        size_t capacity = pending->num_formats + num_indices;
+        wlm_wayland_dmabuf_feedback_format_t * formats = realloc(pending->formats, capacity * sizeof *formats);
+        if (formats == NULL) {
+            wlm_log_error("wayland::dmabuf::on_feedback_tranche_formats(): failed to allocate format array\n");
+            return;
+        }
+
+        pending->formats = formats;
+        pending->capacity = capacity;
+    }
+
+    // resolve indices now, later feedback may replace the table
+    const uint16_t * index_data = indices->data;
+    for (size_t i = 0; i < num_indices; i++) {
+        if (index_data[i] >= num_entries) {
+            wlm_log_error("wayland::dmabuf::on_feedback_tranche_formats(): format index %d out of bounds\n", index_data[i]);
+            continue;
+        }
+
+        wlm_wayland_dmabuf_feedback_format_t * format = &pending->formats[pending->num_formats++];
+        format->drm_format = format_table[index_data[i]].drm_format;
+        format->modifier = format_table[index_data[i]].modifier;
+        format->scanout = ctx->wl.dmabuf.pending_scanout;
+    }
+
     (void)feedback;
-    (void)indices;
 }
 
 static void on_linux_dmabuf_feedback_tranche_done(void * data, struct zwp_linux_dmabuf_feedback_v1 * feedback) {
-    (void)data;
+    ctx_t * ctx = (ctx_t *)data;
+
+    ctx->wl.dmabuf.pending_scanout = false;
+
     (void)feedback;
 }
 
 static void on_linux_dmabuf_feedback_done(void * data, struct zwp_linux_dmabuf_feedback_v1 * feedback) {
     ctx_t * ctx = (ctx_t *)data;
-    wlm_log_debug(ctx, "wayland::dmabuf::feedback_done(): feedback done\n");
+
+    // every feedback update resends all tranches
+    wlm_wayland_dmabuf_feedback_formats_t formats = ctx->wl.dmabuf.formats;
+    ctx->wl.dmabuf.formats = ctx->wl.dmabuf.pending_formats;
+    ctx->wl.dmabuf.pending_formats = formats;
+    ctx->wl.dmabuf.pending_formats.num_formats = 0;
+    ctx->wl.dmabuf.pending_scanout = false;
+    ctx->wl.dmabuf.feedback_serial++;
+    wlm_log_debug(ctx, "wayland::dmabuf::feedback_done(): feedback done, %zd formats\n", ctx->wl.dmabuf.formats.num_formats);
+
+    wlm_wayland_dmabuf_callback_t * cb = ctx->wl.dmabuf.open_device_callback;
+    ctx->wl.dmabuf.open_device_callback = NULL;
+    if (cb != NULL) {
+        bool success = wlm_wayland_dmabuf_open_device(ctx, ctx->wl.dmabuf.main_device);
+        cb(ctx, success);
+    }
 
     (void)feedback;
 }
 
-
 static const struct zwp_linux_dmabuf_feedback_v1_listener linux_dmabuf_feedback_listener = {
     .main_device = on_linux_dmabuf_feedback_main_device,
     .format_table = on_linux_dmabuf_feedback_format_table,
@@ -80,52 +156,206 @@ static const struct zwp_linux_dmabuf_feedback_v1_listener linux_dmabuf_feedback_
     .done = on_linux_dmabuf_feedback_done
 };
 
+// --- helper functions ---
+
+static ctx_wl_dmabuf_buffer_t * wlm_wayland_dmabuf_find_params(ctx_t * ctx, struct zwp_linux_buffer_params_v1 * buffer_params) {
+    for (size_t i = 0; i < WLM_WAYLAND_DMABUF_POOL_SIZE; i++) {
+        if (ctx->wl.dmabuf.buffers[i].buffer_params == buffer_params) return &ctx->wl.dmabuf.buffers[i];
+    }
+
+    return NULL;
+}
+
+static bool contains_modifier(const uint64_t * modifiers, size_t num_modifiers, uint64_t modifier) {
+    for (size_t i = 0; i < num_modifiers; i++) {
+        if (modifiers[i] == modifier) return true;
+    }
+
+    return false;
+}
+
+static bool egl_accepts_modifier(ctx_t * ctx, uint32_t drm_format, uint64_t modifier) {
+    // no format list, let the import decide
+    dmabuf_formats_t * egl_formats = &ctx->egl.dmabuf_formats;
+    if (egl_formats->formats == NULL) return true;
+
+    for (size_t i = 0; i < egl_formats->num_formats; i++) {
+        dmabuf_format_t * format = &egl_formats->formats[i];
+        if (format->drm_format != drm_format) continue;
+        return contains_modifier(format->modifiers, format->num_modifiers, modifier);
+    }
+
+    return false;
+}
+
+// collect the modifiers accepted by the compositor, EGL, and the capture source
+// - selected must have room for all feedback formats
+static size_t select_modifiers(ctx_t * ctx, uint32_t drm_format, uint64_t * modifiers, size_t num_modifiers, bool scanout_only, uint64_t * selected) {
+    wlm_wayland_dmabuf_feedback_formats_t * feedback = &ctx->wl.dmabuf.formats;
+    size_t num_selected = 0;
+
+    for (size_t i = 0; i < feedback->num_formats; i++) {
+        wlm_wayland_dmabuf_feedback_format_t * format = &feedback->formats[i];
+        if (format->drm_format != drm_format) continue;
+        if (scanout_only && !format->scanout) continue;
+        if (modifiers != NULL && !contains_modifier(modifiers, num_modifiers, format->modifier)) continue;
+        if (!egl_accepts_modifier(ctx, drm_format, format->modifier)) continue;
+        if (contains_modifier(selected, num_selected, format->modifier)) continue;
+
+        selected[num_selected++] = format->modifier;
+    }
+
+    return num_selected;
+}
+
+// check if select_modifiers() could have picked a modifier without a list from the capture source
+static bool feedback_accepts_modifier(ctx_t * ctx, uint32_t drm_format, uint64_t modifier) {
+    wlm_wayland_dmabuf_feedback_formats_t * feedback = &ctx->wl.dmabuf.formats;
+    for (size_t i = 0; i < feedback->num_formats; i++) {
+        wlm_wayland_dmabuf_feedback_format_t * format = &feedback->formats[i];
+        if (format->drm_format != drm_format || format->modifier != modifier) continue;
+        return egl_accepts_modifier(ctx, drm_format, modifier);
+    }
+
+    return false;
+}
+
+static bool wlm_wayland_dmabuf_matches(ctx_t * ctx, ctx_wl_dmabuf_buffer_t * dmabuf_buffer, uint32_t drm_format, uint32_t width, uint32_t height, uint64_t * modifiers, size_t num_modifiers) {
+    dmabuf_t * raw_buffer = &dmabuf_buffer->raw_buffer;
+    if (raw_buffer->planes == 0) return false;
+    if (dmabuf_buffer->allocator != ctx->wl.dmabuf.allocator) return false;
+    if (dmabuf_buffer->device != ctx->wl.dmabuf.device) return false;
+    if (dmabuf_buffer->feedback_serial != ctx->wl.dmabuf.feedback_serial) return false;
+    if (raw_buffer->drm_format != drm_format) return false;
+    if (raw_buffer->width != width || raw_buffer->height != height) return false;
+
+    // without a list from the capture source, any modifier negotiated with the compositor works
+    if (modifiers == NULL) {
+        if (!dmabuf_buffer->explicit_modifier) return true;
+        return feedback_accepts_modifier(ctx, drm_format, raw_buffer->modifier);
+    }
+
+    if (!dmabuf_buffer->explicit_modifier) return false;
+    return contains_modifier(modifiers, num_modifiers, raw_buffer->modifier);
+}
+
+// allocate with the negotiated modifiers if possible, and the requested ones otherwise
+// - explicit_modifier is set if the buffer was allocated from a modifier list
+static bool allocate_buffer(ctx_t * ctx, dmabuf_t * raw_buffer, uint32_t drm_format, uint32_t width, uint32_t height, uint64_t * modifiers, size_t num_modifiers, bool * explicit_modifier) {
+    const wlm_wayland_dmabuf_allocator_t * allocator = ctx->wl.dmabuf.allocator;
+    wlm_wayland_dmabuf_feedback_formats_t * feedback = &ctx->wl.dmabuf.formats;
+
+    uint64_t * selected = NULL;
+    if (feedback->num_formats > 0) selected = calloc(feedback->num_formats, sizeof *selected);
+
+    bool success = false;
+    if (selected != NULL) {
+        // scanout tranches first, those buffers can skip composition on the compositor side
+        size_t num_scanout = select_modifiers(ctx, drm_format, modifiers, num_modifiers, true, selected);
+        if (num_scanout > 0) {
+            wlm_log_debug(ctx, "wayland::dmabuf::allocate_buffer(): trying %zd scanout modifiers\n", num_scanout);
+            success = allocator->alloc(ctx, raw_buffer, drm_format, width, height, selected, num_scanout);
+        }
+
+        size_t num_selected = success ? 0 : select_modifiers(ctx, drm_format, modifiers, num_modifiers, false, selected);
+        if (num_selected > num_scanout) {
+            wlm_log_debug(ctx, "wayland::dmabuf::allocate_buffer(): trying %zd negotiated modifiers\n", num_selected);
+            success = allocator->alloc(ctx, raw_buffer, drm_format, width, height, selected, num_selected);
+        }
+
+        free(selected);
+    }
+
+    *explicit_modifier = success;
+    if (!success) {
+        wlm_log_debug(ctx, "wayland::dmabuf::allocate_buffer(): trying requested modifiers\n");
+        success = allocator->alloc(ctx, raw_buffer, drm_format, width, height, modifiers, num_modifiers);
+        *explicit_modifier = modifiers != NULL;
+    }
+
+    return success;
+}
+
+static void wlm_wayland_dmabuf_destroy(ctx_t * ctx, ctx_wl_dmabuf_buffer_t * dmabuf_buffer) {
+    // NOTE: pending buffer params object destroys itself on success/failure
+    // - params of immediately created buffers are kept to receive failure events
+    if (dmabuf_buffer->buffer_params != NULL && dmabuf_buffer->buffer != NULL) zwp_linux_buffer_params_v1_destroy(dmabuf_buffer->buffer_params);
+    dmabuf_buffer->buffer_params = NULL;
+    dmabuf_buffer->alloc_callback = NULL;
+    dmabuf_buffer->failed_callback = NULL;
+
+    if (dmabuf_buffer->buffer != NULL) wl_buffer_destroy(dmabuf_buffer->buffer);
+    dmabuf_buffer->buffer = NULL;
+
+    dmabuf_t * raw_buffer = &dmabuf_buffer->raw_buffer;
+    if (raw_buffer->planes == 0) return;
+
+    // drop cached EGLImage before the fds go away
+    wlm_egl_dmabuf_invalidate(ctx, raw_buffer);
+
+    // close dmabuf file descriptors
+    for (unsigned int i = 0; i < raw_buffer->planes; i++) {
+        if (raw_buffer->fds[i] != -1) close(raw_buffer->fds[i]);
+        raw_buffer->fds[i] = -1;
+        raw_buffer->offsets[i] = 0;
+        raw_buffer->strides[i] = 0;
+    }
+
+    // reset dmabuf variables
+    raw_buffer->width = 0;
+    raw_buffer->height = 0;
+    raw_buffer->drm_format = 0;
+    raw_buffer->planes = 0;
+    raw_buffer->modifier = 0;
+    dmabuf_buffer->allocator = NULL;
+    dmabuf_buffer->device = 0;
+    dmabuf_buffer->explicit_modifier = false;
+}
+
 // --- linux_buffer_params event handlers ---
 
 static void on_linux_buffer_params_created(void * data, struct zwp_linux_buffer_params_v1 * buffer_params, struct wl_buffer * buffer) {
     ctx_t * ctx = (ctx_t *)data;
 
     zwp_linux_buffer_params_v1_destroy(buffer_params);
-    if (ctx->wl.dmabuf.buffer_params == buffer_params) {
-        ctx->wl.dmabuf.buffer_params = NULL;
-    } else {
+    ctx_wl_dmabuf_buffer_t * dmabuf_buffer = wlm_wayland_dmabuf_find_params(ctx, buffer_params);
+    if (dmabuf_buffer == NULL) {
         wlm_log_debug(ctx, "wayland::dmabuf::on_linux_buffer_params_created(): received stale DMA-BUF creation event\n");
         wl_buffer_destroy(buffer);
         return;
     }
 
-    bool success = true;
-    if (ctx->wl.dmabuf.buffer != NULL) {
-        wlm_log_error("wayland::dmabuf::on_linux_buffer_params_created(): buffer already exists\n");
-        wl_buffer_destroy(buffer);
-        success = false;
-    } else {
-        wlm_log_debug(ctx, "wayland::dmabuf::on_linux_buffer_params_created(): allocation succeeded\n");
-        ctx->wl.dmabuf.buffer = buffer;
-    }
+    wlm_log_debug(ctx, "wayland::dmabuf::on_linux_buffer_params_created(): allocation succeeded\n");
+    dmabuf_buffer->buffer_params = NULL;
+    dmabuf_buffer->buffer = buffer;
 
-    if (ctx->wl.dmabuf.alloc_callback != NULL) {
-        ctx->wl.dmabuf.alloc_callback(ctx, success);
-        ctx->wl.dmabuf.alloc_callback = NULL;
-    }
+    wlm_wayland_dmabuf_callback_t * cb = dmabuf_buffer->alloc_callback;
+    dmabuf_buffer->alloc_callback = NULL;
+    if (cb != NULL) cb(ctx, true);
 }
 
 static void on_linux_buffer_params_failed(void * data, struct zwp_linux_buffer_params_v1 * buffer_params) {
     ctx_t * ctx = (ctx_t *)data;
 
     zwp_linux_buffer_params_v1_destroy(buffer_params);
-    if (ctx->wl.dmabuf.buffer_params == buffer_params) {
-        ctx->wl.dmabuf.buffer_params = NULL;
-    } else {
+    ctx_wl_dmabuf_buffer_t * dmabuf_buffer = wlm_wayland_dmabuf_find_params(ctx, buffer_params);
+    if (dmabuf_buffer == NULL) {
         wlm_log_debug(ctx, "wayland::dmabuf::on_linux_buffer_params_failed(): received stale DMA-BUF failure event\n");
         return;
     }
 
-    if (ctx->wl.dmabuf.alloc_callback != NULL) {
-        wlm_log_error("wayland::dmabuf::on_linux_buffer_params_failed(): allocation failed\n");
-        ctx->wl.dmabuf.alloc_callback(ctx, false);
-        ctx->wl.dmabuf.alloc_callback = NULL;
-    }
+    wlm_log_error("wayland::dmabuf::on_linux_buffer_params_failed(): allocation failed\n");
+
+    // immediately created buffers may already be in use, tell their user instead
+    wlm_wayland_dmabuf_callback_t * cb = dmabuf_buffer->alloc_callback;
+    if (cb == NULL) cb = dmabuf_buffer->failed_callback;
+
+    // free the slot, the user has to forget its handle
+    bool in_use = dmabuf_buffer->in_use;
+    dmabuf_buffer->buffer_params = NULL;
+    wlm_wayland_dmabuf_destroy(ctx, dmabuf_buffer);
+    dmabuf_buffer->in_use = false;
+    if (in_use && cb != NULL) cb(ctx, false);
 }
 
 static const struct zwp_linux_buffer_params_v1_listener linux_buffer_params_listener = {
@@ -133,55 +363,21 @@ static const struct zwp_linux_buffer_params_v1_listener linux_buffer_params_list
     .failed = on_linux_buffer_params_failed,
 };
 
-// --- wlm_wayland_dmabuf_open_main_device ---
+// --- gbm allocator ---
 
-void wlm_wayland_dmabuf_open_main_device(ctx_t * ctx, wlm_wayland_dmabuf_callback_t * cb) {
 #ifdef WITH_GBM
-    if (ctx->wl.dmabuf.gbm_device != NULL) {
-        gbm_device_destroy(ctx->wl.dmabuf.gbm_device);
-        ctx->wl.dmabuf.gbm_device = NULL;
-    }
+static bool gbm_open(ctx_t * ctx, dev_t device) {
+    for (size_t i = 0; i < ctx->wl.dmabuf.num_devices; i++) {
+        if (ctx->wl.dmabuf.devices[i].device != device) continue;
 
-    if (ctx->wl.dmabuf.feedback != NULL) {
-        zwp_linux_dmabuf_feedback_v1_destroy(ctx->wl.dmabuf.feedback);
-        ctx->wl.dmabuf.feedback = NULL;
-    }
-
-    if (ctx->wl.linux_dmabuf == NULL) {
-        wlm_log_error("wayland::shm::create_pool(): missing linux_dmabuf protocol\n");
-        cb(ctx, false);
-    }
-
-    ctx->wl.dmabuf.open_device_callback = cb;
-    ctx->wl.dmabuf.feedback = zwp_linux_dmabuf_v1_get_default_feedback(ctx->wl.linux_dmabuf);
-    zwp_linux_dmabuf_feedback_v1_add_listener(ctx->wl.dmabuf.feedback, &linux_dmabuf_feedback_listener, (void *)ctx);
-#else
-    wlm_log_error("wayland::dmabuf::open_device(): need libGBM for dmabuf allocation\n");
-    cb(ctx, false);
-
-    (void)ctx;
-    (void)cb;
-    (void)linux_dmabuf_feedback_listener;
-#endif
-}
-
-// --- wlm_wayland_dmabuf_open_device ---
-
-bool wlm_wayland_dmabuf_open_device(ctx_t * ctx, dev_t device) {
-#ifdef WITH_GBM
-    if (ctx->wl.dmabuf.gbm_device != NULL) {
-        gbm_device_destroy(ctx->wl.dmabuf.gbm_device);
-        ctx->wl.dmabuf.gbm_device = NULL;
-    }
-
-    if (ctx->wl.dmabuf.feedback != NULL) {
-        zwp_linux_dmabuf_feedback_v1_destroy(ctx->wl.dmabuf.feedback);
-        ctx->wl.dmabuf.feedback = NULL;
+        wlm_log_debug(ctx, "wayland::dmabuf::gbm_open(): reusing gbm device\n");
+        ctx->wl.dmabuf.gbm_device = ctx->wl.dmabuf.devices[i].gbm_device;
+        return true;
     }
 
     drmDevice * drm_device = NULL;
     if (drmGetDeviceFromDevId(device, 0, &drm_device) != 0) {
-        wlm_log_error("wayland::dmabuf::open_device(): failed to open drm device\n");
+        wlm_log_error("wayland::dmabuf::gbm_open(): failed to open drm device\n");
         return false;
     }
 
@@ -191,56 +387,48 @@ bool wlm_wayland_dmabuf_open_device(ctx_t * ctx, dev_t device) {
     } else if (drm_device->available_nodes & (1 << DRM_NODE_PRIMARY)) {
         node = drm_device->nodes[DRM_NODE_PRIMARY];
     } else {
-        wlm_log_error("wayland::dmabuf::open_device(): failed to find drm node to open\n");
+        wlm_log_error("wayland::dmabuf::gbm_open(): failed to find drm node to open\n");
         drmFreeDevice(&drm_device);
         return false;
     }
 
     int fd = open(node, O_RDWR | O_CLOEXEC);
     if (fd == -1) {
-        wlm_log_error("wayland::dmabuf::open_device(): failed to open drm node\n");
+        wlm_log_error("wayland::dmabuf::gbm_open(): failed to open drm node\n");
         drmFreeDevice(&drm_device);
         return false;
     }
 
     drmFreeDevice(&drm_device);
 
-    wlm_log_debug(ctx, "wayland::dmabuf::open_device(): opening gbm device\n");
-    ctx->wl.dmabuf.gbm_device = gbm_create_device(fd);
-    if (ctx->wl.dmabuf.gbm_device == NULL) {
-        wlm_log_error("wayland::dmabuf::open_device(): failed to open gbm device\n");
+    wlm_log_debug(ctx, "wayland::dmabuf::gbm_open(): opening gbm device\n");
+    struct gbm_device * gbm_device = gbm_create_device(fd);
+    if (gbm_device == NULL) {
+        wlm_log_error("wayland::dmabuf::gbm_open(): failed to open gbm device\n");
+        close(fd);
         return false;
     }
 
-    return true;
-#else
-    wlm_log_error("wayland::dmabuf::open_device(): need libGBM for dmabuf allocation\n");
-
-    (void)ctx;
-    (void)device;
-    return false;
-#endif
-}
-
-// --- wlm_wayland_dmabuf_alloc ---
-
-void wlm_wayland_dmabuf_alloc(ctx_t * ctx, uint32_t drm_format, uint32_t width, uint32_t height, uint64_t * modifiers, size_t num_modifiers, wlm_wayland_dmabuf_callback_t * cb) {
-#ifdef WITH_GBM
-    if (ctx->wl.dmabuf.buffer != NULL) {
-        wlm_log_error("wayland::dmabuf::alloc(): already allocated\n");
-        cb(ctx, false);
-        return;
+    // evict the oldest device if the cache is full
+    // - pool buffers don't reference the gbm device after export
+    if (ctx->wl.dmabuf.num_devices == WLM_WAYLAND_DMABUF_DEVICE_CACHE_SIZE) {
+        wlm_wayland_dmabuf_device_t * oldest = &ctx->wl.dmabuf.devices[0];
+        gbm_device_destroy(oldest->gbm_device);
+        close(oldest->fd);
+        memmove(oldest, oldest + 1, (WLM_WAYLAND_DMABUF_DEVICE_CACHE_SIZE - 1) * sizeof *oldest);
+        ctx->wl.dmabuf.num_devices--;
     }
 
-    if (ctx->wl.dmabuf.gbm_device == NULL) {
-        wlm_log_error("wayland::dmabuf::alloc(): no gbm device\n");
-        cb(ctx, false);
-        return;
-    }
+    wlm_wayland_dmabuf_device_t * cached = &ctx->wl.dmabuf.devices[ctx->wl.dmabuf.num_devices++];
+    cached->device = device;
+    cached->fd = fd;
+    cached->gbm_device = gbm_device;
 
-    // NOTE: old buffer params object destroys itself on success/failure
-    ctx->wl.dmabuf.buffer_params = NULL;
+    ctx->wl.dmabuf.gbm_device = gbm_device;
+    return true;
+}
 
+static bool gbm_alloc(ctx_t * ctx, dmabuf_t * raw_buffer, uint32_t drm_format, uint32_t width, uint32_t height, uint64_t * modifiers, size_t num_modifiers) {
     struct gbm_bo * dmabuf_bo = NULL;
     if (modifiers == NULL) {
         dmabuf_bo = gbm_bo_create(ctx->wl.dmabuf.gbm_device, width, height, drm_format, GBM_BO_USE_RENDERING);
@@ -249,134 +437,378 @@ void wlm_wayland_dmabuf_alloc(ctx_t * ctx, uint32_t drm_format, uint32_t width,
     }
 
     if (dmabuf_bo == NULL) {
-        wlm_log_error("wayland::dmabuf::alloc(): failed to create gbm bo\n");
-        cb(ctx, false);
-        return;
+        wlm_log_debug(ctx, "wayland::dmabuf::gbm_alloc(): failed to create gbm bo\n");
+        return false;
     }
 
     // export gbm bo to raw dmabuf
     size_t num_planes = gbm_bo_get_plane_count(dmabuf_bo);
-    uint64_t modifier = gbm_bo_get_modifier(dmabuf_bo);
-
-    // allocate dmabuf plane arrays
-    int * fds = calloc(num_planes, sizeof (int));
-    uint32_t * offsets = calloc(num_planes, sizeof (uint32_t));
-    uint32_t * strides = calloc(num_planes, sizeof (uint32_t));
-    if (fds == NULL || offsets == NULL || strides == NULL) {
-        wlm_log_error("wayland::dmabuf::alloc(): failed to allocate dmabuf plane arrays\n");
+    if (num_planes > MAX_PLANES) {
+        wlm_log_error("wayland::dmabuf::gbm_alloc(): too many planes, got %zd, can support at most %d\n", num_planes, MAX_PLANES);
         gbm_bo_destroy(dmabuf_bo);
-        free(fds);
-        free(offsets);
-        free(strides);
-        cb(ctx, false);
+        return false;
     }
 
-    // fill dmabuf plane arrays
-    ctx->wl.dmabuf.raw_buffer.width = width;
-    ctx->wl.dmabuf.raw_buffer.height = height;
-    ctx->wl.dmabuf.raw_buffer.drm_format = drm_format;
-    ctx->wl.dmabuf.raw_buffer.planes = num_planes;
-    ctx->wl.dmabuf.raw_buffer.fds = fds;
-    ctx->wl.dmabuf.raw_buffer.offsets = offsets;
-    ctx->wl.dmabuf.raw_buffer.strides = strides;
-    ctx->wl.dmabuf.raw_buffer.modifier = modifier;
-    wlm_log_debug(ctx, "wayland::dmabuf::alloc(): allocated dmabuf with format=%x, size=%dx%d, modifier=%zx, planes=%zd\n", drm_format, width, height, modifier, num_planes);
+    raw_buffer->planes = num_planes;
+    raw_buffer->modifier = gbm_bo_get_modifier(dmabuf_bo);
     for (size_t i = 0; i < num_planes; i++) {
-        fds[i] = gbm_bo_get_fd_for_plane(dmabuf_bo, i);
-        offsets[i] = gbm_bo_get_offset(dmabuf_bo, i);
-        strides[i] = gbm_bo_get_stride_for_plane(dmabuf_bo, i);
-        wlm_log_debug(ctx, "wayland::dmabuf::alloc(): plane[%zd]: fd=%d, offset=%x, stride=%x\n", i, fds[i], offsets[i], strides[i]);
+        raw_buffer->fds[i] = gbm_bo_get_fd_for_plane(dmabuf_bo, i);
+        raw_buffer->offsets[i] = gbm_bo_get_offset(dmabuf_bo, i);
+        raw_buffer->strides[i] = gbm_bo_get_stride_for_plane(dmabuf_bo, i);
     }
     gbm_bo_destroy(dmabuf_bo);
 
-    // create dmabuf wl_buffer
-    ctx->wl.dmabuf.alloc_callback = cb;
-    ctx->wl.dmabuf.buffer_params = zwp_linux_dmabuf_v1_create_params(ctx->wl.linux_dmabuf);
-    zwp_linux_buffer_params_v1_add_listener(ctx->wl.dmabuf.buffer_params, &linux_buffer_params_listener, (void *)ctx);
+    return true;
+}
 
-    for (size_t i = 0; i < num_planes; i++) {
-        zwp_linux_buffer_params_v1_add(ctx->wl.dmabuf.buffer_params, fds[i], i, offsets[i], strides[i], modifier >> 32, modifier);
+static const wlm_wayland_dmabuf_allocator_t gbm_allocator = {
+    .name = "gbm",
+    .alloc = gbm_alloc,
+};
+#endif
+
+// --- dma-heap allocator ---
+
+// row alignment accepted for linear buffers by most GPU drivers
+#define DMA_HEAP_STRIDE_ALIGN 256
+
+static bool dma_heap_open(ctx_t * ctx) {
+#if __linux__
+    if (ctx->wl.dmabuf.dma_heap_fd != -1) return true;
+
+    wlm_log_debug(ctx, "wayland::dmabuf::dma_heap_open(): opening system dma-heap\n");
+    ctx->wl.dmabuf.dma_heap_fd = open("/dev/dma_heap/system", O_RDONLY | O_CLOEXEC);
+    if (ctx->wl.dmabuf.dma_heap_fd == -1) {
+        wlm_log_error("wayland::dmabuf::dma_heap_open(): failed to open /dev/dma_heap/system\n");
+        return false;
     }
 
-    zwp_linux_buffer_params_v1_create(ctx->wl.dmabuf.buffer_params, width, height, drm_format, 0);
+    return true;
 #else
-    wlm_log_error("wayland::dmabuf::open_device(): need libGBM for dmabuf allocation\n");
-    cb(ctx, false);
+    wlm_log_error("wayland::dmabuf::dma_heap_open(): dma-heaps are only available on linux\n");
 
     (void)ctx;
+    return false;
+#endif
+}
+
+static bool dma_heap_alloc(ctx_t * ctx, dmabuf_t * raw_buffer, uint32_t drm_format, uint32_t width, uint32_t height, uint64_t * modifiers, size_t num_modifiers) {
+#if __linux__
+    // DRM_FORMAT_MOD_LINEAR
+    const uint64_t linear_modifier = 0;
+
+    bool accepts_linear = modifiers == NULL;
+    for (size_t i = 0; i < num_modifiers; i++) {
+        if (modifiers[i] == linear_modifier) accepts_linear = true;
+    }
+
+    if (!accepts_linear) {
+        wlm_log_debug(ctx, "wayland::dmabuf::dma_heap_alloc(): linear modifier not accepted for format %x\n", drm_format);
+        return false;
+    }
+
+    // dma-heap buffers are untyped memory, only single-plane formats can be laid out here
+    const wlm_egl_format_t * format = wlm_egl_formats_find_drm(drm_format);
+    if (format == NULL) {
+        wlm_log_error("wayland::dmabuf::dma_heap_alloc(): unsupported format %x\n", drm_format);
+        return false;
+    }
+
+    uint32_t stride = width * (format->bpp / 8);
+    stride = (stride + DMA_HEAP_STRIDE_ALIGN - 1) / DMA_HEAP_STRIDE_ALIGN * DMA_HEAP_STRIDE_ALIGN;
+
+    struct dma_heap_allocation_data allocation = {
+        .len = (uint64_t)stride * height,
+        .fd = 0,
+        .fd_flags = O_RDWR | O_CLOEXEC,
+        .heap_flags = 0,
+    };
+
+    if (ioctl(ctx->wl.dmabuf.dma_heap_fd, DMA_HEAP_IOCTL_ALLOC, &allocation) == -1) {
+        wlm_log_error("wayland::dmabuf::dma_heap_alloc(): failed to allocate %llu bytes\n", (unsigned long long)allocation.len);
+        return false;
+    }
+
+    raw_buffer->planes = 1;
+    raw_buffer->modifier = linear_modifier;
+    raw_buffer->fds[0] = allocation.fd;
+    raw_buffer->offsets[0] = 0;
+    raw_buffer->strides[0] = stride;
+
+    return true;
+#else
+    (void)ctx;
+    (void)raw_buffer;
     (void)drm_format;
     (void)width;
     (void)height;
     (void)modifiers;
     (void)num_modifiers;
-    (void)linux_buffer_params_listener;
+    return false;
 #endif
 }
 
-// --- wlm_wayland_dmabuf_dealloc ---
+static const wlm_wayland_dmabuf_allocator_t dma_heap_allocator = {
+    .name = "dma-heap",
+    .alloc = dma_heap_alloc,
+};
 
-void wlm_wayland_dmabuf_dealloc(ctx_t * ctx) {
-    // NOTE: old buffer params object destroys itself on success/failure
-    ctx->wl.dmabuf.buffer_params = NULL;
+static void unselect_device(ctx_t * ctx) {
+    // devices stay open in the cache
+    ctx->wl.dmabuf.allocator = NULL;
+    ctx->wl.dmabuf.device = 0;
+#ifdef WITH_GBM
+    ctx->wl.dmabuf.gbm_device = NULL;
+#endif
+}
 
-    if (ctx->wl.dmabuf.buffer != NULL) wl_buffer_destroy(ctx->wl.dmabuf.buffer);
-    ctx->wl.dmabuf.buffer = NULL;
+static void request_feedback(ctx_t * ctx) {
+    if (ctx->wl.dmabuf.feedback != NULL || ctx->wl.linux_dmabuf == NULL) return;
 
-    if (ctx->wl.dmabuf.raw_buffer.planes == 0) return;
+    // keep listening, the compositor sends updated feedback when its preferences change
+    ctx->wl.dmabuf.feedback = zwp_linux_dmabuf_v1_get_default_feedback(ctx->wl.linux_dmabuf);
+    zwp_linux_dmabuf_feedback_v1_add_listener(ctx->wl.dmabuf.feedback, &linux_dmabuf_feedback_listener, (void *)ctx);
+}
 
-    // close dmabuf file descriptors
-    for (unsigned int i = 0; i < ctx->wl.dmabuf.raw_buffer.planes; i++) {
-        if (ctx->wl.dmabuf.raw_buffer.fds[i] != -1) close(ctx->wl.dmabuf.raw_buffer.fds[i]);
+// --- wlm_wayland_dmabuf_open_main_device ---
+
+void wlm_wayland_dmabuf_open_main_device(ctx_t * ctx, wlm_wayland_dmabuf_callback_t * cb) {
+    unselect_device(ctx);
+
+    if (ctx->wl.linux_dmabuf == NULL) {
+        wlm_log_error("wayland::dmabuf::open_main_device(): missing linux_dmabuf protocol\n");
+        cb(ctx, false);
+        return;
     }
-    // free dmabuf arrays
-    free(ctx->wl.dmabuf.raw_buffer.fds);
-    free(ctx->wl.dmabuf.raw_buffer.offsets);
-    free(ctx->wl.dmabuf.raw_buffer.strides);
 
-    // reset dmabuf variables
-    ctx->wl.dmabuf.raw_buffer.width = 0;
-    ctx->wl.dmabuf.raw_buffer.height = 0;
-    ctx->wl.dmabuf.raw_buffer.drm_format = 0;
-    ctx->wl.dmabuf.raw_buffer.planes = 0;
-    ctx->wl.dmabuf.raw_buffer.fds = NULL;
-    ctx->wl.dmabuf.raw_buffer.offsets = NULL;
-    ctx->wl.dmabuf.raw_buffer.strides = NULL;
-    ctx->wl.dmabuf.raw_buffer.modifier = 0;
+    if (ctx->wl.dmabuf.feedback_serial > 0) {
+        cb(ctx, wlm_wayland_dmabuf_open_device(ctx, ctx->wl.dmabuf.main_device));
+        return;
+    }
+
+    // opened once the feedback is done
+    ctx->wl.dmabuf.open_device_callback = cb;
+    request_feedback(ctx);
+}
+
+// --- wlm_wayland_dmabuf_open_device ---
+
+bool wlm_wayland_dmabuf_open_device(ctx_t * ctx, dev_t device) {
+    unselect_device(ctx);
+    request_feedback(ctx);
+
+    dmabuf_allocator_t allocator = ctx->opt.dmabuf_allocator;
+    if (allocator == DMABUF_ALLOCATOR_AUTO || allocator == DMABUF_ALLOCATOR_GBM) {
+#ifdef WITH_GBM
+        if (gbm_open(ctx, device)) {
+            ctx->wl.dmabuf.allocator = &gbm_allocator;
+            ctx->wl.dmabuf.device = device;
+            return true;
+        }
+#else
+        if (allocator == DMABUF_ALLOCATOR_GBM) {
+            wlm_log_error("wayland::dmabuf::open_device(): need libGBM for gbm allocator\n");
+        }
+#endif
+
+        if (allocator == DMABUF_ALLOCATOR_GBM) return false;
+        wlm_log_debug(ctx, "wayland::dmabuf::open_device(): falling back to dma-heap allocator\n");
+    }
+
+    if (!dma_heap_open(ctx)) return false;
+    ctx->wl.dmabuf.allocator = &dma_heap_allocator;
+    ctx->wl.dmabuf.device = device;
+    return true;
+}
+
+// --- wlm_wayland_dmabuf_acquire ---
+
+bool wlm_wayland_dmabuf_acquire(ctx_t * ctx, uint32_t drm_format, uint32_t width, uint32_t height, uint64_t * modifiers, size_t num_modifiers, wlm_wayland_dmabuf_callback_t * cb, wlm_wayland_dmabuf_handle_t * handle) {
+    // reuse idle buffer with matching parameters
+    for (size_t i = 0; i < WLM_WAYLAND_DMABUF_POOL_SIZE; i++) {
+        ctx_wl_dmabuf_buffer_t * dmabuf_buffer = &ctx->wl.dmabuf.buffers[i];
+        if (dmabuf_buffer->in_use) continue;
+        if (!wlm_wayland_dmabuf_matches(ctx, dmabuf_buffer, drm_format, width, height, modifiers, num_modifiers)) continue;
+
+        dmabuf_buffer->in_use = true;
+        dmabuf_buffer->failed_callback = cb;
+        *handle = i;
+        if (dmabuf_buffer->buffer == NULL) {
+            // wl_buffer still being created
+            dmabuf_buffer->alloc_callback = cb;
+        } else {
+            cb(ctx, true);
+        }
+        return true;
+    }
+
+    const wlm_wayland_dmabuf_allocator_t * allocator = ctx->wl.dmabuf.allocator;
+    if (allocator == NULL) {
+        wlm_log_error("wayland::dmabuf::acquire(): no dmabuf allocator\n");
+        return false;
+    }
+
+    // find free slot, or evict least recently used idle buffer
+    ctx_wl_dmabuf_buffer_t * dmabuf_buffer = NULL;
+    size_t index = 0;
+    for (size_t i = 0; i < WLM_WAYLAND_DMABUF_POOL_SIZE; i++) {
+        ctx_wl_dmabuf_buffer_t * candidate = &ctx->wl.dmabuf.buffers[i];
+        if (candidate->in_use) continue;
+
+        bool is_free = candidate->raw_buffer.planes == 0;
+        if (is_free || dmabuf_buffer == NULL || candidate->last_used < dmabuf_buffer->last_used) {
+            dmabuf_buffer = candidate;
+            index = i;
+        }
+        if (is_free) break;
+    }
+
+    if (dmabuf_buffer == NULL) {
+        wlm_log_error("wayland::dmabuf::acquire(): all %d pool buffers in use\n", WLM_WAYLAND_DMABUF_POOL_SIZE);
+        return false;
+    }
+
+    if (dmabuf_buffer->raw_buffer.planes != 0) {
+        wlm_log_debug(ctx, "wayland::dmabuf::acquire(): evicting pool buffer %zd\n", index);
+        wlm_wayland_dmabuf_destroy(ctx, dmabuf_buffer);
+    }
+
+    // fill dmabuf plane arrays
+    dmabuf_t * raw_buffer = &dmabuf_buffer->raw_buffer;
+    bool explicit_modifier = false;
+    if (!allocate_buffer(ctx, raw_buffer, drm_format, width, height, modifiers, num_modifiers, &explicit_modifier)) {
+        wlm_log_error("wayland::dmabuf::acquire(): failed to allocate buffer with %s allocator\n", allocator->name);
+        return false;
+    }
+
+    int * fds = raw_buffer->fds;
+    uint32_t * offsets = raw_buffer->offsets;
+    uint32_t * strides = raw_buffer->strides;
+    size_t num_planes = raw_buffer->planes;
+    uint64_t modifier = raw_buffer->modifier;
+    raw_buffer->width = width;
+    raw_buffer->height = height;
+    raw_buffer->drm_format = drm_format;
+    dmabuf_buffer->allocator = allocator;
+    dmabuf_buffer->device = ctx->wl.dmabuf.device;
+    dmabuf_buffer->explicit_modifier = explicit_modifier;
+    dmabuf_buffer->feedback_serial = ctx->wl.dmabuf.feedback_serial;
+    wlm_log_debug(ctx, "wayland::dmabuf::acquire(): allocated pool buffer %zd with allocator=%s, format=%x, size=%dx%d, modifier=%zx, planes=%zd\n", index, allocator->name, drm_format, width, height, modifier, num_planes);
+    for (size_t i = 0; i < num_planes; i++) {
+        wlm_log_debug(ctx, "wayland::dmabuf::acquire(): plane[%zd]: fd=%d, offset=%x, stride=%x\n", i, fds[i], offsets[i], strides[i]);
+    }
+
+    // create dmabuf wl_buffer
+    dmabuf_buffer->in_use = true;
+    dmabuf_buffer->alloc_callback = cb;
+    dmabuf_buffer->buffer_params = zwp_linux_dmabuf_v1_create_params(ctx->wl.linux_dmabuf);
+    zwp_linux_buffer_params_v1_add_listener(dmabuf_buffer->buffer_params, &linux_buffer_params_listener, (void *)ctx);
+
+    for (size_t i = 0; i < num_planes; i++) {
+        zwp_linux_buffer_params_v1_add(dmabuf_buffer->buffer_params, fds[i], i, offsets[i], strides[i], modifier >> 32, modifier);
+    }
+
+    *handle = index;
+    if (zwp_linux_dmabuf_v1_get_version(ctx->wl.linux_dmabuf) >= ZWP_LINUX_BUFFER_PARAMS_V1_CREATE_IMMED_SINCE_VERSION) {
+        // usable right away, saves a roundtrip before the first capture into it
+        // - import failures still arrive as failed events on the params object
+        dmabuf_buffer->alloc_callback = NULL;
+        dmabuf_buffer->failed_callback = cb;
+        dmabuf_buffer->buffer = zwp_linux_buffer_params_v1_create_immed(dmabuf_buffer->buffer_params, width, height, drm_format, 0);
+        cb(ctx, true);
+    } else {
+        zwp_linux_buffer_params_v1_create(dmabuf_buffer->buffer_params, width, height, drm_format, 0);
+    }
+
+    return true;
+}
+
+// --- wlm_wayland_dmabuf_release ---
+
+void wlm_wayland_dmabuf_release(ctx_t * ctx, wlm_wayland_dmabuf_handle_t handle) {
+    if (handle >= WLM_WAYLAND_DMABUF_POOL_SIZE) return;
+
+    ctx_wl_dmabuf_buffer_t * dmabuf_buffer = &ctx->wl.dmabuf.buffers[handle];
+    dmabuf_buffer->in_use = false;
+    dmabuf_buffer->alloc_callback = NULL;
+    dmabuf_buffer->failed_callback = NULL;
+    dmabuf_buffer->last_used = ++ctx->wl.dmabuf.use_counter;
+}
+
+// --- wlm_wayland_dmabuf_clear_pool ---
+
+void wlm_wayland_dmabuf_clear_pool(ctx_t * ctx) {
+    for (size_t i = 0; i < WLM_WAYLAND_DMABUF_POOL_SIZE; i++) {
+        wlm_wayland_dmabuf_destroy(ctx, &ctx->wl.dmabuf.buffers[i]);
+    }
 }
 
 // --- wlm_wayland_dmabuf_get_buffer ---
 
-struct wl_buffer * wlm_wayland_dmabuf_get_buffer(ctx_t * ctx) {
-    return ctx->wl.dmabuf.buffer;
+struct wl_buffer * wlm_wayland_dmabuf_get_buffer(ctx_t * ctx, wlm_wayland_dmabuf_handle_t handle) {
+    if (handle >= WLM_WAYLAND_DMABUF_POOL_SIZE) return NULL;
+    return ctx->wl.dmabuf.buffers[handle].buffer;
 }
 
 // --- wlm_wayland_dmabuf_get_raw_buffer ---
 
-dmabuf_t * wlm_wayland_dmabuf_get_raw_buffer(ctx_t * ctx) {
-    if (ctx->wl.dmabuf.buffer == NULL) return NULL;
-    return &ctx->wl.dmabuf.raw_buffer;
+dmabuf_t * wlm_wayland_dmabuf_get_raw_buffer(ctx_t * ctx, wlm_wayland_dmabuf_handle_t handle) {
+    if (handle >= WLM_WAYLAND_DMABUF_POOL_SIZE) return NULL;
+    if (ctx->wl.dmabuf.buffers[handle].buffer == NULL) return NULL;
+    return &ctx->wl.dmabuf.buffers[handle].raw_buffer;
 }
 
 // --- wlm_wayland_dmabuf_init ---
 
 void wlm_wayland_dmabuf_init(ctx_t * ctx) {
+    ctx->wl.dmabuf.allocator = NULL;
+    ctx->wl.dmabuf.device = 0;
 #ifdef WITH_GBM
     ctx->wl.dmabuf.gbm_device = NULL;
+    ctx->wl.dmabuf.num_devices = 0;
 #endif
+    ctx->wl.dmabuf.dma_heap_fd = -1;
 
     ctx->wl.dmabuf.open_device_callback = NULL;
-    ctx->wl.dmabuf.alloc_callback = NULL;
     ctx->wl.dmabuf.feedback = NULL;
-    ctx->wl.dmabuf.buffer_params = NULL;
-    ctx->wl.dmabuf.buffer = NULL;
-    ctx->wl.dmabuf.raw_buffer.width = 0;
-    ctx->wl.dmabuf.raw_buffer.height = 0;
-    ctx->wl.dmabuf.raw_buffer.drm_format = 0;
-    ctx->wl.dmabuf.raw_buffer.planes = 0;
-    ctx->wl.dmabuf.raw_buffer.fds = NULL;
-    ctx->wl.dmabuf.raw_buffer.offsets = NULL;
-    ctx->wl.dmabuf.raw_buffer.strides = NULL;
-    ctx->wl.dmabuf.raw_buffer.modifier = 0;
+
+    ctx->wl.dmabuf.format_table = NULL;
+    ctx->wl.dmabuf.format_table_size = 0;
+    ctx->wl.dmabuf.main_device = 0;
+    ctx->wl.dmabuf.pending_scanout = false;
+    ctx->wl.dmabuf.pending_formats.formats = NULL;
+    ctx->wl.dmabuf.pending_formats.num_formats = 0;
+    ctx->wl.dmabuf.pending_formats.capacity = 0;
+    ctx->wl.dmabuf.formats.formats = NULL;
+    ctx->wl.dmabuf.formats.num_formats = 0;
+    ctx->wl.dmabuf.formats.capacity = 0;
+    ctx->wl.dmabuf.feedback_serial = 0;
+
+    for (size_t i = 0; i < WLM_WAYLAND_DMABUF_POOL_SIZE; i++) {
+        ctx_wl_dmabuf_buffer_t * dmabuf_buffer = &ctx->wl.dmabuf.buffers[i];
+        dmabuf_buffer->buffer_params = NULL;
+        dmabuf_buffer->buffer = NULL;
+        dmabuf_buffer->raw_buffer.width = 0;
+        dmabuf_buffer->raw_buffer.height = 0;
+        dmabuf_buffer->raw_buffer.drm_format = 0;
+        dmabuf_buffer->raw_buffer.planes = 0;
+        for (size_t j = 0; j < MAX_PLANES; j++) {
+            dmabuf_buffer->raw_buffer.fds[j] = -1;
+            dmabuf_buffer->raw_buffer.offsets[j] = 0;
+            dmabuf_buffer->raw_buffer.strides[j] = 0;
+        }
+        dmabuf_buffer->raw_buffer.modifier = 0;
+        dmabuf_buffer->alloc_callback = NULL;
+        dmabuf_buffer->failed_callback = NULL;
+        dmabuf_buffer->allocator = NULL;
+        dmabuf_buffer->device = 0;
+        dmabuf_buffer->explicit_modifier = false;
+        dmabuf_buffer->feedback_serial = 0;
+        dmabuf_buffer->in_use = false;
+        dmabuf_buffer->last_used = 0;
+    }
+    ctx->wl.dmabuf.use_counter = 0;
+
     ctx->wl.dmabuf.initialized = true;
 }
 
@@ -385,11 +817,22 @@ void wlm_wayland_dmabuf_init(ctx_t * ctx) {
 void wlm_wayland_dmabuf_cleanup(ctx_t * ctx) {
     if (!ctx->wl.dmabuf.initialized) return;
 
-    wlm_wayland_dmabuf_dealloc(ctx);
+    wlm_wayland_dmabuf_clear_pool(ctx);
+    unselect_device(ctx);
 
 #ifdef WITH_GBM
-    if (ctx->wl.dmabuf.gbm_device != NULL) gbm_device_destroy(ctx->wl.dmabuf.gbm_device);
+    for (size_t i = 0; i < ctx->wl.dmabuf.num_devices; i++) {
+        gbm_device_destroy(ctx->wl.dmabuf.devices[i].gbm_device);
+        close(ctx->wl.dmabuf.devices[i].fd);
+    }
+    ctx->wl.dmabuf.num_devices = 0;
 #endif
 
+    if (ctx->wl.dmabuf.dma_heap_fd != -1) close(ctx->wl.dmabuf.dma_heap_fd);
+    ctx->wl.dmabuf.dma_heap_fd = -1;
+
     if (ctx->wl.dmabuf.feedback != NULL) zwp_linux_dmabuf_feedback_v1_destroy(ctx->wl.dmabuf.feedback);
+    if (ctx->wl.dmabuf.format_table != NULL) munmap(ctx->wl.dmabuf.format_table, ctx->wl.dmabuf.format_table_size);
+    free(ctx->wl.dmabuf.pending_formats.formats);
+    free(ctx->wl.dmabuf.formats.formats);
 }
@@ -1,7 +1,81 @@
 #define _GNU_SOURCE
 #include <wlm/context.h>
+#include <wlm/egl/dmabuf.h>
+#include <wlm/egl/formats.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <unistd.h>
+#if __linux__
+#include <linux/udmabuf.h>
+#endif
+
+// --- udmabuf ---
+
+static void udmabuf_open(ctx_t * ctx) {
+#if __linux__
+    if (ctx->wl.shmbuf.udmabuf_fd != -1 || ctx->wl.shmbuf.udmabuf_disabled) return;
+
+    ctx->wl.shmbuf.udmabuf_fd = open("/dev/udmabuf", O_RDWR | O_CLOEXEC);
+    if (ctx->wl.shmbuf.udmabuf_fd == -1) {
+        wlm_log_debug(ctx, "wayland::shm::udmabuf_open(): udmabuf unavailable, shm buffers are copied\n");
+        ctx->wl.shmbuf.udmabuf_disabled = true;
+    }
+#else
+    ctx->wl.shmbuf.udmabuf_disabled = true;
+#endif
+}
+
+static void udmabuf_create(ctx_t * ctx, ctx_wl_shm_buffer_t * shm_buffer, size_t size, uint32_t drm_format, uint32_t width, uint32_t height, uint32_t stride) {
+#if __linux__
+    if (ctx->wl.shmbuf.udmabuf_fd == -1) return;
+
+    struct udmabuf_create create = {
+        .memfd = ctx->wl.shmbuf.fd,
+        .flags = UDMABUF_FLAGS_CLOEXEC,
+        .offset = shm_buffer->offset,
+        .size = size,
+    };
+
+    int fd = ioctl(ctx->wl.shmbuf.udmabuf_fd, UDMABUF_CREATE, &create);
+    if (fd == -1) {
+        wlm_log_debug(ctx, "wayland::shm::udmabuf_create(): failed to create udmabuf, shm buffers are copied\n");
+        wlm_wayland_shm_disable_dmabuf(ctx);
+        return;
+    }
+
+    dmabuf_t * dmabuf = &shm_buffer->dmabuf;
+    dmabuf->width = width;
+    dmabuf->height = height;
+    dmabuf->drm_format = drm_format;
+    dmabuf->planes = 1;
+    dmabuf->fds[0] = fd;
+    dmabuf->offsets[0] = 0;
+    dmabuf->strides[0] = stride;
+    // DRM_FORMAT_MOD_LINEAR
+    dmabuf->modifier = 0;
+#else
+    (void)ctx;
+    (void)shm_buffer;
+    (void)size;
+    (void)drm_format;
+    (void)width;
+    (void)height;
+    (void)stride;
+#endif
+}
+
+static void udmabuf_destroy(ctx_t * ctx, ctx_wl_shm_buffer_t * shm_buffer) {
+    dmabuf_t * dmabuf = &shm_buffer->dmabuf;
+    if (dmabuf->planes == 0) return;
+
+    // drop cached EGLImage before the fd goes away
+    wlm_egl_dmabuf_invalidate(ctx, dmabuf);
+
+    close(dmabuf->fds[0]);
+    dmabuf->fds[0] = -1;
+    dmabuf->planes = 0;
+}
 
 // --- helper functions ---
 
@@ -46,11 +120,18 @@ bool wlm_wayland_shm_create_pool(ctx_t * ctx) {
     }
 
     // create shm fd
-    ctx->wl.shmbuf.fd = memfd_create("wl_shm_buffer", 0);
+    // - udmabuf needs a memfd that is sealed against shrinking
+    ctx->wl.shmbuf.fd = memfd_create("wl_shm_buffer", MFD_CLOEXEC | MFD_ALLOW_SEALING);
     if (ctx->wl.shmbuf.fd == -1) {
         wlm_log_error("wayland::shm::create_pool(): failed to create shm buffer\n");
         return false;
-}
+    }
+
+    if (fcntl(ctx->wl.shmbuf.fd, F_ADD_SEALS, F_SEAL_SHRINK) == -1) {
+        wlm_wayland_shm_disable_dmabuf(ctx);
+    } else {
+        udmabuf_open(ctx);
+    }
 
     // resize shm to nonempty size
     size_t new_size = 1;
@@ -83,47 +164,110 @@ bool wlm_wayland_shm_create_pool(ctx_t * ctx) {
 bool wlm_wayland_shm_alloc(ctx_t * ctx, uint32_t shm_format, uint32_t width, uint32_t height, uint32_t stride) {
     if (ctx->wl.shmbuf.pool == NULL && !wlm_wayland_shm_create_pool(ctx)) return false;
 
-    if (ctx->wl.shmbuf.buffer != NULL) {
-        // TODO: Allow managing multiple shared memory buffers
-        wlm_log_debug(ctx, "wayland::shm::alloc(): FIXME: allow multiple buffers to be allocated\n");
-        wlm_log_error("wayland::shm::alloc(): buffer already exists\n");
+    if (ctx->wl.shmbuf.num_buffers != 0) {
+        wlm_log_error("wayland::shm::alloc(): buffers already exist\n");
         return false;
     }
 
     // check if shmbuf needs to be resized
-    size_t new_size = stride * height;
+    // - udmabufs must start and end on page boundaries
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t buffer_size = (size_t)stride * height;
+    buffer_size = (buffer_size + page_size - 1) / page_size * page_size;
+    size_t new_size = buffer_size * WLM_WAYLAND_SHM_NUM_BUFFERS;
     if (new_size > ctx->wl.shmbuf.size && !wlm_wayland_shm_resize(ctx, new_size)) {
         wlm_log_error("wayland::shm::alloc(): failed to allocate shm buffer\n");
         return false;
     }
 
-    ctx->wl.shmbuf.buffer = wl_shm_pool_create_buffer(
-        ctx->wl.shmbuf.pool, 0, width, height, stride, shm_format
-    );
+    // carve ring buffers from shm pool
+    for (size_t i = 0; i < WLM_WAYLAND_SHM_NUM_BUFFERS; i++) {
+        ctx_wl_shm_buffer_t * shm_buffer = &ctx->wl.shmbuf.buffers[i];
+        shm_buffer->offset = i * buffer_size;
+        shm_buffer->buffer = wl_shm_pool_create_buffer(
+            ctx->wl.shmbuf.pool, shm_buffer->offset, width, height, stride, shm_format
+        );
+        if (shm_buffer->buffer == NULL) {
+            wlm_log_error("wayland::shm::alloc(): failed to create wl_buffer\n");
+            wlm_wayland_shm_dealloc(ctx);
+            return false;
+        }
+
+        // udmabufs need the drm fourcc, which differs from wl_shm for two formats
+        const wlm_egl_format_t * format = wlm_egl_formats_find_shm(shm_format);
+        if (format != NULL) udmabuf_create(ctx, shm_buffer, buffer_size, format->drm_format, width, height, stride);
+        ctx->wl.shmbuf.num_buffers++;
+    }
 
+    ctx->wl.shmbuf.next_buffer = 0;
     return true;
 }
 
 // --- wlm_wayland_shm_dealloc ---
 
 void wlm_wayland_shm_dealloc(ctx_t * ctx) {
-    if (ctx->wl.shmbuf.buffer == NULL) return;
+    for (size_t i = 0; i < ctx->wl.shmbuf.num_buffers; i++) {
+        ctx_wl_shm_buffer_t * shm_buffer = &ctx->wl.shmbuf.buffers[i];
+        wl_buffer_destroy(shm_buffer->buffer);
+        shm_buffer->buffer = NULL;
+        shm_buffer->offset = 0;
+        udmabuf_destroy(ctx, shm_buffer);
+    }
+
+    ctx->wl.shmbuf.num_buffers = 0;
+    ctx->wl.shmbuf.next_buffer = 0;
+}
+
+// --- wlm_wayland_shm_is_allocated ---
+
+bool wlm_wayland_shm_is_allocated(ctx_t * ctx) {
+    return ctx->wl.shmbuf.num_buffers != 0;
+}
 
-    // TODO: Allow identifying the buffer to be deallocated
-    wl_buffer_destroy(ctx->wl.shmbuf.buffer);
-    ctx->wl.shmbuf.buffer = NULL;
+// --- wlm_wayland_shm_next_buffer ---
+
+wlm_wayland_shm_handle_t wlm_wayland_shm_next_buffer(ctx_t * ctx, wlm_wayland_shm_handle_t shown) {
+    wlm_wayland_shm_handle_t handle = ctx->wl.shmbuf.next_buffer;
+
+    // the shown buffer may still be sampled by redraws, don't copy into it
+    if (handle == shown) handle = (handle + 1) % WLM_WAYLAND_SHM_NUM_BUFFERS;
+
+    ctx->wl.shmbuf.next_buffer = (handle + 1) % WLM_WAYLAND_SHM_NUM_BUFFERS;
+    return handle;
 }
 
 // --- wlm_wayland_shm_get_buffer ---
 
-struct wl_buffer * wlm_wayland_shm_get_buffer(ctx_t * ctx) {
-    return ctx->wl.shmbuf.buffer;
+struct wl_buffer * wlm_wayland_shm_get_buffer(ctx_t * ctx, wlm_wayland_shm_handle_t handle) {
+    if (handle >= ctx->wl.shmbuf.num_buffers) return NULL;
+    return ctx->wl.shmbuf.buffers[handle].buffer;
 }
 
 // --- wlm_wayland_shm_get_addr ---
 
-void * wlm_wayland_shm_get_addr(ctx_t * ctx) {
-    return ctx->wl.shmbuf.addr;
+void * wlm_wayland_shm_get_addr(ctx_t * ctx, wlm_wayland_shm_handle_t handle) {
+    if (handle >= ctx->wl.shmbuf.num_buffers) return NULL;
+    return (uint8_t *)ctx->wl.shmbuf.addr + ctx->wl.shmbuf.buffers[handle].offset;
+}
+
+// --- wlm_wayland_shm_get_dmabuf ---
+
+dmabuf_t * wlm_wayland_shm_get_dmabuf(ctx_t * ctx, wlm_wayland_shm_handle_t handle) {
+    if (handle >= ctx->wl.shmbuf.num_buffers) return NULL;
+    if (ctx->wl.shmbuf.udmabuf_disabled) return NULL;
+    if (ctx->wl.shmbuf.buffers[handle].dmabuf.planes == 0) return NULL;
+    return &ctx->wl.shmbuf.buffers[handle].dmabuf;
+}
+
+// --- wlm_wayland_shm_disable_dmabuf ---
+
+void wlm_wayland_shm_disable_dmabuf(ctx_t * ctx) {
+    ctx->wl.shmbuf.udmabuf_disabled = true;
+
+    // keep the udmabufs of the current ring until it is deallocated
+    // - the shown buffer may still back the texture until the next frame is copied
+    if (ctx->wl.shmbuf.udmabuf_fd != -1) close(ctx->wl.shmbuf.udmabuf_fd);
+    ctx->wl.shmbuf.udmabuf_fd = -1;
 }
 
 // --- wlm_wayland_shm_init ---
@@ -133,7 +277,16 @@ void wlm_wayland_shm_init(ctx_t * ctx) {
     ctx->wl.shmbuf.size = 0;
     ctx->wl.shmbuf.addr = NULL;
     ctx->wl.shmbuf.pool = NULL;
-    ctx->wl.shmbuf.buffer = NULL;
+    ctx->wl.shmbuf.udmabuf_fd = -1;
+    ctx->wl.shmbuf.udmabuf_disabled = false;
+    for (size_t i = 0; i < WLM_WAYLAND_SHM_NUM_BUFFERS; i++) {
+        ctx->wl.shmbuf.buffers[i].offset = 0;
+        ctx->wl.shmbuf.buffers[i].buffer = NULL;
+        ctx->wl.shmbuf.buffers[i].dmabuf.planes = 0;
+        ctx->wl.shmbuf.buffers[i].dmabuf.fds[0] = -1;
+    }
+    ctx->wl.shmbuf.num_buffers = 0;
+    ctx->wl.shmbuf.next_buffer = 0;
     ctx->wl.shmbuf.initialized = true;
 }
 
@@ -149,4 +302,5 @@ void wlm_wayland_shm_cleanup(ctx_t * ctx) {
     if (ctx->wl.shmbuf.pool != NULL) wl_shm_pool_destroy(ctx->wl.shmbuf.pool);
     if (ctx->wl.shmbuf.addr != NULL) munmap(ctx->wl.shmbuf.addr, ctx->wl.shmbuf.size);
     if (ctx->wl.shmbuf.fd != -1) close(ctx->wl.shmbuf.fd);
+    if (ctx->wl.shmbuf.udmabuf_fd != -1) close(ctx->wl.shmbuf.udmabuf_fd);
 }
@@ -0,0 +1,60 @@
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <wlm/context.h>
+
+// frames allowed to allocate while backends, textures and buffer pools are set up
+#define WARMUP_FRAMES 10
+
+// wlm-alloc-check is wl-mirror linked with --wrap for the allocation functions
+// and for wlm_mirror_frame_ready(), so every frame of the capture, import and
+// draw loop after warmup is checked, not the allocations inside GL drivers or
+// libwayland
+void * __real_malloc(size_t size);
+void * __real_calloc(size_t num, size_t size);
+void * __real_realloc(void * ptr, size_t size);
+void __real_wlm_mirror_frame_ready(ctx_t * ctx);
+
+static bool count_allocations = false;
+static uint64_t num_allocations = 0;
+static uint64_t num_frames = 0;
+
+void * __wrap_malloc(size_t size) {
+    if (count_allocations) num_allocations++;
+    return __real_malloc(size);
+}
+
+void * __wrap_calloc(size_t num, size_t size) {
+    if (count_allocations) num_allocations++;
+    return __real_calloc(num, size);
+}
+
+void * __wrap_realloc(void * ptr, size_t size) {
+    if (count_allocations) num_allocations++;
+    return __real_realloc(ptr, size);
+}
+
+static void on_exit_report(void) {
+    uint64_t checked = num_frames > WARMUP_FRAMES ? num_frames - WARMUP_FRAMES : 0;
+    printf("alloc-check: %" PRIu64 " allocations in %" PRIu64 " frames\n", num_allocations, checked);
+    fflush(stdout);
+}
+
+// counts from the end of one frame to the end of the next one, covering the
+// capture request, the backend callbacks, the buffer import and the draw
+void __wrap_wlm_mirror_frame_ready(ctx_t * ctx) {
+    if (num_frames == 0) atexit(on_exit_report);
+
+    __real_wlm_mirror_frame_ready(ctx);
+    num_frames++;
+
+    if (count_allocations && num_allocations > 0) {
+        count_allocations = false;
+        wlm_log_error("alloc-check::frame_ready(): frame %" PRIu64 " allocated memory after warmup\n", num_frames);
+        wlm_exit_fail(ctx);
+    }
+
+    if (num_frames == WARMUP_FRAMES) count_allocations = true;
+}
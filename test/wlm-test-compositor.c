@@ -0,0 +1,2537 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/dma-buf.h>
+#include <linux/dma-heap.h>
+#include <wayland-server.h>
+#include <wlm/log.h>
+#include <wlm/proto/server/xdg-shell.h>
+#include <wlm/proto/server/viewporter.h>
+#include <wlm/proto/server/xdg-output-unstable-v1.h>
+#include <wlm/proto/server/linux-dmabuf-unstable-v1.h>
+#include <wlm/proto/server/wlr-screencopy-unstable-v1.h>
+#include <wlm/proto/server/wlr-export-dmabuf-unstable-v1.h>
+#include <wlm/proto/server/ext-image-capture-source-v1.h>
+#include <wlm/proto/server/ext-image-copy-capture-v1.h>
+
+// DRM fourcc codes and modifiers of the buffers offered for capture
+#define DRM_FORMAT_ARGB8888 0x34325241
+#define DRM_FORMAT_XRGB8888 0x34325258
+#define DRM_FORMAT_MOD_LINEAR 0ull
+#define DRM_FORMAT_MOD_INVALID 0x00ffffffffffffffull
+
+#define OUTPUT_NAME "HEADLESS-1"
+
+#define DEFAULT_WIDTH 640
+#define DEFAULT_HEIGHT 480
+#define DEFAULT_REFRESH_HZ 60
+#define DEFAULT_FRAMES 120
+#define DEFAULT_WARMUP_FRAMES 10
+#define DEFAULT_TIMEOUT_S 30
+
+// the scene is a checkerboard with a square moving across it
+// - all edges are on the cell grid, window samples are taken at cell centers
+//   so they don't depend on the scaling filter
+#define SCENE_CELL_SIZE 16
+#define SCENE_SQUARE_SIZE 32
+#define SCENE_BACKGROUND_LIGHT 0xffc0c0c0
+#define SCENE_BACKGROUND_DARK 0xff404040
+
+// scene frames kept for damage accumulation and window verification
+#define SCENE_HISTORY 64
+
+// per channel difference allowed between a window sample and the scene
+#define SAMPLE_TOLERANCE 4
+
+// linux-dmabuf planes accepted per buffer, only single plane formats are offered
+#define DMABUF_MAX_PLANES 4
+
+// exit code that makes CTest report the test as skipped
+#define EXIT_SKIP 77
+
+typedef enum {
+    PROTO_SCREENCOPY = 1 << 0,
+    PROTO_EXTCOPY = 1 << 1,
+    PROTO_EXPORT_DMABUF = 1 << 2,
+    PROTO_LINUX_DMABUF = 1 << 3,
+} proto_t;
+
+typedef struct {
+    const char * name;
+    proto_t proto;
+} proto_name_t;
+
+static const proto_name_t proto_names[] = {
+    { "screencopy", PROTO_SCREENCOPY },
+    { "extcopy", PROTO_EXTCOPY },
+    { "export-dmabuf", PROTO_EXPORT_DMABUF },
+    { "linux-dmabuf", PROTO_LINUX_DMABUF },
+    { NULL, 0 },
+};
+
+typedef struct {
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+} rect_t;
+
+typedef struct {
+    uint64_t serial;
+    uint32_t square_x;
+    uint32_t square_y;
+    uint32_t color;
+    // damage reported for the change from the previous frame
+    rect_t damage;
+} scene_frame_t;
+
+typedef struct {
+    bool verbose;
+    uint32_t width;
+    uint32_t height;
+    uint32_t refresh_hz;
+    uint64_t frames;
+    uint64_t warmup_frames;
+    uint64_t timeout_s;
+    uint64_t change_every;
+    bool full_damage;
+    uint32_t fail;
+    uint32_t omit;
+    const char * expect_backend;
+    bool expect_failure;
+    bool require_dmabuf;
+    char ** command;
+} options_t;
+
+typedef struct {
+    uint64_t scene_changes;
+    uint64_t captures;
+    uint64_t stale_captures;
+    uint64_t commits;
+    uint64_t unverified_commits;
+    uint64_t mismatched_commits;
+    uint64_t backwards_commits;
+    uint64_t delivered_frames;
+    uint64_t requests;
+    uint64_t roundtrips;
+
+    // counters at the start of the measured frames
+    uint64_t start_ns;
+    uint64_t start_requests;
+    uint64_t start_roundtrips;
+    uint64_t start_captures;
+    uint64_t latency_frames;
+
+    // results of the measured frames
+    bool measured;
+    double fps;
+    double requests_per_frame;
+    double roundtrips_per_frame;
+    double captures_per_frame;
+    double latency_per_frame;
+} stats_t;
+
+// a buffer reference that is cleared when the client destroys the buffer
+typedef struct {
+    struct wl_resource * resource;
+    struct wl_listener destroy;
+} buffer_ref_t;
+
+typedef struct comp comp_t;
+
+typedef struct {
+    comp_t * comp;
+    struct wl_resource * resource;
+    buffer_ref_t pending_buffer;
+    bool attached;
+    struct wl_list pending_callbacks;
+    struct wl_resource * xdg_surface;
+    struct wl_resource * xdg_toplevel;
+    uint32_t configure_serial;
+    bool entered;
+} surface_t;
+
+typedef struct {
+    comp_t * comp;
+    int fds[DMABUF_MAX_PLANES];
+    uint32_t offsets[DMABUF_MAX_PLANES];
+    uint32_t strides[DMABUF_MAX_PLANES];
+    uint64_t modifiers[DMABUF_MAX_PLANES];
+    bool used;
+} dmabuf_params_t;
+
+typedef struct {
+    int fd;
+    uint32_t offset;
+    uint32_t stride;
+    int32_t width;
+    int32_t height;
+    uint32_t format;
+} dmabuf_buffer_t;
+
+typedef struct {
+    comp_t * comp;
+    struct wl_resource * resource;
+    buffer_ref_t buffer;
+    bool with_damage;
+    bool copy_requested;
+    struct wl_list link;
+} screencopy_frame_t;
+
+typedef struct extcopy_frame extcopy_frame_t;
+
+typedef struct {
+    comp_t * comp;
+    struct wl_resource * resource;
+    extcopy_frame_t * frame;
+    uint64_t serial;
+    bool seen;
+} extcopy_session_t;
+
+struct extcopy_frame {
+    comp_t * comp;
+    struct wl_resource * resource;
+    extcopy_session_t * session;
+    buffer_ref_t buffer;
+    rect_t damage;
+    bool capture_requested;
+    struct wl_list link;
+};
+
+typedef struct {
+    comp_t * comp;
+    struct wl_resource * resource;
+    struct wl_list link;
+} export_frame_t;
+
+struct comp {
+    options_t opt;
+
+    // wayland server objects
+    struct wl_display * display;
+    struct wl_event_loop * loop;
+    struct wl_protocol_logger * logger;
+    struct wl_event_source * frame_timer;
+    struct wl_event_source * timeout_timer;
+    struct wl_event_source * sigchld;
+    int frame_timer_fd;
+
+    // client under test
+    struct wl_client * client;
+    struct wl_listener client_destroy;
+    pid_t child;
+    int child_status;
+    bool child_exited;
+    char cache_dir[64];
+
+    // scene
+    uint32_t * pixels;
+    uint64_t serial;
+    scene_frame_t history[SCENE_HISTORY];
+    uint64_t ticks;
+
+    // linux-dmabuf state
+    dev_t main_device;
+    int format_table_fd;
+    size_t format_table_size;
+    int dma_heap_fd;
+
+    // protocol state
+    struct wl_list output_resources;
+    struct wl_list frame_callbacks;
+    struct wl_list screencopy_frames;
+    struct wl_list extcopy_frames;
+    struct wl_list export_frames;
+    uint64_t screencopy_serial;
+    bool screencopy_seen;
+    surface_t * toplevel;
+
+    // results
+    char backend[32];
+    uint64_t delivered_serial;
+    stats_t stats;
+    uint64_t failures;
+    bool closing;
+    bool timed_out;
+    bool running;
+};
+
+// --- helper functions ---
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static bool rect_is_empty(rect_t rect) {
+    return rect.width <= 0 || rect.height <= 0;
+}
+
+static rect_t rect_union(rect_t a, rect_t b) {
+    if (rect_is_empty(a)) return b;
+    if (rect_is_empty(b)) return a;
+
+    int32_t x1 = a.x < b.x ? a.x : b.x;
+    int32_t y1 = a.y < b.y ? a.y : b.y;
+    int32_t x2 = a.x + a.width > b.x + b.width ? a.x + a.width : b.x + b.width;
+    int32_t y2 = a.y + a.height > b.y + b.height ? a.y + a.height : b.y + b.height;
+    return (rect_t){ x1, y1, x2 - x1, y2 - y1 };
+}
+
+static rect_t rect_clip(rect_t rect, int32_t width, int32_t height) {
+    int32_t x1 = rect.x < 0 ? 0 : rect.x;
+    int32_t y1 = rect.y < 0 ? 0 : rect.y;
+    int32_t x2 = rect.x + rect.width > width ? width : rect.x + rect.width;
+    int32_t y2 = rect.y + rect.height > height ? height : rect.y + rect.height;
+    if (x2 <= x1 || y2 <= y1) return (rect_t){ 0, 0, 0, 0 };
+    return (rect_t){ x1, y1, x2 - x1, y2 - y1 };
+}
+
+static rect_t full_rect(comp_t * comp) {
+    return (rect_t){ 0, 0, comp->opt.width, comp->opt.height };
+}
+
+static void fail(comp_t * comp) {
+    comp->failures++;
+}
+
+static void send_timestamp(uint32_t * sec_hi, uint32_t * sec_lo, uint32_t * nsec) {
+    // same clock as the frame timer, clients pace captures with it
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    *sec_hi = (uint64_t)ts.tv_sec >> 32;
+    *sec_lo = (uint64_t)ts.tv_sec & 0xffffffff;
+    *nsec = ts.tv_nsec;
+}
+
+static void on_resource_unlink(struct wl_resource * resource) {
+    wl_list_remove(wl_resource_get_link(resource));
+}
+
+static void on_buffer_ref_destroy(struct wl_listener * listener, void * data) {
+    buffer_ref_t * ref = wl_container_of(listener, ref, destroy);
+    ref->resource = NULL;
+    wl_list_remove(&ref->destroy.link);
+    wl_list_init(&ref->destroy.link);
+
+    (void)data;
+}
+
+static void buffer_ref_init(buffer_ref_t * ref) {
+    ref->resource = NULL;
+    ref->destroy.notify = on_buffer_ref_destroy;
+    wl_list_init(&ref->destroy.link);
+}
+
+static void buffer_ref_set(buffer_ref_t * ref, struct wl_resource * resource) {
+    wl_list_remove(&ref->destroy.link);
+    wl_list_init(&ref->destroy.link);
+    ref->resource = resource;
+    if (resource != NULL) wl_resource_add_destroy_listener(resource, &ref->destroy);
+}
+
+// --- scene ---
+
+static scene_frame_t * scene_frame(comp_t * comp, uint64_t serial) {
+    return &comp->history[serial % SCENE_HISTORY];
+}
+
+static uint32_t scene_color(uint64_t serial) {
+    // consecutive frames differ in every channel
+    uint32_t r = 32 + (serial * 53) % 192;
+    uint32_t g = 32 + (serial * 101) % 192;
+    uint32_t b = 32 + (serial * 149) % 192;
+    return 0xff000000 | r << 16 | g << 8 | b;
+}
+
+static uint32_t scene_pixel(const scene_frame_t * frame, uint32_t x, uint32_t y) {
+    if (x - frame->square_x < SCENE_SQUARE_SIZE && y - frame->square_y < SCENE_SQUARE_SIZE) return frame->color;
+    return (x / SCENE_CELL_SIZE + y / SCENE_CELL_SIZE) % 2 == 0 ? SCENE_BACKGROUND_LIGHT : SCENE_BACKGROUND_DARK;
+}
+
+static void scene_render(comp_t * comp, rect_t region) {
+    scene_frame_t * frame = scene_frame(comp, comp->serial);
+    for (int32_t y = region.y; y < region.y + region.height; y++) {
+        uint32_t * row = comp->pixels + (size_t)y * comp->opt.width;
+        for (int32_t x = region.x; x < region.x + region.width; x++) {
+            row[x] = scene_pixel(frame, x, y);
+        }
+    }
+}
+
+static rect_t scene_square(const scene_frame_t * frame) {
+    return (rect_t){ frame->square_x, frame->square_y, SCENE_SQUARE_SIZE, SCENE_SQUARE_SIZE };
+}
+
+static void scene_place(comp_t * comp, scene_frame_t * frame) {
+    // sweep the square across the screen row by row
+    uint32_t cols = (comp->opt.width - SCENE_SQUARE_SIZE) / SCENE_CELL_SIZE + 1;
+    uint32_t rows = (comp->opt.height - SCENE_SQUARE_SIZE) / SCENE_CELL_SIZE + 1;
+    uint64_t position = comp->serial % ((uint64_t)cols * rows);
+
+    frame->serial = comp->serial;
+    frame->square_x = (position % cols) * SCENE_CELL_SIZE;
+    frame->square_y = (position / cols) * SCENE_CELL_SIZE;
+    frame->color = scene_color(comp->serial);
+}
+
+static void scene_init(comp_t * comp) {
+    comp->serial = 1;
+    scene_frame_t * frame = scene_frame(comp, comp->serial);
+    scene_place(comp, frame);
+    frame->damage = full_rect(comp);
+    scene_render(comp, full_rect(comp));
+}
+
+static void scene_advance(comp_t * comp) {
+    rect_t old_square = scene_square(scene_frame(comp, comp->serial));
+
+    comp->serial++;
+    scene_frame_t * frame = scene_frame(comp, comp->serial);
+    scene_place(comp, frame);
+
+    rect_t changed = rect_union(old_square, scene_square(frame));
+    frame->damage = comp->opt.full_damage ? full_rect(comp) : changed;
+    scene_render(comp, changed);
+    comp->stats.scene_changes++;
+}
+
+// damage between the last frame a capture client has seen and the current one
+static rect_t scene_damage_since(comp_t * comp, uint64_t serial, bool seen) {
+    if (!seen || comp->serial - serial >= SCENE_HISTORY) return full_rect(comp);
+
+    rect_t damage = { 0, 0, 0, 0 };
+    for (uint64_t i = serial + 1; i <= comp->serial; i++) {
+        damage = rect_union(damage, scene_frame(comp, i)->damage);
+    }
+
+    return damage;
+}
+
+// --- buffer access ---
+
+typedef struct {
+    uint8_t * data;
+    uint32_t stride;
+    int32_t width;
+    int32_t height;
+    uint32_t format;
+    struct wl_shm_buffer * shm_buffer;
+    dmabuf_buffer_t * dmabuf_buffer;
+    void * map;
+    size_t map_size;
+    bool write;
+} buffer_access_t;
+
+static void dmabuf_buffer_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static const struct wl_buffer_interface dmabuf_buffer_impl = {
+    .destroy = dmabuf_buffer_destroy,
+};
+
+static dmabuf_buffer_t * dmabuf_buffer_from_resource(struct wl_resource * resource) {
+    if (!wl_resource_instance_of(resource, &wl_buffer_interface, &dmabuf_buffer_impl)) return NULL;
+    return (dmabuf_buffer_t *)wl_resource_get_user_data(resource);
+}
+
+static void dmabuf_sync(int fd, bool write, uint64_t flags) {
+    // not all exporters need this, failures are harmless for mapped memory
+    struct dma_buf_sync sync = { .flags = flags | (write ? DMA_BUF_SYNC_RW : DMA_BUF_SYNC_READ) };
+    ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync);
+}
+
+static bool buffer_begin_access(comp_t * comp, struct wl_resource * resource, bool write, buffer_access_t * access) {
+    access->data = NULL;
+    access->shm_buffer = NULL;
+    access->dmabuf_buffer = NULL;
+    access->map = NULL;
+    access->map_size = 0;
+    access->write = write;
+
+    struct wl_shm_buffer * shm_buffer = wl_shm_buffer_get(resource);
+    if (shm_buffer != NULL) {
+        // wl_shm formats equal DRM formats except for the two mandatory ones
+        uint32_t format = wl_shm_buffer_get_format(shm_buffer);
+        if (format == WL_SHM_FORMAT_ARGB8888) format = DRM_FORMAT_ARGB8888;
+        if (format == WL_SHM_FORMAT_XRGB8888) format = DRM_FORMAT_XRGB8888;
+
+        wl_shm_buffer_begin_access(shm_buffer);
+        access->shm_buffer = shm_buffer;
+        access->data = (uint8_t *)wl_shm_buffer_get_data(shm_buffer);
+        access->stride = wl_shm_buffer_get_stride(shm_buffer);
+        access->width = wl_shm_buffer_get_width(shm_buffer);
+        access->height = wl_shm_buffer_get_height(shm_buffer);
+        access->format = format;
+        return true;
+    }
+
+    dmabuf_buffer_t * dmabuf_buffer = dmabuf_buffer_from_resource(resource);
+    if (dmabuf_buffer == NULL) return false;
+
+    size_t size = dmabuf_buffer->offset + (size_t)dmabuf_buffer->stride * dmabuf_buffer->height;
+    void * map = mmap(NULL, size, PROT_READ | (write ? PROT_WRITE : 0), MAP_SHARED, dmabuf_buffer->fd, 0);
+    if (map == MAP_FAILED) {
+        wlm_log_error("test-compositor::buffer_begin_access(): failed to map DMA-BUF\n");
+        return false;
+    }
+
+    dmabuf_sync(dmabuf_buffer->fd, write, DMA_BUF_SYNC_START);
+    access->dmabuf_buffer = dmabuf_buffer;
+    access->map = map;
+    access->map_size = size;
+    access->data = (uint8_t *)map + dmabuf_buffer->offset;
+    access->stride = dmabuf_buffer->stride;
+    access->width = dmabuf_buffer->width;
+    access->height = dmabuf_buffer->height;
+    access->format = dmabuf_buffer->format;
+
+    (void)comp;
+    return true;
+}
+
+static void buffer_end_access(buffer_access_t * access) {
+    if (access->shm_buffer != NULL) {
+        wl_shm_buffer_end_access(access->shm_buffer);
+    } else if (access->dmabuf_buffer != NULL) {
+        dmabuf_sync(access->dmabuf_buffer->fd, access->write, DMA_BUF_SYNC_END);
+        munmap(access->map, access->map_size);
+    }
+
+    access->data = NULL;
+    access->shm_buffer = NULL;
+    access->dmabuf_buffer = NULL;
+    access->map = NULL;
+}
+
+static bool buffer_matches_output(comp_t * comp, buffer_access_t * access) {
+    if (access->width != (int32_t)comp->opt.width || access->height != (int32_t)comp->opt.height) return false;
+    if (access->format != DRM_FORMAT_XRGB8888 && access->format != DRM_FORMAT_ARGB8888) return false;
+    return access->stride >= comp->opt.width * 4;
+}
+
+// --- captures ---
+
+static bool buffer_shows_scene(comp_t * comp, buffer_access_t * access) {
+    for (uint32_t y = 0; y < comp->opt.height; y++) {
+        const uint32_t * row = (const uint32_t *)(access->data + (size_t)y * access->stride);
+        const uint32_t * scene_row = comp->pixels + (size_t)y * comp->opt.width;
+        for (uint32_t x = 0; x < comp->opt.width; x++) {
+            if (((row[x] ^ scene_row[x]) & 0x00ffffff) != 0) return false;
+        }
+    }
+
+    return true;
+}
+
+// copy the damaged part of the scene into a capture buffer
+// - the rest of the buffer must still hold the current scene, otherwise the
+//   client asked for too little damage and shows stale pixels
+static bool capture_into(comp_t * comp, struct wl_resource * buffer, rect_t damage, const char * proto) {
+    buffer_access_t access;
+    if (buffer == NULL || !buffer_begin_access(comp, buffer, true, &access)) return false;
+
+    if (!buffer_matches_output(comp, &access)) {
+        wlm_log_error("test-compositor::capture_into(): %s buffer doesn't match the output\n", proto);
+        buffer_end_access(&access);
+        return false;
+    }
+
+    damage = rect_clip(damage, comp->opt.width, comp->opt.height);
+    for (int32_t y = damage.y; y < damage.y + damage.height; y++) {
+        uint8_t * row = access.data + (size_t)y * access.stride + (size_t)damage.x * 4;
+        const uint32_t * scene_row = comp->pixels + (size_t)y * comp->opt.width + damage.x;
+        memcpy(row, scene_row, (size_t)damage.width * 4);
+    }
+
+    if (!buffer_shows_scene(comp, &access)) {
+        if (comp->stats.stale_captures == 0) {
+            wlm_log_error("test-compositor::capture_into(): %s buffer holds stale pixels outside of the copied damage\n", proto);
+        }
+        comp->stats.stale_captures++;
+        fail(comp);
+    }
+
+    snprintf(comp->backend, sizeof comp->backend, "%s-%s", proto, access.shm_buffer != NULL ? "shm" : "dmabuf");
+    comp->stats.captures++;
+    buffer_end_access(&access);
+    return true;
+}
+
+// --- window verification ---
+
+static bool pixel_close(uint32_t a, uint32_t b) {
+    for (int shift = 0; shift < 24; shift += 8) {
+        int diff = (int)((a >> shift) & 0xff) - (int)((b >> shift) & 0xff);
+        if (diff < -SAMPLE_TOLERANCE || diff > SAMPLE_TOLERANCE) return false;
+    }
+
+    return true;
+}
+
+static bool window_shows(comp_t * comp, buffer_access_t * access, const scene_frame_t * frame) {
+    for (uint32_t y = SCENE_CELL_SIZE / 2; y < comp->opt.height; y += SCENE_CELL_SIZE) {
+        const uint32_t * row = (const uint32_t *)(access->data + (size_t)y * access->stride);
+        for (uint32_t x = SCENE_CELL_SIZE / 2; x < comp->opt.width; x += SCENE_CELL_SIZE) {
+            if (!pixel_close(row[x], scene_pixel(frame, x, y))) return false;
+        }
+    }
+
+    return true;
+}
+
+static void close_client(comp_t * comp) {
+    if (comp->closing) return;
+
+    wlm_log_debug(comp, "test-compositor::close_client(): closing the window\n");
+    comp->closing = true;
+    if (comp->toplevel != NULL && comp->toplevel->xdg_toplevel != NULL) {
+        xdg_toplevel_send_close(comp->toplevel->xdg_toplevel);
+    } else if (comp->child > 0) {
+        kill(comp->child, SIGTERM);
+    }
+}
+
+static void frame_delivered(comp_t * comp, uint64_t serial) {
+    stats_t * stats = &comp->stats;
+    stats->delivered_frames++;
+    stats->latency_frames += comp->serial - serial;
+    comp->delivered_serial = serial;
+
+    if (stats->delivered_frames == comp->opt.warmup_frames) {
+        // measure from here, startup and backend selection are over
+        stats->start_ns = now_ns();
+        stats->start_requests = stats->requests;
+        stats->start_roundtrips = stats->roundtrips;
+        stats->start_captures = stats->captures;
+        stats->latency_frames = 0;
+    } else if (stats->delivered_frames == comp->opt.warmup_frames + comp->opt.frames) {
+        double frames = comp->opt.frames;
+        stats->measured = true;
+        stats->fps = frames * 1e9 / (now_ns() - stats->start_ns);
+        stats->requests_per_frame = (stats->requests - stats->start_requests) / frames;
+        stats->roundtrips_per_frame = (stats->roundtrips - stats->start_roundtrips) / frames;
+        stats->captures_per_frame = (stats->captures - stats->start_captures) / frames;
+        stats->latency_per_frame = stats->latency_frames / frames;
+        close_client(comp);
+    }
+}
+
+// match a committed window buffer against the recent scene frames
+static void verify_window(comp_t * comp, struct wl_resource * buffer) {
+    buffer_access_t access;
+    if (!buffer_begin_access(comp, buffer, false, &access)) {
+        comp->stats.unverified_commits++;
+        return;
+    }
+
+    if (!buffer_matches_output(comp, &access)) {
+        // the window is only sampled when it has the size of the output
+        comp->stats.unverified_commits++;
+        buffer_end_access(&access);
+        return;
+    }
+
+    uint64_t oldest = comp->serial > SCENE_HISTORY ? comp->serial - SCENE_HISTORY + 1 : 1;
+    uint64_t matched = 0;
+    for (uint64_t serial = comp->serial; serial >= oldest && matched == 0; serial--) {
+        if (window_shows(comp, &access, scene_frame(comp, serial))) matched = serial;
+    }
+    buffer_end_access(&access);
+
+    if (matched == 0) {
+        // the window is blank until the first capture arrives
+        if (comp->delivered_serial == 0) return;
+
+        if (comp->stats.mismatched_commits == 0) {
+            wlm_log_error("test-compositor::verify_window(): window shows none of the last %d frames\n", SCENE_HISTORY);
+        }
+        comp->stats.mismatched_commits++;
+        fail(comp);
+    } else if (matched < comp->delivered_serial) {
+        if (comp->stats.backwards_commits == 0) {
+            wlm_log_error("test-compositor::verify_window(): window went back from frame %" PRIu64 " to %" PRIu64 "\n", comp->delivered_serial, matched);
+        }
+        comp->stats.backwards_commits++;
+        fail(comp);
+    } else if (matched > comp->delivered_serial) {
+        frame_delivered(comp, matched);
+    }
+}
+
+// --- wl_region ---
+
+static void region_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static void region_add(struct wl_client * client, struct wl_resource * resource, int32_t x, int32_t y, int32_t width, int32_t height) {
+    (void)client;
+    (void)resource;
+    (void)x;
+    (void)y;
+    (void)width;
+    (void)height;
+}
+
+static const struct wl_region_interface region_impl = {
+    .destroy = region_destroy,
+    .add = region_add,
+    .subtract = region_add,
+};
+
+// --- wl_surface ---
+
+static void surface_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static void surface_attach(struct wl_client * client, struct wl_resource * resource, struct wl_resource * buffer, int32_t x, int32_t y) {
+    surface_t * surface = (surface_t *)wl_resource_get_user_data(resource);
+    buffer_ref_set(&surface->pending_buffer, buffer);
+    surface->attached = true;
+
+    (void)client;
+    (void)x;
+    (void)y;
+}
+
+static void surface_damage(struct wl_client * client, struct wl_resource * resource, int32_t x, int32_t y, int32_t width, int32_t height) {
+    // windows are verified as a whole
+    (void)client;
+    (void)resource;
+    (void)x;
+    (void)y;
+    (void)width;
+    (void)height;
+}
+
+static void surface_frame(struct wl_client * client, struct wl_resource * resource, uint32_t id) {
+    surface_t * surface = (surface_t *)wl_resource_get_user_data(resource);
+
+    struct wl_resource * callback = wl_resource_create(client, &wl_callback_interface, 1, id);
+    if (callback == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(callback, NULL, NULL, on_resource_unlink);
+    wl_list_insert(surface->pending_callbacks.prev, wl_resource_get_link(callback));
+}
+
+static void surface_set_region(struct wl_client * client, struct wl_resource * resource, struct wl_resource * region) {
+    (void)client;
+    (void)resource;
+    (void)region;
+}
+
+static void toplevel_configure(surface_t * surface, bool activated) {
+    comp_t * comp = surface->comp;
+
+    // the window gets the size of the output, so it shows the scene 1:1
+    struct wl_array states;
+    wl_array_init(&states);
+    if (activated) {
+        uint32_t * state = wl_array_add(&states, sizeof (uint32_t));
+        if (state != NULL) *state = XDG_TOPLEVEL_STATE_ACTIVATED;
+    }
+    xdg_toplevel_send_configure(surface->xdg_toplevel, comp->opt.width, comp->opt.height, &states);
+    wl_array_release(&states);
+
+    surface->configure_serial = wl_display_next_serial(comp->display);
+    xdg_surface_send_configure(surface->xdg_surface, surface->configure_serial);
+}
+
+static void surface_commit(struct wl_client * client, struct wl_resource * resource) {
+    surface_t * surface = (surface_t *)wl_resource_get_user_data(resource);
+    comp_t * comp = surface->comp;
+
+    // frame callbacks are done on the next frame clock tick
+    wl_list_insert_list(comp->frame_callbacks.prev, &surface->pending_callbacks);
+    wl_list_init(&surface->pending_callbacks);
+
+    if (surface->xdg_toplevel != NULL && surface->configure_serial == 0) {
+        // initial commit
+        toplevel_configure(surface, false);
+        return;
+    }
+
+    if (!surface->attached) return;
+    struct wl_resource * buffer = surface->pending_buffer.resource;
+    buffer_ref_set(&surface->pending_buffer, NULL);
+    surface->attached = false;
+    if (buffer == NULL) return;
+
+    if (!surface->entered) {
+        struct wl_resource * output;
+        wl_resource_for_each(output, &comp->output_resources) {
+            if (wl_resource_get_client(output) == client) wl_surface_send_enter(resource, output);
+        }
+        surface->entered = true;
+
+        // focus the window once it is mapped, like a desktop compositor would
+        if (surface->xdg_toplevel != NULL) toplevel_configure(surface, true);
+    }
+
+    // the contents are inspected right away, the client may reuse the buffer
+    comp->stats.commits++;
+    verify_window(comp, buffer);
+    wl_buffer_send_release(buffer);
+}
+
+static void surface_set_int(struct wl_client * client, struct wl_resource * resource, int32_t value) {
+    (void)client;
+    (void)resource;
+    (void)value;
+}
+
+static void surface_offset(struct wl_client * client, struct wl_resource * resource, int32_t x, int32_t y) {
+    (void)client;
+    (void)resource;
+    (void)x;
+    (void)y;
+}
+
+static const struct wl_surface_interface surface_impl = {
+    .destroy = surface_destroy,
+    .attach = surface_attach,
+    .damage = surface_damage,
+    .frame = surface_frame,
+    .set_opaque_region = surface_set_region,
+    .set_input_region = surface_set_region,
+    .commit = surface_commit,
+    .set_buffer_transform = surface_set_int,
+    .set_buffer_scale = surface_set_int,
+    .damage_buffer = surface_damage,
+    .offset = surface_offset,
+};
+
+static void on_surface_destroy(struct wl_resource * resource) {
+    surface_t * surface = (surface_t *)wl_resource_get_user_data(resource);
+    comp_t * comp = surface->comp;
+
+    struct wl_resource * callback;
+    struct wl_resource * tmp;
+    wl_resource_for_each_safe(callback, tmp, &surface->pending_callbacks) {
+        wl_resource_destroy(callback);
+    }
+
+    // role objects outliving their surface are inert
+    if (surface->xdg_surface != NULL) wl_resource_set_user_data(surface->xdg_surface, NULL);
+    if (surface->xdg_toplevel != NULL) wl_resource_set_user_data(surface->xdg_toplevel, NULL);
+    if (comp->toplevel == surface) comp->toplevel = NULL;
+
+    buffer_ref_set(&surface->pending_buffer, NULL);
+    free(surface);
+}
+
+// --- wl_compositor ---
+
+static void compositor_create_surface(struct wl_client * client, struct wl_resource * resource, uint32_t id) {
+    comp_t * comp = (comp_t *)wl_resource_get_user_data(resource);
+
+    surface_t * surface = calloc(1, sizeof (surface_t));
+    struct wl_resource * surface_resource = wl_resource_create(client, &wl_surface_interface, wl_resource_get_version(resource), id);
+    if (surface == NULL || surface_resource == NULL) {
+        free(surface);
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    surface->comp = comp;
+    surface->resource = surface_resource;
+    buffer_ref_init(&surface->pending_buffer);
+    surface->attached = false;
+    wl_list_init(&surface->pending_callbacks);
+    surface->xdg_surface = NULL;
+    surface->xdg_toplevel = NULL;
+    surface->configure_serial = 0;
+    surface->entered = false;
+    wl_resource_set_implementation(surface_resource, &surface_impl, surface, on_surface_destroy);
+}
+
+static void compositor_create_region(struct wl_client * client, struct wl_resource * resource, uint32_t id) {
+    struct wl_resource * region = wl_resource_create(client, &wl_region_interface, 1, id);
+    if (region == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(region, &region_impl, NULL, NULL);
+
+    (void)resource;
+}
+
+static const struct wl_compositor_interface compositor_impl = {
+    .create_surface = compositor_create_surface,
+    .create_region = compositor_create_region,
+};
+
+static void bind_compositor(struct wl_client * client, void * data, uint32_t version, uint32_t id) {
+    struct wl_resource * resource = wl_resource_create(client, &wl_compositor_interface, version, id);
+    if (resource == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(resource, &compositor_impl, data, NULL);
+}
+
+// --- wl_output ---
+
+static void output_release(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static const struct wl_output_interface output_impl = {
+    .release = output_release,
+};
+
+static void bind_output(struct wl_client * client, void * data, uint32_t version, uint32_t id) {
+    comp_t * comp = (comp_t *)data;
+
+    struct wl_resource * resource = wl_resource_create(client, &wl_output_interface, version, id);
+    if (resource == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(resource, &output_impl, comp, on_resource_unlink);
+    wl_list_insert(&comp->output_resources, wl_resource_get_link(resource));
+
+    wl_output_send_geometry(resource, 0, 0, comp->opt.width / 4, comp->opt.height / 4,
+        WL_OUTPUT_SUBPIXEL_UNKNOWN, "wl-mirror", "test compositor", WL_OUTPUT_TRANSFORM_NORMAL);
+    wl_output_send_mode(resource, WL_OUTPUT_MODE_CURRENT | WL_OUTPUT_MODE_PREFERRED,
+        comp->opt.width, comp->opt.height, comp->opt.refresh_hz * 1000);
+    if (version >= WL_OUTPUT_SCALE_SINCE_VERSION) wl_output_send_scale(resource, 1);
+    if (version >= WL_OUTPUT_NAME_SINCE_VERSION) wl_output_send_name(resource, OUTPUT_NAME);
+    if (version >= WL_OUTPUT_DESCRIPTION_SINCE_VERSION) wl_output_send_description(resource, "headless test output");
+    if (version >= WL_OUTPUT_DONE_SINCE_VERSION) wl_output_send_done(resource);
+}
+
+static bool is_output(struct wl_resource * resource) {
+    return wl_resource_instance_of(resource, &wl_output_interface, &output_impl);
+}
+
+// --- xdg_output ---
+
+static void xdg_output_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static const struct zxdg_output_v1_interface xdg_output_impl = {
+    .destroy = xdg_output_destroy,
+};
+
+static void xdg_output_manager_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static void xdg_output_manager_get_xdg_output(struct wl_client * client, struct wl_resource * resource, uint32_t id, struct wl_resource * output) {
+    comp_t * comp = (comp_t *)wl_resource_get_user_data(resource);
+
+    uint32_t version = wl_resource_get_version(resource);
+    struct wl_resource * xdg_output = wl_resource_create(client, &zxdg_output_v1_interface, version, id);
+    if (xdg_output == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(xdg_output, &xdg_output_impl, comp, NULL);
+    zxdg_output_v1_send_logical_position(xdg_output, 0, 0);
+    zxdg_output_v1_send_logical_size(xdg_output, comp->opt.width, comp->opt.height);
+    if (version >= ZXDG_OUTPUT_V1_NAME_SINCE_VERSION) zxdg_output_v1_send_name(xdg_output, OUTPUT_NAME);
+    if (version >= ZXDG_OUTPUT_V1_DESCRIPTION_SINCE_VERSION) zxdg_output_v1_send_description(xdg_output, "headless test output");
+
+    // version 3 replaced this with wl_output.done
+    if (version < 3) {
+        zxdg_output_v1_send_done(xdg_output);
+    } else if (wl_resource_get_version(output) >= WL_OUTPUT_DONE_SINCE_VERSION) {
+        wl_output_send_done(output);
+    }
+}
+
+static const struct zxdg_output_manager_v1_interface xdg_output_manager_impl = {
+    .destroy = xdg_output_manager_destroy,
+    .get_xdg_output = xdg_output_manager_get_xdg_output,
+};
+
+static void bind_xdg_output_manager(struct wl_client * client, void * data, uint32_t version, uint32_t id) {
+    struct wl_resource * resource = wl_resource_create(client, &zxdg_output_manager_v1_interface, version, id);
+    if (resource == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(resource, &xdg_output_manager_impl, data, NULL);
+}
+
+// --- xdg_toplevel ---
+
+static void toplevel_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static void toplevel_set_parent(struct wl_client * client, struct wl_resource * resource, struct wl_resource * parent) {
+    (void)client;
+    (void)resource;
+    (void)parent;
+}
+
+static void toplevel_set_string(struct wl_client * client, struct wl_resource * resource, const char * value) {
+    (void)client;
+    (void)resource;
+    (void)value;
+}
+
+static void toplevel_show_window_menu(struct wl_client * client, struct wl_resource * resource, struct wl_resource * seat, uint32_t serial, int32_t x, int32_t y) {
+    (void)client;
+    (void)resource;
+    (void)seat;
+    (void)serial;
+    (void)x;
+    (void)y;
+}
+
+static void toplevel_move(struct wl_client * client, struct wl_resource * resource, struct wl_resource * seat, uint32_t serial) {
+    (void)client;
+    (void)resource;
+    (void)seat;
+    (void)serial;
+}
+
+static void toplevel_resize(struct wl_client * client, struct wl_resource * resource, struct wl_resource * seat, uint32_t serial, uint32_t edges) {
+    (void)client;
+    (void)resource;
+    (void)seat;
+    (void)serial;
+    (void)edges;
+}
+
+static void toplevel_set_size(struct wl_client * client, struct wl_resource * resource, int32_t width, int32_t height) {
+    (void)client;
+    (void)resource;
+    (void)width;
+    (void)height;
+}
+
+static void toplevel_set_state(struct wl_client * client, struct wl_resource * resource) {
+    (void)client;
+    (void)resource;
+}
+
+static void toplevel_set_fullscreen(struct wl_client * client, struct wl_resource * resource, struct wl_resource * output) {
+    // the window already covers the only output
+    (void)client;
+    (void)resource;
+    (void)output;
+}
+
+static const struct xdg_toplevel_interface toplevel_impl = {
+    .destroy = toplevel_destroy,
+    .set_parent = toplevel_set_parent,
+    .set_title = toplevel_set_string,
+    .set_app_id = toplevel_set_string,
+    .show_window_menu = toplevel_show_window_menu,
+    .move = toplevel_move,
+    .resize = toplevel_resize,
+    .set_max_size = toplevel_set_size,
+    .set_min_size = toplevel_set_size,
+    .set_maximized = toplevel_set_state,
+    .unset_maximized = toplevel_set_state,
+    .set_fullscreen = toplevel_set_fullscreen,
+    .unset_fullscreen = toplevel_set_state,
+    .set_minimized = toplevel_set_state,
+};
+
+static void on_toplevel_destroy(struct wl_resource * resource) {
+    surface_t * surface = (surface_t *)wl_resource_get_user_data(resource);
+    if (surface != NULL) surface->xdg_toplevel = NULL;
+}
+
+// --- xdg_surface ---
+
+static void xdg_surface_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static void xdg_surface_get_toplevel(struct wl_client * client, struct wl_resource * resource, uint32_t id) {
+    surface_t * surface = (surface_t *)wl_resource_get_user_data(resource);
+    if (surface == NULL) {
+        wl_resource_post_error(resource, XDG_SURFACE_ERROR_DEFUNCT_ROLE_OBJECT, "surface was destroyed");
+        return;
+    }
+
+    struct wl_resource * toplevel = wl_resource_create(client, &xdg_toplevel_interface, wl_resource_get_version(resource), id);
+    if (toplevel == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(toplevel, &toplevel_impl, surface, on_toplevel_destroy);
+    surface->xdg_toplevel = toplevel;
+    surface->comp->toplevel = surface;
+}
+
+static void xdg_surface_get_popup(struct wl_client * client, struct wl_resource * resource, uint32_t id, struct wl_resource * parent, struct wl_resource * positioner) {
+    wl_client_post_implementation_error(client, "xdg_popup is not supported by the test compositor");
+
+    (void)resource;
+    (void)id;
+    (void)parent;
+    (void)positioner;
+}
+
+static void xdg_surface_set_window_geometry(struct wl_client * client, struct wl_resource * resource, int32_t x, int32_t y, int32_t width, int32_t height) {
+    (void)client;
+    (void)resource;
+    (void)x;
+    (void)y;
+    (void)width;
+    (void)height;
+}
+
+static void xdg_surface_ack_configure(struct wl_client * client, struct wl_resource * resource, uint32_t serial) {
+    (void)client;
+    (void)resource;
+    (void)serial;
+}
+
+static const struct xdg_surface_interface xdg_surface_impl = {
+    .destroy = xdg_surface_destroy,
+    .get_toplevel = xdg_surface_get_toplevel,
+    .get_popup = xdg_surface_get_popup,
+    .set_window_geometry = xdg_surface_set_window_geometry,
+    .ack_configure = xdg_surface_ack_configure,
+};
+
+static void on_xdg_surface_destroy(struct wl_resource * resource) {
+    surface_t * surface = (surface_t *)wl_resource_get_user_data(resource);
+    if (surface != NULL) surface->xdg_surface = NULL;
+}
+
+// --- xdg_wm_base ---
+
+static void wm_base_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static void wm_base_create_positioner(struct wl_client * client, struct wl_resource * resource, uint32_t id) {
+    wl_client_post_implementation_error(client, "xdg_positioner is not supported by the test compositor");
+
+    (void)resource;
+    (void)id;
+}
+
+static void wm_base_get_xdg_surface(struct wl_client * client, struct wl_resource * resource, uint32_t id, struct wl_resource * surface_resource) {
+    surface_t * surface = (surface_t *)wl_resource_get_user_data(surface_resource);
+
+    struct wl_resource * xdg_surface = wl_resource_create(client, &xdg_surface_interface, wl_resource_get_version(resource), id);
+    if (xdg_surface == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(xdg_surface, &xdg_surface_impl, surface, on_xdg_surface_destroy);
+    surface->xdg_surface = xdg_surface;
+}
+
+static void wm_base_pong(struct wl_client * client, struct wl_resource * resource, uint32_t serial) {
+    (void)client;
+    (void)resource;
+    (void)serial;
+}
+
+static const struct xdg_wm_base_interface wm_base_impl = {
+    .destroy = wm_base_destroy,
+    .create_positioner = wm_base_create_positioner,
+    .get_xdg_surface = wm_base_get_xdg_surface,
+    .pong = wm_base_pong,
+};
+
+static void bind_wm_base(struct wl_client * client, void * data, uint32_t version, uint32_t id) {
+    struct wl_resource * resource = wl_resource_create(client, &xdg_wm_base_interface, version, id);
+    if (resource == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(resource, &wm_base_impl, data, NULL);
+}
+
+// --- wp_viewporter ---
+
+static void viewport_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static void viewport_set_source(struct wl_client * client, struct wl_resource * resource, wl_fixed_t x, wl_fixed_t y, wl_fixed_t width, wl_fixed_t height) {
+    (void)client;
+    (void)resource;
+    (void)x;
+    (void)y;
+    (void)width;
+    (void)height;
+}
+
+static void viewport_set_destination(struct wl_client * client, struct wl_resource * resource, int32_t width, int32_t height) {
+    // buffers are only verified when they have the size of the output anyway
+    (void)client;
+    (void)resource;
+    (void)width;
+    (void)height;
+}
+
+static const struct wp_viewport_interface viewport_impl = {
+    .destroy = viewport_destroy,
+    .set_source = viewport_set_source,
+    .set_destination = viewport_set_destination,
+};
+
+static void viewporter_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static void viewporter_get_viewport(struct wl_client * client, struct wl_resource * resource, uint32_t id, struct wl_resource * surface) {
+    struct wl_resource * viewport = wl_resource_create(client, &wp_viewport_interface, 1, id);
+    if (viewport == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(viewport, &viewport_impl, NULL, NULL);
+
+    (void)resource;
+    (void)surface;
+}
+
+static const struct wp_viewporter_interface viewporter_impl = {
+    .destroy = viewporter_destroy,
+    .get_viewport = viewporter_get_viewport,
+};
+
+static void bind_viewporter(struct wl_client * client, void * data, uint32_t version, uint32_t id) {
+    struct wl_resource * resource = wl_resource_create(client, &wp_viewporter_interface, version, id);
+    if (resource == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(resource, &viewporter_impl, data, NULL);
+}
+
+// --- linux_dmabuf ---
+
+static void on_dmabuf_buffer_destroy(struct wl_resource * resource) {
+    dmabuf_buffer_t * dmabuf_buffer = (dmabuf_buffer_t *)wl_resource_get_user_data(resource);
+    if (dmabuf_buffer == NULL) return;
+
+    close(dmabuf_buffer->fd);
+    free(dmabuf_buffer);
+}
+
+static void params_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static void params_add(struct wl_client * client, struct wl_resource * resource, int32_t fd, uint32_t plane_idx, uint32_t offset, uint32_t stride, uint32_t modifier_hi, uint32_t modifier_lo) {
+    dmabuf_params_t * params = (dmabuf_params_t *)wl_resource_get_user_data(resource);
+
+    if (params->used) {
+        close(fd);
+        wl_resource_post_error(resource, ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_ALREADY_USED, "params were already used");
+        return;
+    } else if (plane_idx >= DMABUF_MAX_PLANES) {
+        close(fd);
+        wl_resource_post_error(resource, ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_PLANE_IDX, "plane index %u is too large", plane_idx);
+        return;
+    } else if (params->fds[plane_idx] != -1) {
+        close(fd);
+        wl_resource_post_error(resource, ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_PLANE_SET, "plane %u was already set", plane_idx);
+        return;
+    }
+
+    params->fds[plane_idx] = fd;
+    params->offsets[plane_idx] = offset;
+    params->strides[plane_idx] = stride;
+    params->modifiers[plane_idx] = (uint64_t)modifier_hi << 32 | modifier_lo;
+
+    (void)client;
+}
+
+// take over the plane of a linear single plane buffer
+static dmabuf_buffer_t * params_import(dmabuf_params_t * params, int32_t width, int32_t height, uint32_t format) {
+    comp_t * comp = params->comp;
+    if (comp->opt.fail & PROTO_LINUX_DMABUF) {
+        wlm_log_debug(comp, "test-compositor::params_import(): failing DMA-BUF import\n");
+        return NULL;
+    }
+
+    for (size_t i = 1; i < DMABUF_MAX_PLANES; i++) {
+        if (params->fds[i] != -1) return NULL;
+    }
+
+    if (params->fds[0] == -1 || width <= 0 || height <= 0) return NULL;
+    if (format != DRM_FORMAT_XRGB8888 && format != DRM_FORMAT_ARGB8888) return NULL;
+    if (params->modifiers[0] != DRM_FORMAT_MOD_LINEAR && params->modifiers[0] != DRM_FORMAT_MOD_INVALID) return NULL;
+    if (params->strides[0] < (uint32_t)width * 4) return NULL;
+
+    off_t size = lseek(params->fds[0], 0, SEEK_END);
+    if (size != -1 && (uint64_t)size < params->offsets[0] + (uint64_t)params->strides[0] * height) return NULL;
+
+    dmabuf_buffer_t * dmabuf_buffer = malloc(sizeof (dmabuf_buffer_t));
+    if (dmabuf_buffer == NULL) return NULL;
+
+    dmabuf_buffer->fd = params->fds[0];
+    dmabuf_buffer->offset = params->offsets[0];
+    dmabuf_buffer->stride = params->strides[0];
+    dmabuf_buffer->width = width;
+    dmabuf_buffer->height = height;
+    dmabuf_buffer->format = format;
+    params->fds[0] = -1;
+    return dmabuf_buffer;
+}
+
+static void params_create_buffer(struct wl_client * client, struct wl_resource * resource, uint32_t buffer_id, int32_t width, int32_t height, uint32_t format, uint32_t flags) {
+    dmabuf_params_t * params = (dmabuf_params_t *)wl_resource_get_user_data(resource);
+
+    if (params->used) {
+        wl_resource_post_error(resource, ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_ALREADY_USED, "params were already used");
+        return;
+    }
+
+    params->used = true;
+    dmabuf_buffer_t * dmabuf_buffer = params_import(params, width, height, format);
+    if (dmabuf_buffer == NULL && buffer_id == 0) {
+        zwp_linux_buffer_params_v1_send_failed(resource);
+        return;
+    }
+
+    // immediately created buffers exist even if the import failed, they just can't be used
+    struct wl_resource * buffer = wl_resource_create(client, &wl_buffer_interface, 1, buffer_id);
+    if (buffer == NULL) {
+        if (dmabuf_buffer != NULL) close(dmabuf_buffer->fd);
+        free(dmabuf_buffer);
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(buffer, &dmabuf_buffer_impl, dmabuf_buffer, on_dmabuf_buffer_destroy);
+    if (dmabuf_buffer == NULL) {
+        zwp_linux_buffer_params_v1_send_failed(resource);
+    } else if (buffer_id == 0) {
+        zwp_linux_buffer_params_v1_send_created(resource, buffer);
+    }
+
+    (void)flags;
+}
+
+static void params_create(struct wl_client * client, struct wl_resource * resource, int32_t width, int32_t height, uint32_t format, uint32_t flags) {
+    params_create_buffer(client, resource, 0, width, height, format, flags);
+}
+
+static void params_create_immed(struct wl_client * client, struct wl_resource * resource, uint32_t buffer_id, int32_t width, int32_t height, uint32_t format, uint32_t flags) {
+    params_create_buffer(client, resource, buffer_id, width, height, format, flags);
+}
+
+static const struct zwp_linux_buffer_params_v1_interface params_impl = {
+    .destroy = params_destroy,
+    .add = params_add,
+    .create = params_create,
+    .create_immed = params_create_immed,
+};
+
+static void on_params_destroy(struct wl_resource * resource) {
+    dmabuf_params_t * params = (dmabuf_params_t *)wl_resource_get_user_data(resource);
+    for (size_t i = 0; i < DMABUF_MAX_PLANES; i++) {
+        if (params->fds[i] != -1) close(params->fds[i]);
+    }
+
+    free(params);
+}
+
+static void feedback_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static const struct zwp_linux_dmabuf_feedback_v1_interface feedback_impl = {
+    .destroy = feedback_destroy,
+};
+
+static void send_feedback(comp_t * comp, struct wl_resource * feedback) {
+    struct wl_array device;
+    wl_array_init(&device);
+    dev_t * device_id = wl_array_add(&device, sizeof (dev_t));
+    if (device_id != NULL) *device_id = comp->main_device;
+
+    // a single tranche with all formats of the format table
+    struct wl_array indices;
+    wl_array_init(&indices);
+    size_t num_formats = comp->format_table_size / 16;
+    for (size_t i = 0; i < num_formats; i++) {
+        uint16_t * index = wl_array_add(&indices, sizeof (uint16_t));
+        if (index != NULL) *index = i;
+    }
+
+    zwp_linux_dmabuf_feedback_v1_send_format_table(feedback, comp->format_table_fd, comp->format_table_size);
+    zwp_linux_dmabuf_feedback_v1_send_main_device(feedback, &device);
+    zwp_linux_dmabuf_feedback_v1_send_tranche_target_device(feedback, &device);
+    zwp_linux_dmabuf_feedback_v1_send_tranche_formats(feedback, &indices);
+    zwp_linux_dmabuf_feedback_v1_send_tranche_flags(feedback, 0);
+    zwp_linux_dmabuf_feedback_v1_send_tranche_done(feedback);
+    zwp_linux_dmabuf_feedback_v1_send_done(feedback);
+
+    wl_array_release(&device);
+    wl_array_release(&indices);
+}
+
+static void linux_dmabuf_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static void linux_dmabuf_create_params(struct wl_client * client, struct wl_resource * resource, uint32_t id) {
+    comp_t * comp = (comp_t *)wl_resource_get_user_data(resource);
+
+    dmabuf_params_t * params = malloc(sizeof (dmabuf_params_t));
+    struct wl_resource * params_resource = wl_resource_create(client, &zwp_linux_buffer_params_v1_interface, wl_resource_get_version(resource), id);
+    if (params == NULL || params_resource == NULL) {
+        free(params);
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    params->comp = comp;
+    for (size_t i = 0; i < DMABUF_MAX_PLANES; i++) {
+        params->fds[i] = -1;
+        params->offsets[i] = 0;
+        params->strides[i] = 0;
+        params->modifiers[i] = DRM_FORMAT_MOD_INVALID;
+    }
+    params->used = false;
+    wl_resource_set_implementation(params_resource, &params_impl, params, on_params_destroy);
+}
+
+static void linux_dmabuf_get_feedback(struct wl_client * client, struct wl_resource * resource, uint32_t id) {
+    comp_t * comp = (comp_t *)wl_resource_get_user_data(resource);
+
+    struct wl_resource * feedback = wl_resource_create(client, &zwp_linux_dmabuf_feedback_v1_interface, wl_resource_get_version(resource), id);
+    if (feedback == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(feedback, &feedback_impl, comp, NULL);
+    send_feedback(comp, feedback);
+}
+
+static void linux_dmabuf_get_surface_feedback(struct wl_client * client, struct wl_resource * resource, uint32_t id, struct wl_resource * surface) {
+    // all surfaces are on the same output
+    linux_dmabuf_get_feedback(client, resource, id);
+
+    (void)surface;
+}
+
+static const struct zwp_linux_dmabuf_v1_interface linux_dmabuf_impl = {
+    .destroy = linux_dmabuf_destroy,
+    .create_params = linux_dmabuf_create_params,
+    .get_default_feedback = linux_dmabuf_get_feedback,
+    .get_surface_feedback = linux_dmabuf_get_surface_feedback,
+};
+
+static void bind_linux_dmabuf(struct wl_client * client, void * data, uint32_t version, uint32_t id) {
+    struct wl_resource * resource = wl_resource_create(client, &zwp_linux_dmabuf_v1_interface, version, id);
+    if (resource == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    // version 4 clients get formats from the feedback only
+    wl_resource_set_implementation(resource, &linux_dmabuf_impl, data, NULL);
+}
+
+static bool create_format_table(comp_t * comp) {
+    struct {
+        uint32_t format;
+        uint32_t padding;
+        uint64_t modifier;
+    } table[] = {
+        { DRM_FORMAT_XRGB8888, 0, DRM_FORMAT_MOD_LINEAR },
+        { DRM_FORMAT_ARGB8888, 0, DRM_FORMAT_MOD_LINEAR },
+    };
+
+    comp->format_table_fd = memfd_create("wlm-test-format-table", MFD_CLOEXEC);
+    if (comp->format_table_fd == -1) return false;
+    if (write(comp->format_table_fd, table, sizeof table) != sizeof table) return false;
+
+    comp->format_table_size = sizeof table;
+    return true;
+}
+
+// --- zwlr_screencopy ---
+
+static void screencopy_frame_copy_common(struct wl_resource * resource, struct wl_resource * buffer, bool with_damage) {
+    screencopy_frame_t * frame = (screencopy_frame_t *)wl_resource_get_user_data(resource);
+    comp_t * comp = frame->comp;
+
+    if (frame->copy_requested) {
+        wl_resource_post_error(resource, ZWLR_SCREENCOPY_FRAME_V1_ERROR_ALREADY_USED, "frame was already copied");
+        return;
+    }
+
+    buffer_access_t access;
+    if (!buffer_begin_access(comp, buffer, false, &access)) {
+        wl_resource_post_error(resource, ZWLR_SCREENCOPY_FRAME_V1_ERROR_INVALID_BUFFER, "unsupported buffer type");
+        return;
+    }
+
+    bool valid = buffer_matches_output(comp, &access);
+    buffer_end_access(&access);
+    if (!valid) {
+        wl_resource_post_error(resource, ZWLR_SCREENCOPY_FRAME_V1_ERROR_INVALID_BUFFER, "buffer doesn't match the offered constraints");
+        return;
+    }
+
+    // copies happen on the next frame clock tick
+    frame->copy_requested = true;
+    frame->with_damage = with_damage;
+    buffer_ref_set(&frame->buffer, buffer);
+    wl_list_insert(comp->screencopy_frames.prev, &frame->link);
+}
+
+static void screencopy_frame_copy(struct wl_client * client, struct wl_resource * resource, struct wl_resource * buffer) {
+    screencopy_frame_copy_common(resource, buffer, false);
+
+    (void)client;
+}
+
+static void screencopy_frame_copy_with_damage(struct wl_client * client, struct wl_resource * resource, struct wl_resource * buffer) {
+    screencopy_frame_copy_common(resource, buffer, true);
+
+    (void)client;
+}
+
+static void screencopy_frame_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static const struct zwlr_screencopy_frame_v1_interface screencopy_frame_impl = {
+    .copy = screencopy_frame_copy,
+    .destroy = screencopy_frame_destroy,
+    .copy_with_damage = screencopy_frame_copy_with_damage,
+};
+
+static void on_screencopy_frame_destroy(struct wl_resource * resource) {
+    screencopy_frame_t * frame = (screencopy_frame_t *)wl_resource_get_user_data(resource);
+    wl_list_remove(&frame->link);
+    buffer_ref_set(&frame->buffer, NULL);
+    free(frame);
+}
+
+static void process_screencopy(comp_t * comp) {
+    screencopy_frame_t * frame;
+    screencopy_frame_t * tmp;
+    wl_list_for_each_safe(frame, tmp, &comp->screencopy_frames, link) {
+        // copies with damage wait for the screen to change
+        bool changed = !comp->screencopy_seen || comp->screencopy_serial != comp->serial;
+        if (frame->with_damage && !changed) continue;
+
+        wl_list_remove(&frame->link);
+        wl_list_init(&frame->link);
+
+        if (comp->opt.fail & PROTO_SCREENCOPY) {
+            zwlr_screencopy_frame_v1_send_failed(frame->resource);
+            continue;
+        }
+
+        // screencopy always copies the whole frame
+        rect_t damage = scene_damage_since(comp, comp->screencopy_serial, comp->screencopy_seen);
+        if (!capture_into(comp, frame->buffer.resource, full_rect(comp), "screencopy")) {
+            zwlr_screencopy_frame_v1_send_failed(frame->resource);
+            continue;
+        }
+
+        comp->screencopy_serial = comp->serial;
+        comp->screencopy_seen = true;
+
+        uint32_t sec_hi, sec_lo, nsec;
+        send_timestamp(&sec_hi, &sec_lo, &nsec);
+        zwlr_screencopy_frame_v1_send_flags(frame->resource, 0);
+        if (frame->with_damage) zwlr_screencopy_frame_v1_send_damage(frame->resource, damage.x, damage.y, damage.width, damage.height);
+        zwlr_screencopy_frame_v1_send_ready(frame->resource, sec_hi, sec_lo, nsec);
+    }
+}
+
+static void screencopy_manager_capture_output(struct wl_client * client, struct wl_resource * resource, uint32_t id, int32_t overlay_cursor, struct wl_resource * output) {
+    comp_t * comp = (comp_t *)wl_resource_get_user_data(resource);
+
+    uint32_t version = wl_resource_get_version(resource);
+    screencopy_frame_t * frame = malloc(sizeof (screencopy_frame_t));
+    struct wl_resource * frame_resource = wl_resource_create(client, &zwlr_screencopy_frame_v1_interface, version, id);
+    if (frame == NULL || frame_resource == NULL) {
+        free(frame);
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    frame->comp = comp;
+    frame->resource = frame_resource;
+    buffer_ref_init(&frame->buffer);
+    frame->with_damage = false;
+    frame->copy_requested = false;
+    wl_list_init(&frame->link);
+    wl_resource_set_implementation(frame_resource, &screencopy_frame_impl, frame, on_screencopy_frame_destroy);
+
+    if (!is_output(output)) {
+        zwlr_screencopy_frame_v1_send_failed(frame_resource);
+        return;
+    }
+
+    zwlr_screencopy_frame_v1_send_buffer(frame_resource, WL_SHM_FORMAT_XRGB8888, comp->opt.width, comp->opt.height, comp->opt.width * 4);
+    if (version >= ZWLR_SCREENCOPY_FRAME_V1_LINUX_DMABUF_SINCE_VERSION) {
+        if (!(comp->opt.omit & PROTO_LINUX_DMABUF)) {
+            zwlr_screencopy_frame_v1_send_linux_dmabuf(frame_resource, DRM_FORMAT_XRGB8888, comp->opt.width, comp->opt.height);
+        }
+        zwlr_screencopy_frame_v1_send_buffer_done(frame_resource);
+    }
+
+    (void)overlay_cursor;
+}
+
+static void screencopy_manager_capture_output_region(struct wl_client * client, struct wl_resource * resource, uint32_t id, int32_t overlay_cursor, struct wl_resource * output, int32_t x, int32_t y, int32_t width, int32_t height) {
+    wl_client_post_implementation_error(client, "screencopy regions are not supported by the test compositor");
+
+    (void)resource;
+    (void)id;
+    (void)overlay_cursor;
+    (void)output;
+    (void)x;
+    (void)y;
+    (void)width;
+    (void)height;
+}
+
+static void screencopy_manager_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static const struct zwlr_screencopy_manager_v1_interface screencopy_manager_impl = {
+    .capture_output = screencopy_manager_capture_output,
+    .capture_output_region = screencopy_manager_capture_output_region,
+    .destroy = screencopy_manager_destroy,
+};
+
+static void bind_screencopy_manager(struct wl_client * client, void * data, uint32_t version, uint32_t id) {
+    struct wl_resource * resource = wl_resource_create(client, &zwlr_screencopy_manager_v1_interface, version, id);
+    if (resource == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(resource, &screencopy_manager_impl, data, NULL);
+}
+
+// --- zwlr_export_dmabuf ---
+
+static void export_frame_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static const struct zwlr_export_dmabuf_frame_v1_interface export_frame_impl = {
+    .destroy = export_frame_destroy,
+};
+
+static void on_export_frame_destroy(struct wl_resource * resource) {
+    export_frame_t * frame = (export_frame_t *)wl_resource_get_user_data(resource);
+    wl_list_remove(&frame->link);
+    free(frame);
+}
+
+static int dma_heap_alloc(comp_t * comp, size_t size) {
+    struct dma_heap_allocation_data data = {
+        .len = size,
+        .fd = 0,
+        .fd_flags = O_RDWR | O_CLOEXEC,
+        .heap_flags = 0,
+    };
+
+    if (ioctl(comp->dma_heap_fd, DMA_HEAP_IOCTL_ALLOC, &data) == -1) return -1;
+    return data.fd;
+}
+
+static void process_export(comp_t * comp) {
+    export_frame_t * frame;
+    export_frame_t * tmp;
+    wl_list_for_each_safe(frame, tmp, &comp->export_frames, link) {
+        wl_list_remove(&frame->link);
+        wl_list_init(&frame->link);
+
+        // every frame gets a new buffer, the client owns it until it destroys the frame
+        uint32_t stride = comp->opt.width * 4;
+        size_t size = (size_t)stride * comp->opt.height;
+        int fd = dma_heap_alloc(comp, size);
+        void * map = fd == -1 ? MAP_FAILED : mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            wlm_log_error("test-compositor::process_export(): failed to allocate DMA-BUF\n");
+            if (fd != -1) close(fd);
+            zwlr_export_dmabuf_frame_v1_send_cancel(frame->resource, ZWLR_EXPORT_DMABUF_FRAME_V1_CANCEL_REASON_TEMPORARY);
+            continue;
+        }
+
+        dmabuf_sync(fd, true, DMA_BUF_SYNC_START);
+        memcpy(map, comp->pixels, size);
+        dmabuf_sync(fd, true, DMA_BUF_SYNC_END);
+        munmap(map, size);
+
+        uint32_t sec_hi, sec_lo, nsec;
+        send_timestamp(&sec_hi, &sec_lo, &nsec);
+        zwlr_export_dmabuf_frame_v1_send_frame(frame->resource, comp->opt.width, comp->opt.height, 0, 0, 0, 0,
+            DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_LINEAR >> 32, DRM_FORMAT_MOD_LINEAR & 0xffffffff, 1);
+        zwlr_export_dmabuf_frame_v1_send_object(frame->resource, 0, fd, size, 0, stride, 0);
+        zwlr_export_dmabuf_frame_v1_send_ready(frame->resource, sec_hi, sec_lo, nsec);
+
+        // the event holds a duplicate of the fd
+        close(fd);
+        snprintf(comp->backend, sizeof comp->backend, "export-dmabuf");
+        comp->stats.captures++;
+    }
+}
+
+static void export_manager_capture_output(struct wl_client * client, struct wl_resource * resource, uint32_t id, int32_t overlay_cursor, struct wl_resource * output) {
+    comp_t * comp = (comp_t *)wl_resource_get_user_data(resource);
+
+    export_frame_t * frame = malloc(sizeof (export_frame_t));
+    struct wl_resource * frame_resource = wl_resource_create(client, &zwlr_export_dmabuf_frame_v1_interface, wl_resource_get_version(resource), id);
+    if (frame == NULL || frame_resource == NULL) {
+        free(frame);
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    frame->comp = comp;
+    frame->resource = frame_resource;
+    wl_list_init(&frame->link);
+    wl_resource_set_implementation(frame_resource, &export_frame_impl, frame, on_export_frame_destroy);
+
+    if ((comp->opt.fail & PROTO_EXPORT_DMABUF) || comp->dma_heap_fd == -1 || !is_output(output)) {
+        zwlr_export_dmabuf_frame_v1_send_cancel(frame_resource, ZWLR_EXPORT_DMABUF_FRAME_V1_CANCEL_REASON_PERMANENT);
+        return;
+    }
+
+    // exported on the next frame clock tick
+    wl_list_insert(comp->export_frames.prev, &frame->link);
+
+    (void)overlay_cursor;
+}
+
+static void export_manager_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static const struct zwlr_export_dmabuf_manager_v1_interface export_manager_impl = {
+    .capture_output = export_manager_capture_output,
+    .destroy = export_manager_destroy,
+};
+
+static void bind_export_manager(struct wl_client * client, void * data, uint32_t version, uint32_t id) {
+    struct wl_resource * resource = wl_resource_create(client, &zwlr_export_dmabuf_manager_v1_interface, version, id);
+    if (resource == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(resource, &export_manager_impl, data, NULL);
+}
+
+// --- ext_image_capture_source ---
+
+static void source_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static const struct ext_image_capture_source_v1_interface source_impl = {
+    .destroy = source_destroy,
+};
+
+static void source_manager_create_source(struct wl_client * client, struct wl_resource * resource, uint32_t id, struct wl_resource * output) {
+    struct wl_resource * source = wl_resource_create(client, &ext_image_capture_source_v1_interface, 1, id);
+    if (source == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    // sources of unknown outputs fail their captures
+    wl_resource_set_implementation(source, &source_impl, is_output(output) ? wl_resource_get_user_data(resource) : NULL, NULL);
+}
+
+static void source_manager_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static const struct ext_output_image_capture_source_manager_v1_interface source_manager_impl = {
+    .create_source = source_manager_create_source,
+    .destroy = source_manager_destroy,
+};
+
+static void bind_source_manager(struct wl_client * client, void * data, uint32_t version, uint32_t id) {
+    struct wl_resource * resource = wl_resource_create(client, &ext_output_image_capture_source_manager_v1_interface, version, id);
+    if (resource == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(resource, &source_manager_impl, data, NULL);
+}
+
+// --- ext_image_copy_capture ---
+
+static void extcopy_frame_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static void extcopy_frame_attach_buffer(struct wl_client * client, struct wl_resource * resource, struct wl_resource * buffer) {
+    extcopy_frame_t * frame = (extcopy_frame_t *)wl_resource_get_user_data(resource);
+    if (frame->capture_requested) {
+        wl_resource_post_error(resource, EXT_IMAGE_COPY_CAPTURE_FRAME_V1_ERROR_ALREADY_CAPTURED, "frame was already captured");
+        return;
+    }
+
+    buffer_ref_set(&frame->buffer, buffer);
+
+    (void)client;
+}
+
+static void extcopy_frame_damage_buffer(struct wl_client * client, struct wl_resource * resource, int32_t x, int32_t y, int32_t width, int32_t height) {
+    extcopy_frame_t * frame = (extcopy_frame_t *)wl_resource_get_user_data(resource);
+    if (frame->capture_requested) {
+        wl_resource_post_error(resource, EXT_IMAGE_COPY_CAPTURE_FRAME_V1_ERROR_ALREADY_CAPTURED, "frame was already captured");
+        return;
+    } else if (x < 0 || y < 0 || width <= 0 || height <= 0) {
+        wl_resource_post_error(resource, EXT_IMAGE_COPY_CAPTURE_FRAME_V1_ERROR_INVALID_BUFFER_DAMAGE, "invalid buffer damage");
+        return;
+    }
+
+    frame->damage = rect_union(frame->damage, (rect_t){ x, y, width, height });
+
+    (void)client;
+}
+
+static void extcopy_frame_capture(struct wl_client * client, struct wl_resource * resource) {
+    extcopy_frame_t * frame = (extcopy_frame_t *)wl_resource_get_user_data(resource);
+    comp_t * comp = frame->comp;
+
+    if (frame->capture_requested) {
+        wl_resource_post_error(resource, EXT_IMAGE_COPY_CAPTURE_FRAME_V1_ERROR_ALREADY_CAPTURED, "frame was already captured");
+        return;
+    } else if (frame->buffer.resource == NULL) {
+        wl_resource_post_error(resource, EXT_IMAGE_COPY_CAPTURE_FRAME_V1_ERROR_NO_BUFFER, "no buffer attached");
+        return;
+    }
+
+    frame->capture_requested = true;
+    if (frame->session == NULL) {
+        ext_image_copy_capture_frame_v1_send_failed(resource, EXT_IMAGE_COPY_CAPTURE_FRAME_V1_FAILURE_REASON_STOPPED);
+        return;
+    }
+
+    // captured on a frame clock tick once there is something new to copy
+    wl_list_insert(comp->extcopy_frames.prev, &frame->link);
+
+    (void)client;
+}
+
+static const struct ext_image_copy_capture_frame_v1_interface extcopy_frame_impl = {
+    .destroy = extcopy_frame_destroy,
+    .attach_buffer = extcopy_frame_attach_buffer,
+    .damage_buffer = extcopy_frame_damage_buffer,
+    .capture = extcopy_frame_capture,
+};
+
+static void on_extcopy_frame_destroy(struct wl_resource * resource) {
+    extcopy_frame_t * frame = (extcopy_frame_t *)wl_resource_get_user_data(resource);
+    if (frame->session != NULL) frame->session->frame = NULL;
+    wl_list_remove(&frame->link);
+    buffer_ref_set(&frame->buffer, NULL);
+    free(frame);
+}
+
+static void process_extcopy(comp_t * comp) {
+    extcopy_frame_t * frame;
+    extcopy_frame_t * tmp;
+    wl_list_for_each_safe(frame, tmp, &comp->extcopy_frames, link) {
+        extcopy_session_t * session = frame->session;
+
+        // after the first frame of a session, captures wait for the screen to change
+        if (session->seen && session->serial == comp->serial) continue;
+
+        wl_list_remove(&frame->link);
+        wl_list_init(&frame->link);
+
+        if (comp->opt.fail & PROTO_EXTCOPY) {
+            ext_image_copy_capture_frame_v1_send_failed(frame->resource, EXT_IMAGE_COPY_CAPTURE_FRAME_V1_FAILURE_REASON_UNKNOWN);
+            continue;
+        }
+
+        // only copy what the client damaged and what changed since the previous frame of the session
+        rect_t scene_damage = scene_damage_since(comp, session->serial, session->seen);
+        if (!capture_into(comp, frame->buffer.resource, rect_union(frame->damage, scene_damage), "extcopy")) {
+            ext_image_copy_capture_frame_v1_send_failed(frame->resource, EXT_IMAGE_COPY_CAPTURE_FRAME_V1_FAILURE_REASON_BUFFER_CONSTRAINTS);
+            continue;
+        }
+
+        session->serial = comp->serial;
+        session->seen = true;
+
+        uint32_t sec_hi, sec_lo, nsec;
+        send_timestamp(&sec_hi, &sec_lo, &nsec);
+        ext_image_copy_capture_frame_v1_send_transform(frame->resource, WL_OUTPUT_TRANSFORM_NORMAL);
+        ext_image_copy_capture_frame_v1_send_damage(frame->resource, scene_damage.x, scene_damage.y, scene_damage.width, scene_damage.height);
+        ext_image_copy_capture_frame_v1_send_presentation_time(frame->resource, sec_hi, sec_lo, nsec);
+        ext_image_copy_capture_frame_v1_send_ready(frame->resource);
+    }
+}
+
+static void extcopy_session_create_frame(struct wl_client * client, struct wl_resource * resource, uint32_t id) {
+    extcopy_session_t * session = (extcopy_session_t *)wl_resource_get_user_data(resource);
+
+    if (session->frame != NULL) {
+        wl_resource_post_error(resource, EXT_IMAGE_COPY_CAPTURE_SESSION_V1_ERROR_DUPLICATE_FRAME, "session already has a frame");
+        return;
+    }
+
+    extcopy_frame_t * frame = malloc(sizeof (extcopy_frame_t));
+    struct wl_resource * frame_resource = wl_resource_create(client, &ext_image_copy_capture_frame_v1_interface, wl_resource_get_version(resource), id);
+    if (frame == NULL || frame_resource == NULL) {
+        free(frame);
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    frame->comp = session->comp;
+    frame->resource = frame_resource;
+    frame->session = session;
+    buffer_ref_init(&frame->buffer);
+    frame->damage = (rect_t){ 0, 0, 0, 0 };
+    frame->capture_requested = false;
+    wl_list_init(&frame->link);
+    wl_resource_set_implementation(frame_resource, &extcopy_frame_impl, frame, on_extcopy_frame_destroy);
+    session->frame = frame;
+}
+
+static void extcopy_session_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static const struct ext_image_copy_capture_session_v1_interface extcopy_session_impl = {
+    .create_frame = extcopy_session_create_frame,
+    .destroy = extcopy_session_destroy,
+};
+
+static void on_extcopy_session_destroy(struct wl_resource * resource) {
+    extcopy_session_t * session = (extcopy_session_t *)wl_resource_get_user_data(resource);
+
+    extcopy_frame_t * frame = session->frame;
+    if (frame != NULL) {
+        if (!wl_list_empty(&frame->link)) {
+            wl_list_remove(&frame->link);
+            wl_list_init(&frame->link);
+            ext_image_copy_capture_frame_v1_send_failed(frame->resource, EXT_IMAGE_COPY_CAPTURE_FRAME_V1_FAILURE_REASON_STOPPED);
+        }
+        frame->session = NULL;
+    }
+
+    free(session);
+}
+
+static void extcopy_manager_create_session(struct wl_client * client, struct wl_resource * resource, uint32_t id, struct wl_resource * source, uint32_t options) {
+    comp_t * comp = (comp_t *)wl_resource_get_user_data(resource);
+
+    extcopy_session_t * session = malloc(sizeof (extcopy_session_t));
+    struct wl_resource * session_resource = wl_resource_create(client, &ext_image_copy_capture_session_v1_interface, wl_resource_get_version(resource), id);
+    if (session == NULL || session_resource == NULL) {
+        free(session);
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    session->comp = comp;
+    session->resource = session_resource;
+    session->frame = NULL;
+    session->serial = 0;
+    session->seen = false;
+    wl_resource_set_implementation(session_resource, &extcopy_session_impl, session, on_extcopy_session_destroy);
+
+    if (wl_resource_get_user_data(source) == NULL) {
+        ext_image_copy_capture_session_v1_send_stopped(session_resource);
+        return;
+    }
+
+    // buffer constraints
+    ext_image_copy_capture_session_v1_send_buffer_size(session_resource, comp->opt.width, comp->opt.height);
+    ext_image_copy_capture_session_v1_send_shm_format(session_resource, WL_SHM_FORMAT_XRGB8888);
+    if (!(comp->opt.omit & PROTO_LINUX_DMABUF)) {
+        struct wl_array device;
+        wl_array_init(&device);
+        dev_t * device_id = wl_array_add(&device, sizeof (dev_t));
+        if (device_id != NULL) *device_id = comp->main_device;
+
+        struct wl_array modifiers;
+        wl_array_init(&modifiers);
+        uint64_t * modifier = wl_array_add(&modifiers, sizeof (uint64_t));
+        if (modifier != NULL) *modifier = DRM_FORMAT_MOD_LINEAR;
+
+        ext_image_copy_capture_session_v1_send_dmabuf_device(session_resource, &device);
+        ext_image_copy_capture_session_v1_send_dmabuf_format(session_resource, DRM_FORMAT_XRGB8888, &modifiers);
+        wl_array_release(&device);
+        wl_array_release(&modifiers);
+    }
+    ext_image_copy_capture_session_v1_send_done(session_resource);
+
+    (void)options;
+}
+
+static void extcopy_manager_create_pointer_cursor_session(struct wl_client * client, struct wl_resource * resource, uint32_t id, struct wl_resource * source, struct wl_resource * pointer) {
+    wl_client_post_implementation_error(client, "cursor sessions are not supported by the test compositor");
+
+    (void)resource;
+    (void)id;
+    (void)source;
+    (void)pointer;
+}
+
+static void extcopy_manager_destroy(struct wl_client * client, struct wl_resource * resource) {
+    wl_resource_destroy(resource);
+
+    (void)client;
+}
+
+static const struct ext_image_copy_capture_manager_v1_interface extcopy_manager_impl = {
+    .create_session = extcopy_manager_create_session,
+    .create_pointer_cursor_session = extcopy_manager_create_pointer_cursor_session,
+    .destroy = extcopy_manager_destroy,
+};
+
+static void bind_extcopy_manager(struct wl_client * client, void * data, uint32_t version, uint32_t id) {
+    struct wl_resource * resource = wl_resource_create(client, &ext_image_copy_capture_manager_v1_interface, version, id);
+    if (resource == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(resource, &extcopy_manager_impl, data, NULL);
+}
+
+// --- event handlers ---
+
+static int on_frame_timer(int fd, uint32_t mask, void * data) {
+    comp_t * comp = (comp_t *)data;
+
+    // missed ticks are dropped, like a compositor that skips a refresh cycle
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof expirations) != sizeof expirations) return 0;
+
+    comp->ticks++;
+    if (comp->opt.change_every > 0 && comp->ticks % comp->opt.change_every == 0) scene_advance(comp);
+
+    process_screencopy(comp);
+    process_extcopy(comp);
+    process_export(comp);
+
+    uint32_t time_ms = now_ns() / 1000000;
+    struct wl_resource * callback;
+    struct wl_resource * tmp;
+    wl_resource_for_each_safe(callback, tmp, &comp->frame_callbacks) {
+        wl_callback_send_done(callback, time_ms);
+        wl_resource_destroy(callback);
+    }
+
+    (void)mask;
+    return 0;
+}
+
+static int on_timeout(void * data) {
+    comp_t * comp = (comp_t *)data;
+
+    wlm_log_error("test-compositor::on_timeout(): client did not finish within %" PRIu64 " s\n", comp->opt.timeout_s);
+    comp->timed_out = true;
+    comp->running = false;
+    return 0;
+}
+
+static int on_sigchld(int signal_number, void * data) {
+    comp_t * comp = (comp_t *)data;
+
+    int status;
+    if (waitpid(comp->child, &status, WNOHANG) != comp->child) return 0;
+
+    wlm_log_debug(comp, "test-compositor::on_sigchld(): client exited\n");
+    comp->child_status = status;
+    comp->child_exited = true;
+    comp->running = false;
+
+    (void)signal_number;
+    return 0;
+}
+
+static void on_client_destroy(struct wl_listener * listener, void * data) {
+    comp_t * comp = wl_container_of(listener, comp, client_destroy);
+    comp->client = NULL;
+
+    (void)data;
+}
+
+static void on_protocol_message(void * data, enum wl_protocol_logger_type direction, const struct wl_protocol_logger_message * message) {
+    comp_t * comp = (comp_t *)data;
+    if (direction != WL_PROTOCOL_LOGGER_REQUEST) return;
+
+    comp->stats.requests++;
+    if (strcmp(message->message->name, "sync") == 0 && strcmp(wl_resource_get_class(message->resource), "wl_display") == 0) {
+        comp->stats.roundtrips++;
+    }
+}
+
+// --- setup ---
+
+static bool init_server(comp_t * comp) {
+    comp->display = wl_display_create();
+    if (comp->display == NULL) {
+        wlm_log_error("test-compositor::init_server(): failed to create display\n");
+        return false;
+    }
+
+    comp->loop = wl_display_get_event_loop(comp->display);
+    comp->logger = wl_display_add_protocol_logger(comp->display, on_protocol_message, comp);
+    if (wl_display_init_shm(comp->display) != 0) {
+        wlm_log_error("test-compositor::init_server(): failed to initialize wl_shm\n");
+        return false;
+    }
+
+    // wl-mirror expects the output manager before the outputs
+    bool success = true;
+    success &= wl_global_create(comp->display, &wl_compositor_interface, 4, comp, bind_compositor) != NULL;
+    success &= wl_global_create(comp->display, &xdg_wm_base_interface, 2, comp, bind_wm_base) != NULL;
+    success &= wl_global_create(comp->display, &wp_viewporter_interface, 1, comp, bind_viewporter) != NULL;
+    success &= wl_global_create(comp->display, &zxdg_output_manager_v1_interface, 2, comp, bind_xdg_output_manager) != NULL;
+    if (!(comp->opt.omit & PROTO_LINUX_DMABUF)) {
+        success &= wl_global_create(comp->display, &zwp_linux_dmabuf_v1_interface, 4, comp, bind_linux_dmabuf) != NULL;
+    }
+    if (!(comp->opt.omit & PROTO_SCREENCOPY)) {
+        success &= wl_global_create(comp->display, &zwlr_screencopy_manager_v1_interface, 3, comp, bind_screencopy_manager) != NULL;
+    }
+    if (!(comp->opt.omit & PROTO_EXPORT_DMABUF)) {
+        success &= wl_global_create(comp->display, &zwlr_export_dmabuf_manager_v1_interface, 1, comp, bind_export_manager) != NULL;
+    }
+    if (!(comp->opt.omit & PROTO_EXTCOPY)) {
+        success &= wl_global_create(comp->display, &ext_image_copy_capture_manager_v1_interface, 1, comp, bind_extcopy_manager) != NULL;
+        success &= wl_global_create(comp->display, &ext_output_image_capture_source_manager_v1_interface, 1, comp, bind_source_manager) != NULL;
+    }
+    success &= wl_global_create(comp->display, &wl_output_interface, 3, comp, bind_output) != NULL;
+    if (!success) {
+        wlm_log_error("test-compositor::init_server(): failed to create globals\n");
+        return false;
+    }
+
+    // DMA-BUF support is optional, tests that need it are skipped without it
+    struct stat render_node;
+    comp->main_device = stat("/dev/dri/renderD128", &render_node) == 0 ? render_node.st_rdev : 0;
+    comp->dma_heap_fd = open("/dev/dma_heap/system", O_RDONLY | O_CLOEXEC);
+    if (!create_format_table(comp)) {
+        wlm_log_error("test-compositor::init_server(): failed to create DMA-BUF format table\n");
+        return false;
+    }
+
+    // frame clock
+    comp->frame_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    uint64_t period_ns = 1000000000ull / comp->opt.refresh_hz;
+    struct itimerspec period = {
+        .it_interval = { .tv_sec = period_ns / 1000000000, .tv_nsec = period_ns % 1000000000 },
+        .it_value = { .tv_sec = period_ns / 1000000000, .tv_nsec = period_ns % 1000000000 },
+    };
+    if (comp->frame_timer_fd == -1 || timerfd_settime(comp->frame_timer_fd, 0, &period, NULL) == -1) {
+        wlm_log_error("test-compositor::init_server(): failed to create frame timer\n");
+        return false;
+    }
+
+    comp->frame_timer = wl_event_loop_add_fd(comp->loop, comp->frame_timer_fd, WL_EVENT_READABLE, on_frame_timer, comp);
+    comp->timeout_timer = wl_event_loop_add_timer(comp->loop, on_timeout, comp);
+    comp->sigchld = wl_event_loop_add_signal(comp->loop, SIGCHLD, on_sigchld, comp);
+    if (comp->frame_timer == NULL || comp->timeout_timer == NULL || comp->sigchld == NULL) {
+        wlm_log_error("test-compositor::init_server(): failed to register event sources\n");
+        return false;
+    }
+
+    wl_event_source_timer_update(comp->timeout_timer, comp->opt.timeout_s * 1000);
+    return true;
+}
+
+static bool spawn_client(comp_t * comp) {
+    // keep the backend cache of the client under test out of the user's cache
+    const char * tmpdir = getenv("TMPDIR");
+    snprintf(comp->cache_dir, sizeof comp->cache_dir, "%s/wlm-test-XXXXXX", tmpdir != NULL && strlen(tmpdir) < 40 ? tmpdir : "/tmp");
+    if (mkdtemp(comp->cache_dir) == NULL) {
+        wlm_log_error("test-compositor::spawn_client(): failed to create cache directory\n");
+        comp->cache_dir[0] = '\0';
+        return false;
+    }
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == -1) {
+        wlm_log_error("test-compositor::spawn_client(): failed to create socket pair\n");
+        return false;
+    }
+
+    comp->client = wl_client_create(comp->display, fds[0]);
+    if (comp->client == NULL) {
+        wlm_log_error("test-compositor::spawn_client(): failed to create client\n");
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    comp->client_destroy.notify = on_client_destroy;
+    wl_client_add_destroy_listener(comp->client, &comp->client_destroy);
+
+    comp->child = fork();
+    if (comp->child == -1) {
+        wlm_log_error("test-compositor::spawn_client(): failed to fork\n");
+        close(fds[1]);
+        return false;
+    } else if (comp->child == 0) {
+        // the signal source blocks SIGCHLD, the client shouldn't inherit that
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigprocmask(SIG_SETMASK, &mask, NULL);
+
+        // the duplicate doesn't have close-on-exec set
+        char socket_fd[16];
+        snprintf(socket_fd, sizeof socket_fd, "%d", dup(fds[1]));
+        setenv("WAYLAND_SOCKET", socket_fd, 1);
+        unsetenv("WAYLAND_DISPLAY");
+        setenv("XDG_CACHE_HOME", comp->cache_dir, 1);
+
+        execvp(comp->opt.command[0], comp->opt.command);
+        wlm_log_error("test-compositor::spawn_client(): failed to execute %s\n", comp->opt.command[0]);
+        _exit(127);
+    }
+
+    close(fds[1]);
+    return true;
+}
+
+static int remove_entry(const char * path, const struct stat * st, int type, struct FTW * ftw) {
+    (void)st;
+    (void)type;
+    (void)ftw;
+    return remove(path);
+}
+
+static void cleanup(comp_t * comp) {
+    if (comp->child > 0 && !comp->child_exited) {
+        kill(comp->child, SIGKILL);
+        waitpid(comp->child, NULL, 0);
+    }
+
+    if (comp->display != NULL) {
+        wl_display_destroy_clients(comp->display);
+        if (comp->logger != NULL) wl_protocol_logger_destroy(comp->logger);
+        wl_display_destroy(comp->display);
+    }
+
+    if (comp->frame_timer_fd != -1) close(comp->frame_timer_fd);
+    if (comp->format_table_fd != -1) close(comp->format_table_fd);
+    if (comp->dma_heap_fd != -1) close(comp->dma_heap_fd);
+    if (comp->cache_dir[0] != '\0') nftw(comp->cache_dir, remove_entry, 8, FTW_DEPTH | FTW_PHYS);
+    free(comp->pixels);
+}
+
+// --- results ---
+
+static bool check_results(comp_t * comp) {
+    stats_t * stats = &comp->stats;
+    bool exited_cleanly = comp->child_exited && WIFEXITED(comp->child_status) && WEXITSTATUS(comp->child_status) == 0;
+
+    printf("backend:              %s\n", comp->backend[0] != '\0' ? comp->backend : "none");
+    printf("scene changes:        %" PRIu64 "\n", stats->scene_changes);
+    printf("captures:             %" PRIu64 " (%" PRIu64 " stale)\n", stats->captures, stats->stale_captures);
+    printf("window commits:       %" PRIu64 " (%" PRIu64 " unverified, %" PRIu64 " mismatched, %" PRIu64 " backwards)\n",
+        stats->commits, stats->unverified_commits, stats->mismatched_commits, stats->backwards_commits);
+    printf("delivered frames:     %" PRIu64 "\n", stats->delivered_frames);
+    if (stats->measured) {
+        printf("frames/s:             %.1f\n", stats->fps);
+        printf("captures/frame:       %.2f\n", stats->captures_per_frame);
+        printf("requests/frame:       %.2f\n", stats->requests_per_frame);
+        printf("roundtrips/frame:     %.2f\n", stats->roundtrips_per_frame);
+        printf("latency:              %.2f frames\n", stats->latency_per_frame);
+    }
+
+    bool success = comp->failures == 0 && !comp->timed_out;
+    if (comp->opt.expect_failure) {
+        if (comp->child_exited && WIFEXITED(comp->child_status) && WEXITSTATUS(comp->child_status) != 0) return success;
+
+        wlm_log_error("test-compositor::check_results(): client was expected to fail\n");
+        return false;
+    }
+
+    if (!exited_cleanly) {
+        wlm_log_error("test-compositor::check_results(): client did not exit cleanly\n");
+        success = false;
+    }
+
+    if (!stats->measured) {
+        wlm_log_error("test-compositor::check_results(): client delivered %" PRIu64 " of %" PRIu64 " frames\n",
+            stats->delivered_frames, comp->opt.warmup_frames + comp->opt.frames);
+        success = false;
+    }
+
+    if (comp->opt.expect_backend != NULL && strcmp(comp->backend, comp->opt.expect_backend) != 0) {
+        wlm_log_error("test-compositor::check_results(): expected backend %s, got %s\n", comp->opt.expect_backend, comp->backend);
+        success = false;
+    }
+
+    return success;
+}
+
+// --- main ---
+
+static void usage(void) {
+    printf("usage: wlm-test-compositor [options] -- command [args...]\n");
+    printf("\n");
+    printf("run a Wayland client against a headless compositor with one output named %s,\n", OUTPUT_NAME);
+    printf("check that its window shows the captured scene, and report frame rate and protocol traffic\n");
+    printf("\n");
+    printf("options:\n");
+    printf("  -h,   --help               show this help\n");
+    printf("  -v,   --verbose            enable debug logging\n");
+    printf("  -s WxH, --size WxH         output size, multiples of %d (default %dx%d)\n", SCENE_CELL_SIZE, DEFAULT_WIDTH, DEFAULT_HEIGHT);
+    printf("  -r HZ, --refresh HZ        output refresh rate (default %d)\n", DEFAULT_REFRESH_HZ);
+    printf("  -n N, --frames N           measure N frames after warmup, then close the window (default %d)\n", DEFAULT_FRAMES);
+    printf("  -w N, --warmup N           frames delivered before measuring (default %d)\n", DEFAULT_WARMUP_FRAMES);
+    printf("  -c N, --change-every N     change the scene every N refresh cycles, 0 for a static scene (default 1)\n");
+    printf("  -t S, --timeout S          fail if the client hasn't finished after S seconds (default %d)\n", DEFAULT_TIMEOUT_S);
+    printf("        --damage exact|full  damage reported for scene changes (default exact)\n");
+    printf("        --fail PROTO         fail all captures or imports of a protocol\n");
+    printf("        --omit PROTO         don't advertise a protocol\n");
+    printf("        --expect-backend B   fail unless the last capture was done with backend B\n");
+    printf("        --expect-failure     expect the client to exit with an error\n");
+    printf("        --require-dmabuf     skip the test if DMA-BUFs can't be allocated\n");
+    printf("\n");
+    printf("protocols: screencopy, extcopy, export-dmabuf, linux-dmabuf\n");
+}
+
+static bool parse_count(int argc, char ** argv, uint64_t * value, bool allow_zero) {
+    char * end = NULL;
+    unsigned long long count = argc < 2 ? 0 : strtoull(argv[1], &end, 10);
+    if (argc < 2 || *end != '\0' || (count == 0 && !allow_zero)) {
+        wlm_log_error("test-compositor::main(): option %s requires a %s number\n", argv[0], allow_zero ? "non-negative" : "positive");
+        return false;
+    }
+
+    *value = count;
+    return true;
+}
+
+static bool parse_proto(int argc, char ** argv, uint32_t * protos) {
+    for (const proto_name_t * proto = proto_names; argc >= 2 && proto->name != NULL; proto++) {
+        if (strcmp(argv[1], proto->name) != 0) continue;
+
+        *protos |= proto->proto;
+        return true;
+    }
+
+    wlm_log_error("test-compositor::main(): option %s requires a protocol name\n", argv[0]);
+    return false;
+}
+
+int main(int argc, char ** argv) {
+    comp_t comp = { 0 };
+    comp.opt.width = DEFAULT_WIDTH;
+    comp.opt.height = DEFAULT_HEIGHT;
+    comp.opt.refresh_hz = DEFAULT_REFRESH_HZ;
+    comp.opt.frames = DEFAULT_FRAMES;
+    comp.opt.warmup_frames = DEFAULT_WARMUP_FRAMES;
+    comp.opt.timeout_s = DEFAULT_TIMEOUT_S;
+    comp.opt.change_every = 1;
+    comp.frame_timer_fd = -1;
+    comp.format_table_fd = -1;
+    comp.dma_heap_fd = -1;
+    wl_list_init(&comp.output_resources);
+    wl_list_init(&comp.frame_callbacks);
+    wl_list_init(&comp.screencopy_frames);
+    wl_list_init(&comp.extcopy_frames);
+    wl_list_init(&comp.export_frames);
+
+    // skip program name
+    argv++;
+    argc--;
+
+    uint64_t value = 0;
+    while (argc > 0 && argv[0][0] == '-') {
+        if (strcmp(argv[0], "--") == 0) {
+            argv++;
+            argc--;
+            break;
+        } else if (strcmp(argv[0], "-h") == 0 || strcmp(argv[0], "--help") == 0) {
+            usage();
+            return 0;
+        } else if (strcmp(argv[0], "-v") == 0 || strcmp(argv[0], "--verbose") == 0) {
+            comp.opt.verbose = true;
+            argv--;
+            argc++;
+        } else if (strcmp(argv[0], "-s") == 0 || strcmp(argv[0], "--size") == 0) {
+            unsigned int width = 0;
+            unsigned int height = 0;
+            char end = '\0';
+            if (
+                argc < 2 || sscanf(argv[1], "%ux%u%c", &width, &height, &end) != 2 ||
+                width < SCENE_SQUARE_SIZE || height < SCENE_SQUARE_SIZE ||
+                width % SCENE_CELL_SIZE != 0 || height % SCENE_CELL_SIZE != 0
+            ) {
+                wlm_log_error("test-compositor::main(): option %s requires a size in multiples of %d\n", argv[0], SCENE_CELL_SIZE);
+                return 1;
+            }
+
+            comp.opt.width = width;
+            comp.opt.height = height;
+        } else if (strcmp(argv[0], "-r") == 0 || strcmp(argv[0], "--refresh") == 0) {
+            if (!parse_count(argc, argv, &value, false)) return 1;
+            comp.opt.refresh_hz = value;
+        } else if (strcmp(argv[0], "-n") == 0 || strcmp(argv[0], "--frames") == 0) {
+            if (!parse_count(argc, argv, &comp.opt.frames, false)) return 1;
+        } else if (strcmp(argv[0], "-w") == 0 || strcmp(argv[0], "--warmup") == 0) {
+            if (!parse_count(argc, argv, &comp.opt.warmup_frames, false)) return 1;
+        } else if (strcmp(argv[0], "-c") == 0 || strcmp(argv[0], "--change-every") == 0) {
+            if (!parse_count(argc, argv, &comp.opt.change_every, true)) return 1;
+        } else if (strcmp(argv[0], "-t") == 0 || strcmp(argv[0], "--timeout") == 0) {
+            if (!parse_count(argc, argv, &comp.opt.timeout_s, false)) return 1;
+        } else if (strcmp(argv[0], "--damage") == 0) {
+            if (argc < 2 || (strcmp(argv[1], "exact") != 0 && strcmp(argv[1], "full") != 0)) {
+                wlm_log_error("test-compositor::main(): option %s requires exact or full\n", argv[0]);
+                return 1;
+            }
+
+            comp.opt.full_damage = strcmp(argv[1], "full") == 0;
+        } else if (strcmp(argv[0], "--fail") == 0) {
+            if (!parse_proto(argc, argv, &comp.opt.fail)) return 1;
+        } else if (strcmp(argv[0], "--omit") == 0) {
+            if (!parse_proto(argc, argv, &comp.opt.omit)) return 1;
+        } else if (strcmp(argv[0], "--expect-backend") == 0) {
+            if (argc < 2) {
+                wlm_log_error("test-compositor::main(): option %s requires a backend name\n", argv[0]);
+                return 1;
+            }
+
+            comp.opt.expect_backend = argv[1];
+        } else if (strcmp(argv[0], "--expect-failure") == 0) {
+            comp.opt.expect_failure = true;
+            argv--;
+            argc++;
+        } else if (strcmp(argv[0], "--require-dmabuf") == 0) {
+            comp.opt.require_dmabuf = true;
+            argv--;
+            argc++;
+        } else {
+            wlm_log_error("test-compositor::main(): invalid option %s\n", argv[0]);
+            return 1;
+        }
+
+        argv += 2;
+        argc -= 2;
+    }
+
+    if (argc == 0) {
+        usage();
+        return 1;
+    }
+    comp.opt.command = argv;
+
+    if (comp.opt.require_dmabuf && access("/dev/dma_heap/system", R_OK) != 0) {
+        printf("skipping: /dev/dma_heap/system is not available for DMA-BUF allocation\n");
+        return EXIT_SKIP;
+    }
+
+    comp.pixels = malloc((size_t)comp.opt.width * comp.opt.height * sizeof (uint32_t));
+    if (comp.pixels == NULL) {
+        wlm_log_error("test-compositor::main(): failed to allocate scene\n");
+        return 1;
+    }
+    scene_init(&comp);
+
+    comp.running = true;
+    if (!init_server(&comp) || !spawn_client(&comp)) {
+        cleanup(&comp);
+        return 1;
+    }
+
+    while (comp.running) {
+        wl_display_flush_clients(comp.display);
+        if (wl_event_loop_dispatch(comp.loop, -1) == -1 && errno != EINTR) {
+            wlm_log_error("test-compositor::main(): event loop failed\n");
+            break;
+        }
+    }
+
+    bool success = check_results(&comp);
+    cleanup(&comp);
+    return success ? 0 : 1;
+}